@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "socd.h"
+
+// Per-sample cost of ResolveSocd() for every policy
+//   socd-bench [samples]
+
+#define DEFAULT_SAMPLES 100000000ULL
+#define STREAM_SIZE 4096
+
+static uint64_t _nowNs()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t samples = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_SAMPLES;
+    if (samples == 0)
+        samples = DEFAULT_SAMPLES;
+
+    InitSocdTables();
+
+    // Random raw masks, every combination of held directions shows up
+    static uint8_t stream[STREAM_SIZE];
+    uint32_t seed = 12345;
+    for (int i = 0; i < STREAM_SIZE; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        stream[i] = (uint8_t)(seed >> 28);
+    }
+
+    printf("%llu samples per policy\n", (unsigned long long)samples);
+
+    for (int policy = 0; policy < SOCD_POLICY_COUNT; policy++)
+    {
+        SocdState state;
+        InitSocdState(&state, (SocdPolicy)policy);
+
+        // Folded into the output so the loop can't be thrown away
+        uint32_t sum = 0;
+
+        uint64_t start = _nowNs();
+        for (uint64_t i = 0; i < samples; i++)
+            sum += ResolveSocd(&state, stream[i & (STREAM_SIZE - 1)]);
+        uint64_t elapsed = _nowNs() - start;
+
+        printf("  %-8s %6.2f ns/sample  (checksum %u)\n",
+               SocdPolicyName((SocdPolicy)policy), (double)elapsed / (double)samples, sum);
+    }
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "judge.h"
+
+// Every try at a pattern, kept for good in a directory of column files:
+//   mode.col     uint16  index into modes.txt, one mode name per line
+//   start.col    uint64  unix time of the first input, ns
+//   verdict.col  uint8   AttemptVerdict
+//   steps.col    uint8   inputs that were right
+//   cycle.col    uint32  first input to the last, us
+//   holds.col    uint16  x ATTEMPT_MAX_STEPS, how long each step was held
+//                        before the next input, ATTEMPT_HOLD_UNIT_NS units.
+//                        Steps past ATTEMPT_MAX_STEPS are counted in
+//                        steps.col but their holds aren't kept.
+// Row i is the i-th element of every file. Files are only ever appended
+// to, so a crash at worst leaves some files a row longer than others;
+// readers use the shortest and the writer cuts the rest back.
+//
+// Rows go in in the order they happened, so a time range is a binary
+// search on start.col and everything else is a straight scan of a few
+// byte wide columns.
+
+#define ATTEMPT_STORE_DEFAULT_DIR "attempts"
+#define ATTEMPT_MAX_STEPS 16
+#define ATTEMPT_MAX_MODES 65536
+// steps.col is a byte, longer attempts stop counting at UINT8_MAX
+#define ATTEMPT_STEP_LIMIT 256
+#define ATTEMPT_HOLD_UNIT_NS 100000ULL
+#define ATTEMPT_ANY_MODE -1
+
+// Percentiles are read off a histogram of this resolution, the last
+// bucket catches anything slower
+#define ATTEMPT_CYCLE_BUCKET_US 100
+#define ATTEMPT_CYCLE_BUCKETS 65536
+
+typedef enum {
+    ATTEMPT_DONE = 0,
+    ATTEMPT_MISSED
+} AttemptVerdict;
+
+typedef struct {
+    uint64_t start_ns;
+    uint32_t cycle_us;
+    uint16_t mode;
+    uint8_t verdict;
+    // For a miss, also the step that was missed
+    uint8_t steps;
+    uint16_t holds[ATTEMPT_MAX_STEPS];
+} Attempt;
+
+// Cuts judged inputs into attempts: from the first right input of a
+// pattern to the input that finishes it or misses
+typedef struct AttemptTracker {
+    Attempt current;
+    bool open;
+    uint64_t first_ns;
+    uint64_t last_ns;
+    uint64_t completions;
+
+    // Session clock to unix time
+    int64_t wall_offset_ns;
+} AttemptTracker;
+
+void InitAttemptTracker(AttemptTracker *, uint16_t mode, const GameState *, int64_t wall_offset_ns);
+
+// After every JudgeInput(), true with out filled when an attempt ended
+bool TrackAttempt(AttemptTracker *, JudgeResult, const GameState *, uint64_t timestamp_ns, Attempt *out);
+
+typedef struct AttemptWriter AttemptWriter;
+
+// Creates dir when it's missing and gives every mode in modes an id
+// there. The files are written by a background thread, NULL when they
+// can't be opened. Modes with a main path longer than ATTEMPT_MAX_STEPS
+// are reported, their later holds aren't kept.
+AttemptWriter *OpenAttemptWriter(const char *dir, const struct ModeRegistry *modes);
+// Id of the registry's mode at index
+uint16_t AttemptModeId(const AttemptWriter *, int index);
+// Only queues
+void StoreAttempt(AttemptWriter *, const Attempt *);
+void CloseAttemptWriter(AttemptWriter *);
+
+// Read only view of a whole store, every column mapped into memory
+typedef struct {
+    size_t count;
+
+    const uint16_t *mode;
+    const uint64_t *start;
+    const uint8_t *verdict;
+    const uint8_t *steps;
+    const uint32_t *cycle;
+    const uint16_t *holds;
+
+    char **mode_names;
+    int mode_count;
+
+    // Platform mapping handles, one per column
+    void *maps[6];
+    size_t sizes[6];
+    intptr_t mappings[6];
+} AttemptStore;
+
+bool OpenAttemptStore(AttemptStore *, const char *dir);
+void CloseAttemptStore(AttemptStore *);
+
+// mode id, or -1 for a name the store has never seen
+int FindAttemptMode(const AttemptStore *, const char *name);
+
+typedef struct {
+    int mode;           // ATTEMPT_ANY_MODE for all of them
+    uint64_t from_ns;   // unix time, inclusive
+    uint64_t to_ns;     // exclusive, 0 for no end
+} AttemptQuery;
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t attempts;
+    uint64_t done;
+} AccuracyBucket;
+
+// Attempts and finished ones in count buckets of bucket_ns each from
+// query->from_ns
+void QueryAccuracy(const AttemptStore *, const AttemptQuery *, uint64_t bucket_ns, AccuracyBucket *out, int count);
+
+// reached[k] attempts got an input in at step k, missed[k] of them got
+// it wrong. Returns how many had more than ATTEMPT_MAX_STEPS steps, so
+// had some of their holds cut off.
+uint64_t QueryStepMisses(const AttemptStore *, const AttemptQuery *, uint64_t reached[ATTEMPT_STEP_LIMIT], uint64_t missed[ATTEMPT_STEP_LIMIT]);
+
+// Cycle time of finished attempts at each p in [0, 1], upper edge of the
+// bucket it lands in. Returns how many were finished.
+uint64_t QueryCyclePercentiles(const AttemptStore *, const AttemptQuery *, const double *p, uint64_t *out_ns, int count);
+
+// Kernel the scans run on, "avx2", "sse2" or "scalar". Every query
+// filters rows with it; the step and cycle histograms are then filled
+// one matching row at a time.
+const char *AttemptScanKernel();
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "modes.h"
+#include "pattern.h"
+#include "recognizer.h"
+#include "recording.h"
+
+// Scores whole directories of recordings, see kbd-batch (batch_main.c).
+// An archive is laid out as <root>/<player>/.../*.kbdrec, recordings
+// straight under the root belong to player "-".
+
+#define BATCH_CYCLE_BUCKET_NS 1000000ULL
+// Last bucket catches every slower cycle
+#define BATCH_CYCLE_BUCKETS 2048
+
+typedef struct {
+    char *path;
+    int player;
+    uint64_t size;
+} BatchFile;
+
+typedef struct {
+    BatchFile *files;
+    size_t count;
+    size_t capacity;
+
+    char **players;
+    int player_count;
+    int player_capacity;
+
+    uint64_t bytes;
+} BatchArchive;
+
+// One player in one mode, summed over every recording. Rows are keyed by
+// the mode's pattern as well as its name, two recordings of a mode whose
+// pattern changed in between don't share one.
+typedef struct {
+    int player;
+    char mode_name[RECORDING_NAME_SIZE];
+
+    // Free practice counts techniques, nothing is hit or missed
+    bool practice;
+    // Pattern states, expected[] holds the input each one wants
+    int states;
+
+    uint64_t files;
+    uint64_t inputs;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t cycles;
+    uint64_t duration_ns;
+
+    // Misses by the pattern state they happened in, and the input that
+    // state wanted
+    uint64_t misses_at[PATTERN_MAX_STATES];
+    uint8_t expected[PATTERN_MAX_STATES];
+
+    // Time from one finished pattern to the next, in 1 ms buckets.
+    // Cycles broken by a miss aren't counted.
+    uint32_t cycle_hist[BATCH_CYCLE_BUCKETS];
+} BatchStats;
+
+typedef struct {
+    BatchStats *stats;
+    int count;
+    int capacity;
+} BatchTable;
+
+typedef struct BatchLanes BatchLanes;
+
+// Everything one worker thread touches, nothing is shared
+typedef struct {
+    BatchTable table;
+    Recognizer practice;
+    uint64_t inputs;
+    uint64_t failed;
+
+    // Recordings waiting in JudgeBatch lanes, one batch per registry mode.
+    // NULL when every recording is judged on its own.
+    BatchLanes *lanes;
+} BatchWorker;
+
+bool ScanBatchArchive(BatchArchive *, const char *root);
+void DestroyBatchArchive(BatchArchive *);
+
+// lanes false to judge every recording with ReplayInput(), one at a time
+bool InitBatchWorker(BatchWorker *, const ModeRegistry *, bool lanes);
+void DestroyBatchWorker(BatchWorker *);
+
+// Judges one recording against the mode named in its header, falling
+// back to the pattern stored in it. Returns the inputs read, 0 on error.
+// A recording of an unknown mode whose stored pattern can't be compiled
+// counts as failed, it's never taken for free practice.
+//
+// Recordings of a registry mode JudgeBatch can take are only read into a
+// lane here. They're judged alongside the next ones of that mode and are
+// in the table once FinishBatchWorker() has run. The rest, and lanes
+// whose counters would wrap, go through ReplayInput().
+uint64_t ScoreRecording(BatchWorker *, const ModeRegistry *, const BatchFile *);
+
+// Judges whatever is still waiting in a lane
+void FinishBatchWorker(BatchWorker *, const ModeRegistry *);
+
+void MergeBatchTable(BatchTable *into, const BatchTable *from);
+void DestroyBatchTable(BatchTable *);
+
+// p in [0, 1], upper edge of the bucket it lands in
+uint64_t CyclePercentileNs(const BatchStats *, double p);
+
+void PrintBatchTable(const BatchTable *, const BatchArchive *);
+
+// Judges every recording of a known mode again with JudgeBatch on each
+// kernel the CPU has, and checks the counts against ReplayInput().
+// Prints the throughput of each, false on any difference.
+bool VerifyBatchJudge(const BatchArchive *, const ModeRegistry *);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    GAME_CLOCK_REALTIME = 0,    // SDL_GetTicksNS(), what SDL stamps events with
+    GAME_CLOCK_MONOTONIC_RAW,   // hardware counter that NTP never slews
+    GAME_CLOCK_SIMULATED,       // only moves when told to, sleeping is free
+    GAME_CLOCK_COUNT
+} GameClockKind;
+
+// Everything that needs the time asks one of these instead of the OS, so a
+// run on a simulated clock is reproducible and never waits. The live clocks
+// can be shared between threads, the simulated one can't.
+typedef struct GameClock GameClock;
+struct GameClock {
+    GameClockKind kind;
+
+    uint64_t (*now)(GameClock *);
+    void (*sleep_until)(GameClock *, uint64_t deadline_ns);
+
+    // Simulated time, or where the raw counter started
+    uint64_t ns;
+};
+
+// Every clock starts at start_ns
+bool InitGameClock(GameClock *, GameClockKind, uint64_t start_ns);
+const char *GameClockName(GameClockKind);
+
+// Simulated clocks only, live clocks ignore it
+void AdvanceGameClock(GameClock *, uint64_t ns);
+
+static inline uint64_t ClockNow(GameClock *clock)
+{
+    return clock->now(clock);
+}
+
+static inline void ClockSleepUntil(GameClock *clock, uint64_t deadline_ns)
+{
+    clock->sleep_until(clock, deadline_ns);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL3/SDL.h>
+
+// Always on record of the last FLIGHT_RECORDER_SIZE things that happened:
+// inputs as the game drained them, the judge's verdicts and how long each
+// phase of every frame took. Written to disk when the trainer crashes,
+// exits on an error, or F12 is pressed, so a hitch or a crash leaves
+// something to look at.
+//
+// Recording is one atomic add and a 16 byte store into a fixed array, no
+// locks and no allocation, from any thread. The dump is plain write()
+// calls on memory that's already there, safe from a signal handler. A
+// record being written while it's dumped can come out torn.
+
+#define FLIGHT_RECORDER_SIZE 65536
+#define FLIGHT_RECORDER_DEFAULT_PATH "kbd-flight.kbdfr"
+#define FLIGHT_RECORDER_MAGIC "KBDF"
+#define FLIGHT_RECORDER_VERSION 1
+
+typedef enum {
+    FLIGHT_NONE = 0,
+    FLIGHT_INPUT,       // a direction, b buttons
+    FLIGHT_VERDICT,     // a JudgeResult
+    FLIGHT_PHASE,       // a FlightPhase, value nanoseconds it took
+    FLIGHT_KIND_COUNT
+} FlightRecordKind;
+
+typedef enum {
+    FLIGHT_PHASE_POLL = 0,  // input source poll
+    FLIGHT_PHASE_UPDATE,    // draining the ring through the game
+    FLIGHT_PHASE_RENDER,    // the whole of Render(), present included
+    FLIGHT_PHASE_PRESENT,   // SDL_RenderPresent() alone
+    FLIGHT_PHASE_FRAME,     // start of one frame to the start of the next
+    FLIGHT_PHASE_COUNT
+} FlightPhase;
+
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t value;
+    uint8_t kind;
+    uint8_t a;
+    uint16_t b;
+} FlightRecord;
+
+// Written at the front of a dump, records follow oldest first
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t count;
+    uint32_t reserved;
+} FlightDumpHeader;
+
+extern FlightRecord flight_records[FLIGHT_RECORDER_SIZE];
+extern SDL_AtomicInt flight_head;
+
+// Dumps to path on a crash or an exit that skips CloseFlightRecorder()
+void InitFlightRecorder(const char *path);
+// Clean shutdown, nothing is written
+void CloseFlightRecorder();
+
+// On demand, the F12 hotkey
+bool DumpFlightRecorder();
+
+// Prints a dump as text, with the slowest frame of every phase
+bool PrintFlightDump(const char *path);
+
+static inline void RecordFlight(FlightRecordKind kind, uint8_t a, uint16_t b, uint32_t value, uint64_t timestamp_ns)
+{
+    int slot = SDL_AddAtomicInt(&flight_head, 1) & (FLIGHT_RECORDER_SIZE - 1);
+    FlightRecord *rec = &flight_records[slot];
+    rec->timestamp_ns = timestamp_ns;
+    rec->value = value;
+    rec->kind = (uint8_t)kind;
+    rec->a = a;
+    rec->b = b;
+}
+
+static inline void RecordFlightPhase(FlightPhase phase, uint64_t start_ns, uint64_t end_ns)
+{
+    uint64_t took = end_ns > start_ns ? end_ns - start_ns : 0;
+    RecordFlight(FLIGHT_PHASE, (uint8_t)phase, 0, took > UINT32_MAX ? UINT32_MAX : (uint32_t)took, start_ns);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input.h"
+
+// The game reads the controller once a frame, not every time it changes.
+// A state that's gone again before the next read never happens in game,
+// like a 3 ms neutral between two backs, even though the trainer saw it.
+//
+// The sampler sits between the timestamped input stream and the judge
+// and only passes on what a 60 Hz game would read: states held over a
+// frame boundary, stamped with that boundary. Reads happen at phase_ns +
+// FRAMES_TO_NS(k) and see every input stamped at or before them. Only the
+// latest state can still be waiting to be read, so every input is O(1).
+
+// Sweeps use this many evenly spaced phases unless told otherwise
+#define FRAME_SAMPLER_DEFAULT_PHASES 16
+
+typedef struct {
+    uint64_t phase_ns;
+
+    // State the game read last, timestamped with when
+    InputEvent seen;
+
+    // Latest state if the game hasn't read it yet, and the read it's due at
+    bool has_pending;
+    InputEvent pending;
+    uint64_t pending_frame;
+
+    // Changes fed in, and how many of them the game never read
+    uint64_t transitions;
+    uint64_t dropped;
+} FrameSampler;
+
+// phase_ns is taken modulo a frame. Starts neutral with nothing held.
+void InitFrameSampler(FrameSampler *, uint64_t phase_ns);
+
+// Next input in time order, repeats of the latest state are ignored.
+// True when it shows the state before it was read, written to out with
+// the time of the read. When that state was overwritten before a read
+// instead, dropped goes up.
+bool SampleInput(FrameSampler *, const InputEvent *, InputEvent *out);
+
+// The waiting state once its read is before now_ns, UINT64_MAX at the
+// end of a stream
+bool FlushFrameSampler(FrameSampler *, uint64_t now_ns, InputEvent *out);
+
+// When the game reads the waiting state, has_pending only
+static inline uint64_t PendingReadTime(const FrameSampler *fs)
+{
+    return fs->phase_ns + FRAMES_TO_NS(fs->pending_frame);
+}
+
+// Phase of sweep step i of count, evenly spread over a frame
+uint64_t SweepPhase(int i, int count);
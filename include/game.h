@@ -1,20 +1,36 @@
 #pragma once
 
-#define GAME_MODE_COUNT 4
-
 #include <stdint.h>
 #include <stdbool.h>
+#include "clock.h"
+#include "frame_sampler.h"
 #include "input.h"
+#include "near_miss.h"
+#include "pattern.h"
+#include "recognizer.h"
+#include "recording.h"
+#include "timer_wheel.h"
 
 typedef struct {
     const char * mode_name;
 
+    // Notation the mode was compiled from, see pattern.h
+    const char *source;
+    PatternDfa *dfa;
+
+    // First written path through the pattern, stored in recordings
     GameDirection *pattern;
     int pattern_size;
+
+    // No pattern, every known technique is counted as it's done
+    bool free_practice;
 } GameMode;
 
-extern int selected_mode;
-GameMode gamemodes[GAME_MODE_COUNT];
+struct ModeRegistry;
+struct SessionLog;
+struct StatsJournal;
+struct AttemptWriter;
+struct AttemptTracker;
 
 typedef enum {
     NONE = 0,
@@ -22,8 +38,18 @@ typedef enum {
     FAIL
 } InputAccuracy;
 
+typedef enum {
+    TIMING_NONE = 0,    // nothing graded, no window or no step held yet
+    TIMING_JUST,
+    TIMING_EARLY,
+    TIMING_LATE,
+    // Held for less than a game frame, the game may never have seen it
+    TIMING_DROPPED,
+    TIMING_COUNT
+} TimingVerdict;
+
 typedef struct{
-    // current position in the pattern
+    // current DFA state, PATTERN_START until the first step lands
     int player_pos;
     
     uint64_t score;
@@ -33,24 +59,103 @@ typedef struct{
 
     InputAccuracy last_input_acc;
     GameDirection last_input;
+
+    // DFA state whose step is being held and since when, graded when the
+    // next step lands
+    int held_state;
+    uint64_t step_start_ns;
+    TimingVerdict last_timing;
     
     // Timing for miss pause
     uint64_t miss_time;
     bool in_miss_pause;
     
+    // Times the technique was finished since the game started
+    uint64_t completions;
+
     GameMode *current_mode;
     bool run_game;
 } GameState;
 
-GameState gamestate;
+// One player's game, menu to score. Sessions share nothing but the
+// (read only) modes they were started with, so any number can run at
+// once on different threads.
+typedef struct KbdSession {
+    GameState state;
+
+    const struct ModeRegistry *registry;
+    GameMode *modes;
+    int mode_count;
+    int selected_mode;
+
+    // Best score per mode, from the stats journal when there is one
+    uint64_t *highscores;
+    struct StatsJournal *stats;
+    uint64_t game_start_ns;
+
+    // Every attempt at the pattern goes into this store when set, see
+    // SetAttemptStore()
+    struct AttemptWriter *attempts;
+    struct AttemptTracker *attempt_tracker;
+
+    // Own copy of the registry's techniques, free practice mutates it
+    Recognizer practice;
+
+    ControllerState prev_input;
+
+    // What the latest miss was, main path only
+    NearMiss near_miss;
+
+    // Games only judge what the game itself would read once a frame when
+    // set, see SetFrameSampling()
+    bool sample_frames;
+    uint64_t frame_phase_ns;
+    FrameSampler sampler;
+
+    // Timed transitions on the session clock: the miss pause ending and
+    // the sampler's next frame read
+    TimerWheel timers;
+    Timer miss_pause;
+    Timer frame_read;
+
+    // Everything the judge did this game, for rewinding, see session_log.h
+    struct SessionLog *log;
+
+    // Latest state drained from the input ring, held between events
+    ControllerState held_input;
+
+    // The game never asks the OS for the time, only this clock and the
+    // timestamps on its inputs
+    GameClock *clock;
+
+    // Every game is recorded into this directory when set, see SetRecording()
+    const char *recording_dir;
+    RecordingClock recording_clock;
+    RecordingWriter *recorder;
+} KbdSession;
+
+// modes has to outlive the session
+bool InitGame(KbdSession *, GameClock *, const struct ModeRegistry *modes);
+void DestroyGame(KbdSession *);
+void SetRecording(KbdSession *, const char *dir, RecordingClock);
+// High scores carry over from the journal, every game finished goes into
+// it. The journal has to outlive the session.
+void SetStatsJournal(KbdSession *, struct StatsJournal *);
+// The writer has to outlive the session
+bool SetAttemptStore(KbdSession *, struct AttemptWriter *);
+// Reads at phase_ns + FRAMES_TO_NS(k) on the session's clock
+void SetFrameSampling(KbdSession *, bool enabled, uint64_t phase_ns);
+void _startGame(KbdSession *);
 
-void InitGame();
-void DestroyGame();
-void _startGame();
+void Update(KbdSession *, ControllerState *);
+void UpdateFromRing(KbdSession *, struct InputRing *);
 
-void Update(ControllerState *);
+void _updateMenu(KbdSession *, ControllerState *);
+void _updateGame(KbdSession *, ControllerState *);
 
-void _updateMenu(ControllerState *);
-void _updateGame(ControllerState *);
+// The game as it was ns_back ago, as far back as the log goes. Not for
+// free practice.
+bool RewindGame(KbdSession *, uint64_t ns_back, GameState *);
 
-void _initGameModes();
\ No newline at end of file
+// Techniques counted in free practice, shared with headless replays
+Recognizer *GetPracticeRecognizer(KbdSession *);
\ No newline at end of file
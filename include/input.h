@@ -1,6 +1,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "socd.h"
+#include "stick.h"
+
+// The games being trained sample input at 60 Hz
+#define GAME_FRAME_RATE 60
+#define FRAMES_TO_NS(frames) ((uint64_t)(frames) * 1000000000ULL / GAME_FRAME_RATE)
 
 typedef enum {
     NEUTRAL = 0,
@@ -20,8 +28,110 @@ typedef struct {
     GameDirection direction;
     bool select_pressed;
     bool back_pressed;
+
+    // When this state was sampled, on the input clock (see SetInputClock())
+    uint64_t timestamp_ns;
 } ControllerState;
 
+// Button bits packed into InputEvent.buttons
+#define INPUT_BUTTON_SELECT 0x1
+#define INPUT_BUTTON_BACK   0x2
+
+// Compact record of a single input transition
+typedef struct {
+    uint64_t timestamp_ns;
+    uint8_t direction;
+    uint8_t buttons;
+} InputEvent;
+
+static inline InputEvent ControllerToEvent(const ControllerState *cs)
+{
+    InputEvent ev = {0};
+    ev.timestamp_ns = cs->timestamp_ns;
+    ev.direction = (uint8_t)cs->direction;
+    ev.buttons = (cs->select_pressed ? INPUT_BUTTON_SELECT : 0) | (cs->back_pressed ? INPUT_BUTTON_BACK : 0);
+    return ev;
+}
+
+static inline ControllerState EventToController(const InputEvent *ev)
+{
+    ControllerState cs = {0};
+    cs.direction = (GameDirection)ev->direction;
+    cs.select_pressed = (ev->buttons & INPUT_BUTTON_SELECT) != 0;
+    cs.back_pressed = (ev->buttons & INPUT_BUTTON_BACK) != 0;
+    cs.timestamp_ns = ev->timestamp_ns;
+    return cs;
+}
+
+typedef enum {
+    // Sample device state once per frame from the frame loop
+    INPUT_BACKEND_POLL = 0,
+    // Sample gamepads on a dedicated high-rate thread. The keyboard state
+    // it reads only changes when the frame loop pumps events, so key
+    // presses still land on the frame; INPUT_BACKEND_EVENTS keeps theirs.
+    INPUT_BACKEND_THREAD,
+    // Rebuild state from SDL input events, keeping their timestamps
+    INPUT_BACKEND_EVENTS,
+    // Read /dev/input/event* directly, kernel timestamps (Linux only)
+    INPUT_BACKEND_EVDEV,
+    // Replay a timed script, no device needed
+    INPUT_BACKEND_SCRIPT
+} InputBackend;
+
+// Kept opaque so this header stays usable without SDL
+union SDL_Event;
+struct InputRing;
+struct SDL_Gamepad;
+struct GameClock;
+
+// Slot 0 is always the keyboard, gamepads fill the rest as they connect
+#define MAX_INPUT_DEVICES 8
+
+// How the states of several live devices combine into one
+typedef enum {
+    // Every held direction and button from every device, then SOCD
+    DEVICE_MERGE_ANY = 0,
+    // The device that changed most recently drives alone
+    DEVICE_MERGE_LATEST,
+    // The first device in slot order that isn't idle drives alone
+    DEVICE_MERGE_PRIORITY,
+    DEVICE_MERGE_COUNT
+} DeviceMergeRule;
+
+typedef struct {
+    // 0 for the keyboard
+    uint32_t id;
+    struct SDL_Gamepad *pad;
+
+    // Raw 4 bit mask before merging and SOCD
+    short dpad;
+    // Event backend only, every mapped button currently down
+    uint16_t buttons_held;
+    // Event backend only, last reported left stick position
+    int16_t stick_x;
+    int16_t stick_y;
+    ControllerState state;
+} InputDevice;
+
 bool InitController();
+void SetInputBackend(InputBackend);
+InputBackend GetInputBackend();
+
 ControllerState *PollController();
-void _parseDirection();
\ No newline at end of file
+ControllerState *SampleController();
+bool HandleInputEvent(const union SDL_Event *, struct InputRing *);
+void SetSocdPolicy(SocdPolicy);
+void SetDeviceMergeRule(DeviceMergeRule);
+bool SetStickGate(StickGateShape, float deadzone);
+
+// Stamp every sample and event on this clock, SDL_GetTicksNS() when unset
+void SetInputClock(struct GameClock *);
+uint64_t InputClockNow();
+const char *DeviceMergeRuleName(DeviceMergeRule);
+
+const InputDevice *GetInputDevices(int *count);
+
+void _parseDirection();
+void _resolveSOCD();
+
+GameDirection DirectionFromMask(short mask);
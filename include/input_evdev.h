@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input.h"
+
+struct InputRing;
+
+#define EVDEV_MAX_DEVICES 8
+
+// Held state of one evdev device, resolved into an InputEvent on every
+// SYN_REPORT so a batch of simultaneous changes lands as one transition
+typedef struct {
+    // One bit per mapped key code, see _evdevKeyBit()
+    uint32_t keys_held;
+    // Same 4 bit layout as dpad_state
+    short hat_state;
+
+    SocdState socd;
+
+    // Added to kernel timestamps to move them onto the input clock
+    int64_t clock_offset_ns;
+
+    InputEvent last;
+    bool has_last;
+} EvdevDecoder;
+
+bool OpenEvdevDevices(SocdPolicy);
+void CloseEvdevDevices();
+
+// Read whatever is pending on every open device, without blocking
+void PollEvdev(struct InputRing *);
+
+void InitEvdevDecoder(EvdevDecoder *, int64_t clock_offset_ns, SocdPolicy);
+
+// Decode a raw stream of struct input_event, e.g. read() output or a
+// recorded capture. Returns the number of transitions pushed to the ring.
+// Any trailing partial record is ignored.
+int DecodeEvdevBytes(EvdevDecoder *, const void *bytes, size_t len, struct InputRing *);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "input.h"
+#include "spsc_ring.h"
+
+// Must be a power of two, see InitSpscRing()
+#define INPUT_RING_CAPACITY 4096
+
+// SpscRing of timestamped input events with the storage built in
+typedef struct InputRing {
+    SpscRing ring;
+    InputEvent events[INPUT_RING_CAPACITY];
+} InputRing;
+
+void InitInputRing(InputRing *);
+
+bool PushInputEvent(InputRing *, const InputEvent *);
+bool PopInputEvent(InputRing *, InputEvent *);
+bool InputRingFull(InputRing *);
+int InputRingDropped(InputRing *);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input.h"
+#include "socd.h"
+
+struct InputRing;
+
+// Anything that can produce timestamped input. The frame loop calls poll()
+// once per frame with the current time and drains the ring afterwards, so
+// the game never needs to know where input came from.
+typedef struct InputSource {
+    const char *name;
+
+    // Push every transition that happened up to now_ns into the ring.
+    // Returns false once the source has nothing more to give.
+    bool (*poll)(struct InputSource *, uint64_t now_ns, struct InputRing *);
+    void (*close)(struct InputSource *);
+
+    void *data;
+} InputSource;
+
+// Live sources, see InputBackend
+bool OpenInputSource(InputSource *, InputBackend, SocdPolicy);
+
+// Scripted input, one transition per line:
+//
+//     # P1 KBD, 4 frames per step
+//     0f   b
+//     +4f  n
+//     +4f  4
+//     +4f  1 select
+//
+// Times are absolute or +relative to the previous line, in frames (f,
+// the default), ms, us or ns. Directions use numpad notation or the short
+// names from notation.h. Trailing words select/back hold those buttons.
+bool OpenScriptSource(InputSource *, const char *path);
+bool OpenScriptSourceFromMemory(InputSource *, const char *text, size_t len);
+
+// Parse a script into events with timestamps relative to its start.
+// Caller frees *events.
+bool ParseInputScript(const char *text, size_t len, InputEvent **events, int *count);
+
+void CloseInputSource(InputSource *);
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "input_ring.h"
+
+#define INPUT_THREAD_DEFAULT_HZ 1000
+
+// Sample the controller on a dedicated thread at the given rate and push
+// every change into a ring that the frame loop drains. Only gamepads are
+// read between frames, SDL updates the keyboard state once a frame.
+bool StartInputThread(int hz);
+void StopInputThread();
+bool InputThreadRunning();
+
+InputRing *GetInputRing();
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include "game.h"
+
+// How long a miss freezes the game before the score resets
+#define MISS_PAUSE_NS 2000000000ULL
+
+// A hit scores full points unless the step before it was held outside its
+// window, dropped steps score nothing
+#define JUDGE_POINTS 50
+#define JUDGE_POINTS_OFF 20
+
+typedef enum {
+    JUDGE_NONE = 0,     // no change, or a wrong input before the pattern started
+    JUDGE_HIT,
+    JUDGE_MISS,
+    JUDGE_PAUSED,       // swallowed by the miss pause
+    JUDGE_QUIT          // back pressed, the caller leaves the game
+} JudgeResult;
+
+// Judge one input against a game in progress. Touches nothing but the two
+// states it is handed and reads time only from cs->timestamp_ns, so the same
+// input stream always scores the same whether it is played live or replayed.
+// prev is the last direction seen by the judge.
+// With step windows the hold of the step before each hit is graded into
+// last_timing, still O(1) per input.
+JudgeResult JudgeInput(GameState *, GameDirection *prev, const ControllerState *cs);
+
+// Resets the pattern and score once the pause is over. JudgeInput() does it
+// itself when the next input comes after the pause, a live game schedules
+// it for miss_time + MISS_PAUSE_NS so it shows without one.
+void EndMissPause(GameState *);
+
+// Hold durations are rounded to the nearest game frame before comparing
+TimingVerdict GradeHold(const StepWindow *, uint64_t held_ns);
+
+void ResetGameState(GameState *, GameMode *, uint64_t highscore);
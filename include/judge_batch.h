@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "judge.h"
+#include "pattern.h"
+#include "replay.h"
+
+// Many replays of the same mode judged in lockstep, one input per lane
+// per step. Every field of every lane lives in its own array, so SSE2
+// and AVX2 advance 4 or 8 sessions with the same handful of compares
+// and table gathers that JudgeInput() does for one.
+//
+// Matches JudgeInput()/ReplayInput() exactly, miss pause included, for
+// the counts in ReplaySummary. Display only state (last_input,
+// last_input_acc, last_timing) isn't kept.
+//
+// Times are split into 32 bit halves. Differences only ever need to be
+// compared against the miss pause and the hold windows, all well under
+// 2^32 ns, so longer ones are saturated instead of carried. Modes with
+// windows past 256 frames won't fit, InitJudgeBatch() refuses them.
+// Counters are 32 bit, a lane is flagged in overflow once its score
+// gets close to wrapping and should be replayed with ReplayInput().
+
+// Lane counts are rounded up to this
+#define JUDGE_BATCH_ALIGN 8
+
+// Input values besides the direction
+#define JUDGE_BATCH_BACK 0x80
+// Lane has nothing this step
+#define JUDGE_BATCH_IDLE 0xFF
+
+// held state of a lane holding nothing graded, states without a window
+// are never held
+#define JUDGE_BATCH_NO_STATE PATTERN_MAX_STATES
+
+// Transition table row stride, the columns padded to a power of two
+#define JUDGE_BATCH_COLUMNS 16
+
+typedef enum {
+    JUDGE_KERNEL_SCALAR = 0,
+    JUDGE_KERNEL_SSE2,
+    JUDGE_KERNEL_AVX2,
+    JUDGE_KERNEL_COUNT
+} JudgeKernel;
+
+typedef struct {
+    int lanes;
+    JudgeKernel kernel;
+
+    // What every (state, direction) does, see _buildTransitions()
+    uint32_t transitions[PATTERN_MAX_STATES * JUDGE_BATCH_COLUMNS];
+
+    // Hold grading by held state, in ns. Anything under a frame is
+    // dropped whatever the window.
+    uint32_t drop_ns;
+    uint32_t early_ns[PATTERN_MAX_STATES + 1];
+    uint32_t late_ns[PATTERN_MAX_STATES + 1];
+
+    // Lane state, masks are 0 or all ones
+    uint32_t *pos;
+    uint32_t *held;
+    uint32_t *prev;
+    uint32_t *pausing;
+    uint32_t *quit;
+    uint32_t *step_lo;
+    uint32_t *step_hi;
+    uint32_t *miss_lo;
+    uint32_t *miss_hi;
+
+    // Lane counts, as in ReplaySummary
+    uint32_t *inputs;
+    uint32_t *hits;
+    uint32_t *misses;
+    uint32_t *paused;
+    uint32_t *resets;
+    uint32_t *completions;
+    uint32_t *timing[TIMING_COUNT];
+    uint32_t *score;
+    uint32_t *highscore;
+    uint32_t *overflow;
+
+    uint32_t *block;
+} JudgeBatch;
+
+// Picks the widest kernel the CPU has
+bool InitJudgeBatch(JudgeBatch *, const GameMode *, int lanes);
+void DestroyJudgeBatch(JudgeBatch *);
+
+// Back to a fresh game on every lane, like InitReplay() with no high score
+void ResetJudgeBatch(JudgeBatch *);
+
+// Just the one, so a lane that ran out can take the next replay while
+// the rest carry on
+void ResetJudgeLane(JudgeBatch *, int lane);
+
+// False if this build or CPU can't run it
+bool SetJudgeKernel(JudgeBatch *, JudgeKernel);
+const char *JudgeKernelName(JudgeKernel);
+
+// One input per lane: inputs[lane] is the direction, | JUDGE_BATCH_BACK
+// with back held, or JUDGE_BATCH_IDLE. Timestamps in halves.
+void JudgeBatchStep(JudgeBatch *, const uint8_t *inputs, const uint32_t *ts_lo, const uint32_t *ts_hi);
+
+static inline uint8_t JudgeBatchInput(const InputEvent *ev)
+{
+    return (uint8_t)(ev->direction | ((ev->buttons & INPUT_BUTTON_BACK) ? JUDGE_BATCH_BACK : 0));
+}
+
+// Everything but duration_ns, which the lanes don't track
+void JudgeBatchSummary(const JudgeBatch *, int lane, ReplaySummary *);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "recognizer.h"
+
+#define MODES_DEFAULT_PATH "assets/modes.txt"
+
+// Every mode, its compiled pattern and name, plus the free practice
+// techniques, carved out of one block sized up front. Nothing in here
+// is freed on its own, and nothing changes after loading, so sessions
+// on any thread can share one.
+typedef struct ModeRegistry {
+    GameMode *modes;
+    int count;
+
+    // Built from [techniques], NULL when there are none
+    Recognizer *practice;
+
+    char *arena;
+    size_t arena_size;
+    size_t arena_used;
+} ModeRegistry;
+
+// Lines are "name = pattern" (see pattern.h) under a section:
+//   [modes]                as written
+//   [mirrored modes]       "P1 name" as written plus "P2 name" with
+//                          forward and back swapped
+//   [techniques]           plain directions counted in free practice
+//   [mirrored techniques]
+// Bad lines are reported and skipped. A Free Practice mode is added last
+// when there are techniques.
+//
+// Limits: any number of modes, each with at most PATTERN_MAX_STATES - 1
+// steps on its main path and a name under RECORDING_NAME_SIZE to be
+// recorded. At most RECOGNIZER_MAX_TECHNIQUES techniques, one bit each in
+// the recognizer's match mask; a mirrored line counts twice and the rest
+// are reported and skipped.
+bool LoadModeRegistry(ModeRegistry *, const char *path);
+bool LoadModeRegistryFromMemory(ModeRegistry *, const char *text, size_t len, const char *origin);
+void DestroyModeRegistry(ModeRegistry *);
+
+// path NULL for MODES_DEFAULT_PATH. Falls back to the built in modes
+// when the file is missing or has nothing usable.
+bool LoadGameModes(ModeRegistry *, const char *path);
+
+// By index or exact name, -1 if there's no such mode
+int FindGameMode(const ModeRegistry *, const char *key);
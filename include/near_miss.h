@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input.h"
+#include "pattern.h"
+
+// Works out what a miss actually was from the inputs around it. The
+// mode's main path is matched against the stream of direction changes
+// with bit-parallel Shift-And, one bit per step, Wu-Manber style: next
+// to the exact match there's a vector per kind of mistake allowing
+// exactly one edit of that kind. An input is a few shifts and masks per
+// vector, with every step and every place an attempt could have started
+// in play at once.
+//
+// Only the exact match runs between misses. A miss seeds the rest from
+// it: the attempt up to the miss is kept and the inputs after it are
+// matched with up to k edits. The missed input alone often can't tell
+// the kinds apart (f d for f n d df is a skipped neutral until n df comes
+// after it), so the verdict waits until one kind explains the whole
+// technique or the player has had the inputs to finish it. Alternatives
+// off the main path aren't matched.
+
+#define NEAR_MISS_MAX_STEPS 64
+
+// Plain Wu-Manber with up to this many mixed edits, for misses no single
+// kind explains
+#define NEAR_MISS_MAX_ERRORS 2
+
+typedef enum {
+    MISS_UNCLEAR = 0,       // more than one mistake, or nowhere near the pattern
+    MISS_SKIPPED_NEUTRAL,   // b db for b n b db
+    MISS_EXTRA_INPUT,       // b n d b db, or b n d n b db
+    MISS_WRONG_DIAGONAL,    // d or df for db, or rolled into db a step early
+    MISS_SWAPPED_ORDER,     // f d n df for f n d df
+    MISS_KIND_COUNT
+} MissKind;
+
+typedef struct {
+    MissKind kind;
+    // Step of the main path the player was on when it went wrong
+    int step;
+    // Fewest edits that explain a whole technique around the miss,
+    // NEAR_MISS_MAX_ERRORS + 1 if even that many don't
+    int errors;
+} MissDiagnosis;
+
+typedef struct {
+    int length;
+
+    // Bit i for step i of the main path
+    uint64_t at[PATTERN_COLUMNS];       // step is this direction
+    uint64_t next_at[PATTERN_COLUMNS];  // the step after it is
+    uint64_t near[PATTERN_COLUMNS];     // step is a diagonal off from this direction
+    uint64_t rolled;                    // step and the next are a diagonal apart
+    uint64_t neutral;                   // n steps
+    uint64_t merged;                    // n between two of the same direction,
+                                        // skipping it skips both
+    uint64_t end;                       // the final step
+
+    // Prefixes matched up to the latest input, bit i for steps 0..i
+    uint64_t exact;
+    GameDirection prev;
+
+    // Miss being worked out. errors[j] allows j edits of any kind after
+    // the attempt so far, kinds[] one edit of that kind.
+    bool pending;
+    int step;
+    int waited;
+    uint64_t errors[NEAR_MISS_MAX_ERRORS + 1];
+    uint64_t kinds[MISS_KIND_COUNT];
+    // Prefixes the missed input jumped one step ahead of
+    uint64_t swap;
+    // How far each kind got, and the fewest edits that finished the
+    // technique
+    int reach[MISS_KIND_COUNT];
+    int explained;
+
+    // Set when last is about the latest miss
+    bool diagnosed;
+    MissDiagnosis last;
+    uint64_t counts[MISS_KIND_COUNT];
+} NearMiss;
+
+// pattern is a mode's main path (GameMode.pattern), nothing is ever
+// diagnosed with length 0
+void InitNearMiss(NearMiss *, const GameDirection *pattern, int length);
+
+// Every input, missed set when the judge called it a miss. Repeats of the
+// previous direction are ignored. True when a miss was just diagnosed
+// into last.
+bool FeedNearMiss(NearMiss *, GameDirection, bool missed);
+
+// Settles a miss still being worked out, at the end of a game
+bool FinishNearMiss(NearMiss *);
+
+const char *MissKindName(MissKind);
+
+void PrintNearMissStats(const NearMiss *);
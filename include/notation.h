@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "input.h"
+
+// Short names (n, b, db...) for every direction, UNKNOWN included
+extern const char *direction_names[UNKNOWN + 1];
+
+// Accepts numpad notation (1-9, 5 is neutral, P1 side) or the short names
+bool ParseDirection(const char *token, size_t len, GameDirection *out);
+
+const char *DirectionName(GameDirection);
+
+// The same direction from the other side of the screen
+GameDirection MirrorDirection(GameDirection);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input.h"
+
+// Pattern notation, compiled once into a DFA so judging an input is a
+// single table lookup however involved the technique is:
+//
+//   b n b db        short names or numpad (4 5 4 1, or 4541), commas optional
+//   .               any direction
+//   [n uf f]        any of these
+//   !b  ![b ub db]  anything but these
+//   (x | y z)       alternatives
+//   x?  x*  x+      optional, any number, at least one
+//   x{2}  x{1,3}    repeat exactly, or between
+//   x:1-3  x:2      hold for 1 to 3 frames, or exactly 2. On a group it
+//                   applies to every step inside that doesn't have its own
+//
+// e.g. electric "f n d df:1", sidestep cancel "(u|d) n (f|b)"
+
+// One column per GameDirection, UNKNOWN and DISCONNECTED always break
+#define PATTERN_COLUMNS (DISCONNECTED + 1)
+#define PATTERN_MAX_STATES 64
+#define PATTERN_MAX_POSITIONS 128
+
+// Nothing matched yet, never re-entered once left
+#define PATTERN_START 0
+#define PATTERN_DEAD 0xFF
+
+// How long a step may be held before moving on, in 60 Hz game frames.
+// max_frames 0 means the hold isn't graded.
+typedef struct {
+    uint16_t min_frames;
+    uint16_t max_frames;
+} StepWindow;
+
+typedef struct {
+    int state_count;
+
+    uint8_t next[PATTERN_MAX_STATES][PATTERN_COLUMNS];
+
+    // The technique is complete, final states can't be extended further
+    bool accepting[PATTERN_MAX_STATES];
+    bool final[PATTERN_MAX_STATES];
+
+    // What to show as the next input, the first step on the shortest way
+    // to finishing
+    uint8_t hint[PATTERN_MAX_STATES];
+
+    // Allowed hold for the input that entered the state
+    StepWindow window[PATTERN_MAX_STATES];
+} PatternDfa;
+
+// Prints what's wrong and returns false on a bad pattern
+bool CompilePattern(const char *source, PatternDfa *);
+
+// Same technique from the other side, forward and back swapped
+void MirrorPattern(const PatternDfa *, PatternDfa *out);
+
+// Follows the hints from the start to the first accepting state, returns
+// the number of steps written to path
+int PatternMainPath(const PatternDfa *, GameDirection *path, int max);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input.h"
+#include "pattern.h"
+
+// Spots every registered technique in one continuous stream of direction
+// changes. The techniques are merged into an Aho-Corasick automaton with
+// the failure links folded into a dense table, so an input costs one
+// lookup however many techniques there are or how they overlap.
+
+#define RECOGNIZER_MAX_TECHNIQUES 32
+#define RECOGNIZER_MAX_NODES 256
+#define RECOGNIZER_ROOT 0
+
+typedef struct {
+    const char *name;
+    uint64_t count;
+
+    // When the first and the latest one finished
+    uint64_t first_ns;
+    uint64_t last_ns;
+} TechniqueStats;
+
+typedef struct {
+    int node_count;
+    uint16_t next[RECOGNIZER_MAX_NODES][PATTERN_COLUMNS];
+    // Bit per technique that ends at this node, suffixes included
+    uint32_t matches[RECOGNIZER_MAX_NODES];
+    // Building only, see BuildRecognizer()
+    uint16_t fail[RECOGNIZER_MAX_NODES];
+
+    int technique_count;
+    TechniqueStats techniques[RECOGNIZER_MAX_TECHNIQUES];
+
+    int node;
+    GameDirection prev;
+    uint64_t inputs;
+    uint64_t start_ns;
+    // Technique finished by the most recent input, -1 before any
+    int last_technique;
+} Recognizer;
+
+void InitRecognizer(Recognizer *);
+
+// sequence is plain directions, numpad or short names ("b n b db", "4541").
+// Add every technique, then build once.
+bool AddTechnique(Recognizer *, const char *name, const char *sequence);
+void BuildRecognizer(Recognizer *);
+
+// Clears counts and the stream position, keeps the techniques
+void ResetRecognizer(Recognizer *);
+
+// Repeats of the previous direction are ignored. Returns a bit for every
+// technique that just finished.
+uint32_t FeedRecognizer(Recognizer *, GameDirection, uint64_t timestamp_ns);
+
+uint64_t RecognizedTotal(const Recognizer *);
+
+// Per second, from the first to the latest one of that technique
+double TechniqueRate(const Recognizer *, int technique);
+
+void PrintRecognizerStats(const Recognizer *);
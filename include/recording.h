@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "input.h"
+#include "pattern.h"
+
+#define RECORDING_MAGIC "KBDR"
+#define RECORDING_VERSION 1
+#define RECORDING_EXTENSION ".kbdrec"
+
+#define RECORDING_NAME_SIZE 64
+// Any main path a compiled mode can have fits, see PatternMainPath()
+#define RECORDING_MAX_PATTERN PATTERN_MAX_STATES
+
+// direction value of a record that only carries time, used when the gap
+// between two inputs doesn't fit in delta_ns
+#define RECORD_GAP 0xFF
+
+// Where timestamps in the recording came from
+typedef enum {
+    RECORDING_CLOCK_SDL = 0,
+    RECORDING_CLOCK_EVDEV,
+    RECORDING_CLOCK_SIMULATED,
+    RECORDING_CLOCK_MONOTONIC_RAW
+} RecordingClock;
+
+// Fixed size, written once at the start of the file. record_count is
+// patched in when the recording is closed cleanly, readers fall back to
+// the file size if it's 0.
+//
+// mode is the registry index at the time, which a changed mode file
+// shifts around. Anything that looks a mode up goes by mode_name.
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;
+
+    uint8_t clock_source;
+    uint8_t reserved;
+    uint16_t mode;
+    uint16_t pattern_size;
+    uint16_t reserved2;
+    char mode_name[RECORDING_NAME_SIZE];
+    uint8_t pattern[RECORDING_MAX_PATTERN];
+
+    uint64_t start_ns;
+    uint64_t record_count;
+} RecordingHeader;
+
+// One input transition, 8 bytes so the record array stays aligned
+typedef struct {
+    uint32_t delta_ns;
+    uint8_t direction;
+    uint8_t buttons;
+    uint16_t reserved;
+} RecordedInput;
+
+typedef struct RecordingWriter RecordingWriter;
+
+// The file is written by a background thread, RecordInput() only queues.
+// When the queue is full the input is dropped and counted, the frame
+// thread never waits on the disk. dfa is the pattern the game judges
+// with, for the index next to the recording; NULL for the one in header.
+RecordingWriter *OpenRecordingWriter(const char *path, const RecordingHeader *, const PatternDfa *dfa);
+void RecordInput(RecordingWriter *, const InputEvent *);
+void CloseRecordingWriter(RecordingWriter *);
+
+// False when the pattern or mode name doesn't fit, nothing should be
+// recorded then rather than a file that replays a different pattern
+bool InitRecordingHeader(RecordingHeader *, RecordingClock, int mode, const char *mode_name,
+                         const GameDirection *pattern, int pattern_size, uint64_t start_ns);
+
+// Read only view of a whole recording mapped into memory
+typedef struct {
+    void *base;
+    size_t size;
+
+    // Points into the file
+    const RecordingHeader *header;
+    const RecordedInput *records;
+    uint64_t record_count;
+
+    // Platform mapping handles
+    intptr_t file;
+    intptr_t mapping;
+} RecordingReader;
+
+typedef struct {
+    const RecordedInput *next;
+    const RecordedInput *end;
+    uint64_t timestamp_ns;
+} RecordingIter;
+
+bool OpenRecordingReader(RecordingReader *, const char *path);
+void CloseRecordingReader(RecordingReader *);
+
+void BeginRecordingIter(const RecordingReader *, RecordingIter *);
+// Skips gap records, returns false at the end. A direction no
+// GameDirection has comes out as UNKNOWN.
+bool NextRecordedInput(RecordingIter *, InputEvent *);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "recording.h"
+#include "replay.h"
+
+// Random access into long recordings. Next to every recording sits an
+// index file with a keyframe every RECORDING_INDEX_INTERVAL inputs: the
+// time, the file offset of the next record and the game as a replay in
+// the recorded mode had it at that point. Seeking is a binary search for
+// the last keyframe before the time, then at most an interval of inputs
+// through ReplayInput().
+//
+// The recording's writer thread builds it as it goes, judging each input
+// it writes with the pattern the game judged it with, so there's no
+// second pass and seeking lands on the verdicts the player saw. Keyframes
+// are flushed as they're written, a crash leaves them usable.
+
+#define RECORDING_INDEX_MAGIC "KBDI"
+#define RECORDING_INDEX_VERSION 2
+#define RECORDING_INDEX_EXTENSION ".kbdidx"
+#define RECORDING_INDEX_INTERVAL 1024
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t keyframe_size;
+    uint32_t interval;
+    uint32_t reserved;
+
+    // Copied from the recording, an index only matches its own
+    uint64_t start_ns;
+
+    // Of the compiled pattern the keyframes were judged with. A mode with
+    // alternatives judges differently from the main path in the
+    // recording's header, keyframes only hold for the same one.
+    uint64_t pattern_hash;
+} RecordingIndexHeader;
+
+// The parts of GameState and Replay a replay needs to carry on, in fixed
+// width fields
+typedef struct {
+    uint64_t timestamp_ns;
+    uint64_t offset;
+    uint64_t inputs;
+
+    uint64_t score;
+    uint64_t highscore;
+    uint64_t completions;
+    uint64_t miss_time;
+    uint64_t step_start_ns;
+
+    // The rest of ReplaySummary
+    uint64_t first_ns;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t paused;
+    uint64_t resets;
+    uint64_t timing[TIMING_COUNT];
+
+    int16_t player_pos;
+    int16_t held_state;
+    uint8_t prev;
+    uint8_t curr_input;
+    uint8_t last_input;
+    uint8_t last_input_acc;
+    uint8_t last_timing;
+    uint8_t in_miss_pause;
+    uint8_t quit;
+    uint8_t reserved;
+} RecordingKeyframe;
+
+typedef struct RecordingIndexWriter RecordingIndexWriter;
+
+// dfa is what the game judges with, NULL for the pattern in the header.
+// NULL when the recording has no pattern to judge, or the file can't be
+// written. Recording goes on without an index either way.
+RecordingIndexWriter *OpenRecordingIndexWriter(const char *recording_path, const RecordingHeader *, const PatternDfa *dfa);
+
+// Every input right after it's encoded, offset is where the next record
+// will go
+void IndexRecordedInput(RecordingIndexWriter *, const InputEvent *, uint64_t offset);
+void CloseRecordingIndexWriter(RecordingIndexWriter *);
+
+typedef struct {
+    RecordingKeyframe *keyframes;
+    int count;
+} RecordingIndex;
+
+// Keyframes past the end of the recording are left out. An index that's
+// missing, doesn't match the recording or was judged with a different
+// pattern than mode's loads empty, seeking then starts from the top.
+bool LoadRecordingIndex(RecordingIndex *, const char *recording_path, const RecordingReader *, const GameMode *);
+void FreeRecordingIndex(RecordingIndex *);
+
+// The game right after the last input at or before time_ns, summary
+// included. mode has to be the one the index was loaded for. Returns how
+// many inputs had to be judged to get there.
+uint64_t SeekRecording(const RecordingReader *, const RecordingIndex *, GameMode *, uint64_t time_ns, Replay *);
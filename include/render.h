@@ -37,12 +37,12 @@ static const char * _fontAsset = "assets/scorefont.ttf";
 
 bool InitTextures(SDL_Renderer *);
 
-bool InitMenuTextures(SDL_Renderer *);
+bool InitMenuTextures(SDL_Renderer *, KbdSession *);
 void DestroyMenuTextures();
 
-void Render(SDL_Renderer *);
-void _renderMenu(SDL_Renderer *);
-void _renderGame(SDL_Renderer *);
+void Render(SDL_Renderer *, KbdSession *);
+void _renderMenu(SDL_Renderer *, KbdSession *);
+void _renderGame(SDL_Renderer *, KbdSession *);
 void _playFailAnimation(SDL_Renderer *);
 
-void _updateScore(SDL_Renderer *rendrerer);
+void _updateScore(SDL_Renderer *rendrerer, const GameState *);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame_sampler.h"
+#include "game.h"
+#include "judge.h"
+#include "recognizer.h"
+#include "recording.h"
+
+typedef struct {
+    uint64_t inputs;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t paused;
+    uint64_t resets;
+
+    // Hits by how the step before them was held, TIMING_NONE when the
+    // mode has no windows
+    uint64_t timing[TIMING_COUNT];
+
+    // Times the whole pattern was finished
+    uint64_t cycles;
+
+    uint64_t score;
+    uint64_t highscore;
+    uint64_t duration_ns;
+    bool quit;
+} ReplaySummary;
+
+// A private game that only sees the inputs it's fed. No SDL, no clock,
+// no globals, so any number of them can run side by side.
+typedef struct {
+    GameState state;
+    GameDirection prev;
+
+    uint64_t first_ns;
+    ReplaySummary summary;
+} Replay;
+
+void InitReplay(Replay *, GameMode *, uint64_t highscore);
+
+// Judge one input, returns JUDGE_NONE for anything after the player quit
+JudgeResult ReplayInput(Replay *, const InputEvent *);
+
+// verdicts, if not NULL, gets one result per input. A recording has at
+// most record_count inputs.
+void ReplayInputs(Replay *, const InputEvent *, size_t count, JudgeResult *verdicts);
+void ReplayRecording(Replay *, const RecordingReader *, JudgeResult *verdicts);
+
+// The recording as the game would have read it, once a frame at phase_ns
+typedef struct {
+    uint64_t phase_ns;
+    // Changes that never lasted until a read
+    uint64_t dropped;
+    ReplaySummary summary;
+} PhaseResult;
+
+// Judges the recording at count evenly spaced phases side by side, in one
+// pass over it. results needs count slots.
+bool ReplayPhaseSweep(GameMode *, const RecordingReader *, PhaseResult *results, int count);
+
+// Free practice, counts every technique the recognizer knows
+void ReplayPractice(Recognizer *, const InputEvent *, size_t count);
+void ReplayPracticeRecording(Recognizer *, const RecordingReader *);
+
+// The mode a recording was played in, judged on order only. pattern needs
+// RECORDING_MAX_PATTERN slots, both buffers must outlive the mode.
+bool GameModeFromRecording(const RecordingHeader *, GameMode *, GameDirection *pattern, PatternDfa *);
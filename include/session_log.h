@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "judge.h"
+
+// What happened to a game, so any recent point of it can be put back
+// together without keeping a copy of the state for every frame.
+//
+// The judge is deterministic, so the inputs it saw (with its verdicts
+// for reading back) and the pause ends the timer fired are all it takes
+// to get from one GameState to the next. Those go into a ring of 16 byte
+// events, with a snapshot of the state every interval events. Getting
+// the state at some time is a binary search for the last snapshot before
+// it, then at most interval events through JudgeInput().
+//
+// Only the newest capacity events are kept, older ones and the snapshots
+// before them are overwritten.
+
+#define SESSION_LOG_DEFAULT_EVENTS 4096
+#define SESSION_LOG_DEFAULT_INTERVAL 64
+
+typedef enum {
+    SESSION_EVENT_INPUT = 0,    // judged with result as the verdict, a miss starts the pause
+    SESSION_EVENT_PAUSE_END,    // miss pause over, pattern and score reset
+    SESSION_EVENT_DROPPED,      // a change the game never read, see frame_sampler.h
+    SESSION_EVENT_KIND_COUNT
+} SessionEventKind;
+
+typedef struct {
+    uint64_t timestamp_ns;
+    uint8_t kind;
+    uint8_t direction;
+    uint8_t buttons;
+    uint8_t result;
+    uint32_t reserved;
+} SessionEvent;
+
+typedef struct {
+    // Number of events before it, and the time of the last of them
+    uint64_t seq;
+    uint64_t timestamp_ns;
+    GameState state;
+    GameDirection prev;
+} SessionSnapshot;
+
+typedef struct SessionLog {
+    SessionEvent *events;
+    int capacity;       // power of two
+    uint64_t head;      // events logged since the game started
+
+    SessionSnapshot *snapshots;
+    int snapshot_count;
+    int interval;
+} SessionLog;
+
+// capacity is rounded up to a power of two
+bool InitSessionLog(SessionLog *, int capacity, int interval);
+void DestroySessionLog(SessionLog *);
+
+// Forgets everything, gs and prev as the game starts
+void BeginSessionLog(SessionLog *, const GameState *, GameDirection prev, uint64_t start_ns);
+
+// After the judge handled it, gs and prev as it left them
+void LogSessionEvent(SessionLog *, const SessionEvent *, const GameState *, GameDirection prev);
+
+// Oldest point the log can still go back to
+uint64_t SessionLogStart(const SessionLog *);
+
+// State as it was right after the last event at or before time_ns.
+// False when that's older than anything kept.
+bool RewindSessionLog(const SessionLog *, uint64_t time_ns, GameState *, GameDirection *prev);
@@ -0,0 +1,16 @@
+#pragma once
+
+// x86 vector kernels are built next to the plain C ones and picked at run
+// time with SDL_HasSSE2()/SDL_HasAVX2(), nothing needs -mavx2
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+
+// MSVC takes intrinsics anywhere, gcc and clang only in functions built
+// for them
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// How to resolve two opposing directions held at once
+typedef enum {
+    // L+R = N, U+D = N
+    SOCD_NEUTRAL = 0,
+    // Most recently pressed direction on the axis wins
+    SOCD_LAST_INPUT,
+    // Direction that was held first on the axis wins
+    SOCD_FIRST_INPUT,
+    // U+D = U, L+R = N (hitbox standard)
+    SOCD_UP_PRIORITY,
+    SOCD_POLICY_COUNT
+} SocdPolicy;
+
+// Raw mask from the previous sample in the low nibble, what it resolved to
+// in the high nibble. That is enough per-axis history to know which of two
+// opposing directions went down first.
+typedef struct {
+    SocdPolicy policy;
+    uint8_t history;
+} SocdState;
+
+// [policy][history][raw mask] -> resolved mask
+extern uint8_t socd_table[SOCD_POLICY_COUNT][256][16];
+
+void InitSocdTables();
+void InitSocdState(SocdState *, SocdPolicy);
+
+const char *SocdPolicyName(SocdPolicy);
+
+// One table load per sample, no branches
+static inline uint8_t ResolveSocd(SocdState *state, uint8_t raw)
+{
+    uint8_t out = socd_table[state->policy][state->history][raw & 0xF];
+    state->history = (uint8_t)((raw & 0xF) | (out << 4));
+    return out;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Single producer / single consumer queue of fixed size items in storage
+// the owner provides. The producer only ever writes head, the consumer
+// only ever writes tail, so neither side needs a lock, and a full queue
+// drops instead of waiting.
+typedef struct SpscRing {
+    SDL_AtomicInt head;
+    char _pad0[64 - sizeof(SDL_AtomicInt)];
+
+    SDL_AtomicInt tail;
+    char _pad1[64 - sizeof(SDL_AtomicInt)];
+
+    // Items the producer had to throw away because the consumer fell behind
+    SDL_AtomicInt dropped;
+
+    unsigned char *items;
+    size_t item_size;
+    Uint32 capacity;
+} SpscRing;
+
+// items holds capacity items, capacity must be a power of two so indices
+// can be masked instead of wrapped
+void InitSpscRing(SpscRing *, void *items, size_t item_size, Uint32 capacity);
+
+// False when it was full and the item was dropped
+bool PushSpscRing(SpscRing *, const void *item);
+bool PopSpscRing(SpscRing *, void *item);
+
+// Consumer only: the oldest item where it sits, NULL when empty. It stays
+// put until ReleaseSpscRing() hands the slot back.
+const void *PeekSpscRing(SpscRing *);
+void ReleaseSpscRing(SpscRing *);
+
+bool SpscRingFull(SpscRing *);
+int SpscRingDropped(SpscRing *);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Best scores and totals per mode, kept across restarts. Every finished
+// game is appended to a journal file as a fixed size, checksummed entry.
+// Opening folds the file into one summary per mode; an entry cut short
+// by a crash fails its checksum and is dropped along with anything after
+// it.
+//
+// The frame thread only queues. A background thread writes whatever has
+// queued up every STATS_JOURNAL_COMMIT_MS with one fsync for the lot, and
+// once the file holds STATS_JOURNAL_COMPACT_AT entries more than there are
+// modes rewrites it as one summary entry per mode, so opening stays
+// O(modes).
+
+#define STATS_JOURNAL_DEFAULT_PATH "kbd-stats.kbdj"
+#define STATS_JOURNAL_MAGIC "KBDJ"
+#define STATS_JOURNAL_VERSION 1
+
+#define STATS_NAME_SIZE 32
+#define STATS_JOURNAL_COMMIT_MS 100
+#define STATS_JOURNAL_COMPACT_AT 256
+
+// Must be a power of two
+#define STATS_JOURNAL_QUEUE 64
+
+typedef enum {
+    STATS_ENTRY_GAME = 1,   // one finished game, games is 1
+    STATS_ENTRY_SUMMARY     // everything before a compaction
+} StatsEntryKind;
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t entry_size;
+    uint64_t reserved;
+} StatsJournalHeader;
+
+typedef struct {
+    // CRC-32 of everything after it
+    uint32_t checksum;
+    uint8_t kind;
+    uint8_t reserved[3];
+    char mode_name[STATS_NAME_SIZE];
+
+    uint64_t games;
+    uint64_t highscore;
+    uint64_t completions;
+    uint64_t play_ns;
+    int64_t last_played;    // unix time
+} StatsEntry;
+
+typedef struct StatsJournal StatsJournal;
+
+// path NULL for STATS_JOURNAL_DEFAULT_PATH, created when missing. NULL
+// when the file can't be used, the game just doesn't keep stats then.
+StatsJournal *OpenStatsJournal(const char *path);
+// Writes out anything still queued
+void CloseStatsJournal(StatsJournal *);
+
+// What the file held when it was opened, false for a mode never played
+bool FindStats(const StatsJournal *, const char *mode_name, StatsEntry *out);
+
+// Frame thread, only queues
+void JournalGame(StatsJournal *, const char *mode_name, uint64_t highscore, uint64_t completions, uint64_t play_ns);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STICK_DEFAULT_BITS 8
+#define STICK_DEFAULT_DEADZONE 0.5f
+
+typedef enum {
+    // No analog input at all
+    STICK_GATE_OFF = 0,
+    // Eight equal 45 degree sectors, round deadzone
+    STICK_GATE_OCTAGON,
+    // Each axis thresholded on its own, diagonals are the corners
+    STICK_GATE_SQUARE,
+    STICK_GATE_COUNT
+} StickGateShape;
+
+// Precomputed (x, y) -> 4 bit direction mask, same layout as dpad_state
+typedef struct {
+    StickGateShape shape;
+    float deadzone;
+
+    // Table is (1 << bits) by (1 << bits), indexed by the top bits of each axis
+    int bits;
+    uint8_t *table;
+} StickGate;
+
+bool InitStickGate(StickGate *, StickGateShape, float deadzone, int bits);
+void DestroyStickGate(StickGate *);
+
+const char *StickGateName(StickGateShape);
+
+// Quantize a whole recorded trace of interleaved x, y samples
+void QuantizeStickTrace(const StickGate *, const int16_t *xy, size_t count, uint8_t *out);
+
+// One table load, no trig
+static inline uint8_t QuantizeStick(const StickGate *gate, int16_t x, int16_t y)
+{
+    if (gate->table == NULL)
+        return 0;
+
+    int shift = 16 - gate->bits;
+    uint32_t ix = (uint32_t)((int32_t)x + 32768) >> shift;
+    uint32_t iy = (uint32_t)((int32_t)y + 32768) >> shift;
+
+    return gate->table[(iy << gate->bits) | ix];
+}
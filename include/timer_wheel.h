@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Scheduled callbacks on the game clock, so nothing has to compare the
+// time against a deadline of its own every update.
+//
+// Hierarchical timing wheel with 1 ms ticks: 8 levels of 64 slots cover
+// every 64 bit deadline. A timer sits on the highest level where its tick
+// differs from the wheel's, in the slot for its tick there, and drops a
+// level whenever the wheel reaches that slot. Scheduling and cancelling
+// are O(1), running jumps straight to the next occupied slot with one bit
+// scan per level, so an idle wheel costs nothing however long it's idle.
+// Timers belong to whoever schedules them, the wheel never allocates.
+
+#define TIMER_TICK_NS 1000000ULL
+#define TIMER_LEVELS 8
+#define TIMER_SLOTS 64
+
+typedef void (*TimerCallback)(void *user, uint64_t deadline_ns);
+
+typedef struct Timer {
+    TimerCallback fire;
+    void *user;
+    uint64_t deadline_ns;
+
+    // Slot list while scheduled
+    struct Timer *prev;
+    struct Timer *next;
+    uint8_t level;
+    uint8_t slot;
+    bool armed;
+} Timer;
+
+typedef struct {
+    // Every tick before this one has been run
+    uint64_t tick;
+    Timer *slots[TIMER_LEVELS][TIMER_SLOTS];
+    uint64_t occupied[TIMER_LEVELS];
+} TimerWheel;
+
+void InitTimerWheel(TimerWheel *, uint64_t now_ns);
+void InitTimer(Timer *, TimerCallback, void *user);
+
+// Replaces any earlier deadline. One in the past fires on the next run.
+void ScheduleTimer(TimerWheel *, Timer *, uint64_t deadline_ns);
+void CancelTimer(TimerWheel *, Timer *);
+
+// Fires every timer due at or before now_ns, earliest tick first.
+// Callbacks may schedule and cancel timers, ones due by now_ns still
+// fire in this run. Returns how many fired.
+int RunTimers(TimerWheel *, uint64_t now_ns);
+
+static inline bool TimerArmed(const Timer *timer)
+{
+    return timer->armed;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Runs fn once for every item in [0, count) on a fixed set of threads.
+// Each worker starts with an even slice of the items and, once it runs
+// dry, steals half of whatever another worker has left, so a few huge
+// items can't leave the other cores idle.
+typedef void (*WorkPoolFn)(void *ctx, int worker, size_t item);
+
+typedef struct WorkPool WorkPool;
+
+// workers 0 for one per logical core
+WorkPool *StartWorkPool(int workers, size_t count, WorkPoolFn fn, void *ctx);
+
+// Waits for every item and frees the pool
+void FinishWorkPool(WorkPool *);
+
+int WorkPoolWorkers(const WorkPool *);
+size_t WorkPoolDone(const WorkPool *);
+bool WorkPoolIdle(const WorkPool *);
+
+// Times a worker took items from someone else
+uint64_t WorkPoolSteals(const WorkPool *);
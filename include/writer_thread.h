@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "spsc_ring.h"
+
+// Called on the writer thread for every item, in the order it was queued
+typedef void (*WriterItemFn)(void *user, const void *item);
+// After every pass over the queue with how many items it took, 0 included
+typedef void (*WriterPassFn)(void *user, int items);
+
+// Background thread behind the files the frame thread only queues for:
+// the frame thread produces into queue, this drains it every interval_ms
+typedef struct WriterThread {
+    SpscRing *queue;
+    int interval_ms;
+    WriterItemFn item;
+    WriterPassFn pass;
+    void *user;
+
+    SDL_Thread *thread;
+    SDL_AtomicInt running;
+} WriterThread;
+
+// pass may be NULL. False when the thread can't be started.
+bool StartWriterThread(WriterThread *, const char *name, SpscRing *queue, int interval_ms,
+                       WriterItemFn item, WriterPassFn pass, void *user);
+// Returns once everything queued before the call is written
+void StopWriterThread(WriterThread *);
@@ -0,0 +1,1013 @@
+// 64 bit off_t for ftello() and fseeko() on 32 bit builds
+#define _FILE_OFFSET_BITS 64
+
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "attempt_store.h"
+#include "modes.h"
+#include "pattern.h"
+#include "simd.h"
+#include "spsc_ring.h"
+#include "writer_thread.h"
+
+#define WRITER_QUEUE 1024
+#define WRITER_INTERVAL_MS 50
+
+#define MODES_FILE "modes.txt"
+
+// Rows a query filters at a time into a bitmask of matches
+#define SCAN_CHUNK 4096
+
+typedef enum {
+    COLUMN_MODE = 0,
+    COLUMN_START,
+    COLUMN_VERDICT,
+    COLUMN_STEPS,
+    COLUMN_CYCLE,
+    COLUMN_HOLDS,
+    COLUMN_COUNT
+} AttemptColumn;
+
+static const char *_columnFiles[COLUMN_COUNT] = {
+    [COLUMN_MODE]    = "mode.col",
+    [COLUMN_START]   = "start.col",
+    [COLUMN_VERDICT] = "verdict.col",
+    [COLUMN_STEPS]   = "steps.col",
+    [COLUMN_CYCLE]   = "cycle.col",
+    [COLUMN_HOLDS]   = "holds.col"
+};
+
+static const size_t _columnWidths[COLUMN_COUNT] = {
+    [COLUMN_MODE]    = sizeof(uint16_t),
+    [COLUMN_START]   = sizeof(uint64_t),
+    [COLUMN_VERDICT] = sizeof(uint8_t),
+    [COLUMN_STEPS]   = sizeof(uint8_t),
+    [COLUMN_CYCLE]   = sizeof(uint32_t),
+    [COLUMN_HOLDS]   = sizeof(uint16_t) * ATTEMPT_MAX_STEPS
+};
+
+static void _columnPath(char *out, size_t size, const char *dir, const char *file)
+{
+    snprintf(out, size, "%s/%s", dir, file);
+}
+
+// ************* TRACKING ******************//
+
+void InitAttemptTracker(AttemptTracker *tracker, uint16_t mode, const GameState *gs, int64_t wall_offset_ns)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->current.mode = mode;
+    tracker->completions = gs->completions;
+    tracker->wall_offset_ns = wall_offset_ns;
+}
+
+static void _beginAttempt(AttemptTracker *tracker, uint64_t timestamp_ns)
+{
+    uint16_t mode = tracker->current.mode;
+
+    memset(&tracker->current, 0, sizeof(tracker->current));
+    tracker->current.mode = mode;
+    tracker->current.start_ns = (uint64_t)((int64_t)timestamp_ns + tracker->wall_offset_ns);
+    tracker->current.steps = 1;
+    tracker->first_ns = timestamp_ns;
+    tracker->last_ns = timestamp_ns;
+    tracker->open = true;
+}
+
+// The latest step was held until timestamp_ns
+static void _holdStep(AttemptTracker *tracker, uint64_t timestamp_ns)
+{
+    Attempt *a = &tracker->current;
+    uint64_t held = (timestamp_ns - tracker->last_ns) / ATTEMPT_HOLD_UNIT_NS;
+
+    if (a->steps >= 1 && a->steps <= ATTEMPT_MAX_STEPS)
+        a->holds[a->steps - 1] = held > UINT16_MAX ? UINT16_MAX : (uint16_t)held;
+}
+
+static void _endAttempt(AttemptTracker *tracker, AttemptVerdict verdict, uint64_t end_ns, Attempt *out)
+{
+    uint64_t cycle = (end_ns - tracker->first_ns) / 1000;
+
+    tracker->current.verdict = (uint8_t)verdict;
+    tracker->current.cycle_us = cycle > UINT32_MAX ? UINT32_MAX : (uint32_t)cycle;
+    tracker->open = false;
+    *out = tracker->current;
+}
+
+bool TrackAttempt(AttemptTracker *tracker, JudgeResult result, const GameState *gs, uint64_t timestamp_ns, Attempt *out)
+{
+    bool finished = gs->completions > tracker->completions;
+    tracker->completions = gs->completions;
+
+    switch (result)
+    {
+        case JUDGE_HIT:
+            break;
+        case JUDGE_MISS:
+            if (!tracker->open)
+                return false;
+
+            _holdStep(tracker, timestamp_ns);
+            _endAttempt(tracker, ATTEMPT_MISSED, timestamp_ns, out);
+            return true;
+        case JUDGE_QUIT:
+            tracker->open = false;
+            return false;
+        default:
+            // A finished technique the input didn't extend and didn't start
+            // another one either, it was done at the last input
+            if (finished && tracker->open)
+            {
+                _endAttempt(tracker, ATTEMPT_DONE, tracker->last_ns, out);
+                return true;
+            }
+            return false;
+    }
+
+    // Finished at the last input and this one starts the next
+    if (finished && gs->player_pos != PATTERN_START)
+    {
+        bool ended = tracker->open;
+        if (ended)
+            _endAttempt(tracker, ATTEMPT_DONE, tracker->last_ns, out);
+
+        _beginAttempt(tracker, timestamp_ns);
+        return ended;
+    }
+
+    if (!tracker->open)
+        _beginAttempt(tracker, timestamp_ns);
+    else
+    {
+        _holdStep(tracker, timestamp_ns);
+        if (tracker->current.steps < UINT8_MAX)
+            tracker->current.steps++;
+        tracker->last_ns = timestamp_ns;
+    }
+
+    if (!finished)
+        return false;
+
+    _endAttempt(tracker, ATTEMPT_DONE, timestamp_ns, out);
+    return true;
+}
+
+// ************* WRITING ******************//
+
+struct AttemptWriter {
+    FILE *files[COLUMN_COUNT];
+    uint16_t *mode_ids;
+
+    SpscRing queue;
+    Attempt queued[WRITER_QUEUE];
+    WriterThread thread;
+};
+
+typedef struct {
+    char **names;
+    int count;
+    int capacity;
+} ModeNames;
+
+// Cut down to what a recording keeps
+static bool _addModeName(ModeNames *names, const char *name)
+{
+    if (names->count == names->capacity)
+    {
+        int capacity = names->capacity > 0 ? names->capacity * 2 : 16;
+        char **grown = realloc(names->names, capacity * sizeof(char *));
+        if (grown == NULL)
+            return false;
+
+        names->names = grown;
+        names->capacity = capacity;
+    }
+
+    char copy[RECORDING_NAME_SIZE];
+    snprintf(copy, sizeof(copy), "%s", name);
+
+    names->names[names->count] = SDL_strdup(copy);
+    if (names->names[names->count] == NULL)
+        return false;
+
+    names->count++;
+    return true;
+}
+
+static void _freeModeNames(char **names, int count)
+{
+    for (int i = 0; i < count; i++)
+        SDL_free(names[i]);
+    free(names);
+}
+
+static bool _loadModeNames(const char *dir, ModeNames *names)
+{
+    char path[512];
+    _columnPath(path, sizeof(path), dir, MODES_FILE);
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return true;
+
+    bool ok = true;
+    char line[256];
+    while (ok && names->count < ATTEMPT_MAX_MODES && fgets(line, sizeof(line), file) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        ok = _addModeName(names, line);
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static bool _saveModeNames(const char *dir, const ModeNames *names)
+{
+    char path[512];
+    _columnPath(path, sizeof(path), dir, MODES_FILE);
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL)
+        return false;
+
+    for (int i = 0; i < names->count; i++)
+        fprintf(file, "%s\n", names->names[i]);
+
+    return fclose(file) == 0;
+}
+
+// Same name, same id, for as long as the store is kept
+static bool _assignModeIds(AttemptWriter *writer, const char *dir, const ModeRegistry *modes)
+{
+    ModeNames names = {0};
+    bool ok = _loadModeNames(dir, &names);
+    int known = names.count;
+
+    writer->mode_ids = calloc(modes->count > 0 ? modes->count : 1, sizeof(uint16_t));
+    ok = ok && writer->mode_ids != NULL;
+
+    for (int m = 0; m < modes->count && ok; m++)
+    {
+        const GameMode *mode = &modes->modes[m];
+
+        char name[RECORDING_NAME_SIZE];
+        snprintf(name, sizeof(name), "%s", mode->mode_name);
+
+        int id = 0;
+        while (id < names.count && strcmp(names.names[id], name) != 0)
+            id++;
+
+        if (id == names.count)
+        {
+            if (names.count == ATTEMPT_MAX_MODES)
+            {
+                printf("Attempt store %s has no room for mode %s\n", dir, name);
+                ok = false;
+                break;
+            }
+            ok = _addModeName(&names, name);
+        }
+
+        writer->mode_ids[m] = (uint16_t)id;
+
+        if (mode->pattern_size > ATTEMPT_MAX_STEPS)
+        {
+            printf("Attempt store keeps holds for the first %d of %s's %d steps\n",
+                ATTEMPT_MAX_STEPS, name, mode->pattern_size);
+        }
+    }
+
+    ok = ok && (names.count == known || _saveModeNames(dir, &names));
+    _freeModeNames(names.names, names.count);
+    return ok;
+}
+
+// Offsets are 64 bit even where long is 32 bit, as it is on Windows
+static int64_t _fileSize(FILE *file)
+{
+#ifdef _WIN32
+    return _fseeki64(file, 0, SEEK_END) == 0 ? _ftelli64(file) : -1;
+#else
+    return fseeko(file, 0, SEEK_END) == 0 ? (int64_t)ftello(file) : -1;
+#endif
+}
+
+static bool _seekFile(FILE *file, int64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool _truncateFile(FILE *file, int64_t size)
+{
+    fflush(file);
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+// Opens every column for appending, cut back to the rows they all have
+static bool _openColumns(AttemptWriter *writer, const char *dir)
+{
+    int64_t rows = -1;
+
+    for (int c = 0; c < COLUMN_COUNT; c++)
+    {
+        char path[512];
+        _columnPath(path, sizeof(path), dir, _columnFiles[c]);
+
+        writer->files[c] = fopen(path, "r+b");
+        if (writer->files[c] == NULL)
+            writer->files[c] = fopen(path, "w+b");
+        if (writer->files[c] == NULL)
+        {
+            printf("Error opening attempt column %s\n", path);
+            return false;
+        }
+
+        int64_t size = _fileSize(writer->files[c]);
+        if (size < 0)
+        {
+            printf("Error reading the size of attempt column %s\n", path);
+            return false;
+        }
+
+        int64_t have = size / (int64_t)_columnWidths[c];
+        if (rows < 0 || have < rows)
+            rows = have;
+    }
+
+    for (int c = 0; c < COLUMN_COUNT; c++)
+    {
+        int64_t size = rows * (int64_t)_columnWidths[c];
+
+        if ((_fileSize(writer->files[c]) != size && !_truncateFile(writer->files[c], size))
+            || !_seekFile(writer->files[c], size))
+        {
+            printf("Error cutting back attempt column %s\n", _columnFiles[c]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void _writeAttempt(void *user, const void *item)
+{
+    AttemptWriter *writer = user;
+    const Attempt *a = item;
+
+    fwrite(&a->mode, sizeof(a->mode), 1, writer->files[COLUMN_MODE]);
+    fwrite(&a->start_ns, sizeof(a->start_ns), 1, writer->files[COLUMN_START]);
+    fwrite(&a->verdict, sizeof(a->verdict), 1, writer->files[COLUMN_VERDICT]);
+    fwrite(&a->steps, sizeof(a->steps), 1, writer->files[COLUMN_STEPS]);
+    fwrite(&a->cycle_us, sizeof(a->cycle_us), 1, writer->files[COLUMN_CYCLE]);
+    fwrite(a->holds, sizeof(a->holds), 1, writer->files[COLUMN_HOLDS]);
+}
+
+static void _flushColumns(void *user, int items)
+{
+    AttemptWriter *writer = user;
+
+    if (items == 0)
+        return;
+
+    for (int c = 0; c < COLUMN_COUNT; c++)
+        fflush(writer->files[c]);
+}
+
+static void _freeWriter(AttemptWriter *writer)
+{
+    for (int c = 0; c < COLUMN_COUNT; c++)
+    {
+        if (writer->files[c] != NULL)
+            fclose(writer->files[c]);
+    }
+
+    free(writer->mode_ids);
+    free(writer);
+}
+
+AttemptWriter *OpenAttemptWriter(const char *dir, const ModeRegistry *modes)
+{
+    if (dir == NULL)
+        dir = ATTEMPT_STORE_DEFAULT_DIR;
+
+    AttemptWriter *writer = calloc(1, sizeof(AttemptWriter));
+    if (writer == NULL)
+        return NULL;
+
+    if (!SDL_CreateDirectory(dir))
+    {
+        printf("Error creating attempt store %s: %s\n", dir, SDL_GetError());
+        free(writer);
+        return NULL;
+    }
+
+    if (!_assignModeIds(writer, dir, modes) || !_openColumns(writer, dir))
+    {
+        _freeWriter(writer);
+        return NULL;
+    }
+
+    InitSpscRing(&writer->queue, writer->queued, sizeof(Attempt), WRITER_QUEUE);
+
+    if (!StartWriterThread(&writer->thread, "KBDAttempts", &writer->queue, WRITER_INTERVAL_MS,
+                           _writeAttempt, _flushColumns, writer))
+    {
+        _freeWriter(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+uint16_t AttemptModeId(const AttemptWriter *writer, int index)
+{
+    return writer->mode_ids[index];
+}
+
+void StoreAttempt(AttemptWriter *writer, const Attempt *a)
+{
+    if (writer == NULL)
+        return;
+
+    PushSpscRing(&writer->queue, a);
+}
+
+void CloseAttemptWriter(AttemptWriter *writer)
+{
+    if (writer == NULL)
+        return;
+
+    StopWriterThread(&writer->thread);
+
+    int dropped = SpscRingDropped(&writer->queue);
+    if (dropped > 0)
+        printf("Attempt store dropped %d attempts\n", dropped);
+
+    _freeWriter(writer);
+}
+
+// ************* READING ******************//
+
+// NULL with size 0 for an empty file
+static bool _mapColumn(AttemptStore *store, int c, const char *path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+
+    if (size.QuadPart > 0)
+    {
+        // The mapping keeps the file alive
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *base = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (base == NULL)
+        {
+            if (mapping != NULL)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        store->maps[c] = base;
+        store->mappings[c] = (intptr_t)mapping;
+        store->sizes[c] = (size_t)size.QuadPart;
+    }
+
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0)
+    {
+        void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+
+        store->maps[c] = base;
+        store->sizes[c] = (size_t)st.st_size;
+    }
+
+    // The mapping keeps the file alive
+    close(fd);
+#endif
+
+    return true;
+}
+
+bool OpenAttemptStore(AttemptStore *store, const char *dir)
+{
+    memset(store, 0, sizeof(*store));
+
+    if (dir == NULL)
+        dir = ATTEMPT_STORE_DEFAULT_DIR;
+
+    size_t rows = SIZE_MAX;
+    for (int c = 0; c < COLUMN_COUNT; c++)
+    {
+        char path[512];
+        _columnPath(path, sizeof(path), dir, _columnFiles[c]);
+
+        if (!_mapColumn(store, c, path))
+        {
+            printf("Error mapping attempt column %s\n", path);
+            CloseAttemptStore(store);
+            return false;
+        }
+
+        size_t have = store->sizes[c] / _columnWidths[c];
+        if (have < rows)
+            rows = have;
+    }
+
+    store->count = rows;
+    store->mode = store->maps[COLUMN_MODE];
+    store->start = store->maps[COLUMN_START];
+    store->verdict = store->maps[COLUMN_VERDICT];
+    store->steps = store->maps[COLUMN_STEPS];
+    store->cycle = store->maps[COLUMN_CYCLE];
+    store->holds = store->maps[COLUMN_HOLDS];
+
+    ModeNames names = {0};
+    if (!_loadModeNames(dir, &names))
+    {
+        printf("Error reading the mode names of attempt store %s\n", dir);
+        _freeModeNames(names.names, names.count);
+        CloseAttemptStore(store);
+        return false;
+    }
+
+    store->mode_names = names.names;
+    store->mode_count = names.count;
+    return true;
+}
+
+void CloseAttemptStore(AttemptStore *store)
+{
+    for (int c = 0; c < COLUMN_COUNT; c++)
+    {
+        if (store->maps[c] == NULL)
+            continue;
+
+#ifdef _WIN32
+        UnmapViewOfFile(store->maps[c]);
+        CloseHandle((HANDLE)store->mappings[c]);
+#else
+        munmap(store->maps[c], store->sizes[c]);
+#endif
+    }
+
+    _freeModeNames(store->mode_names, store->mode_count);
+
+    memset(store, 0, sizeof(*store));
+}
+
+int FindAttemptMode(const AttemptStore *store, const char *name)
+{
+    for (int i = 0; i < store->mode_count; i++)
+    {
+        if (strcmp(store->mode_names[i], name) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+// ************* QUERIES ******************//
+
+// One predicate every scan is made of: the mode, and up to two byte
+// columns equal to a value. NULL columns and ATTEMPT_ANY_MODE match
+// everything.
+typedef struct {
+    const uint16_t *mode;
+    int mode_id;
+    const uint8_t *a;
+    uint8_t a_value;
+    const uint8_t *b;
+    uint8_t b_value;
+} ScanFilter;
+
+typedef enum {
+    SCAN_KERNEL_SCALAR = 0,
+    SCAN_KERNEL_SSE2,
+    SCAN_KERNEL_AVX2
+} ScanKernel;
+
+static int _lowestBit(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, v);
+    return (int)bit;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static bool _matches(const ScanFilter *f, size_t i)
+{
+    return (f->mode_id < 0 || f->mode[i] == (uint16_t)f->mode_id)
+        && (f->a == NULL || f->a[i] == f->a_value)
+        && (f->b == NULL || f->b[i] == f->b_value);
+}
+
+static uint64_t _countScalar(const ScanFilter *f, size_t begin, size_t end)
+{
+    uint64_t count = 0;
+    for (size_t i = begin; i < end; i++)
+        count += _matches(f, i);
+
+    return count;
+}
+
+// Rows from..end into the mask of a chunk starting at begin
+static void _maskScalar(const ScanFilter *f, size_t begin, size_t from, size_t end, uint64_t *bits)
+{
+    for (size_t i = from; i < end; i++)
+        bits[(i - begin) / 64] |= (uint64_t)_matches(f, i) << ((i - begin) % 64);
+}
+
+#ifdef SIMD_X86
+// 0xFF in the byte of each of the 16 rows from i that match
+static __m128i _hitSse2(const ScanFilter *f, size_t i)
+{
+    __m128i hit = _mm_set1_epi8(-1);
+
+    if (f->mode_id >= 0)
+    {
+        // Ids are compared 8 at a time and packed back down to a byte a row
+        const __m128i mode = _mm_set1_epi16((short)f->mode_id);
+        __m128i lo = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(f->mode + i)), mode);
+        __m128i hi = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(f->mode + i + 8)), mode);
+        hit = _mm_packs_epi16(lo, hi);
+    }
+    if (f->a != NULL)
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(f->a + i)), _mm_set1_epi8((char)f->a_value)));
+    if (f->b != NULL)
+        hit = _mm_and_si128(hit, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(f->b + i)), _mm_set1_epi8((char)f->b_value)));
+
+    return hit;
+}
+
+// Matches are counted into byte lanes, which are summed up with SAD
+// before 255 rounds can wrap them
+static uint64_t _countSse2(const ScanFilter *f, size_t begin, size_t end)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i total = zero;
+    size_t i = begin;
+
+    while (i + 16 <= end)
+    {
+        __m128i lanes = zero;
+        for (int round = 0; round < 255 && i + 16 <= end; round++, i += 16)
+            lanes = _mm_sub_epi8(lanes, _hitSse2(f, i));
+
+        total = _mm_add_epi64(total, _mm_sad_epu8(lanes, zero));
+    }
+
+    uint64_t sums[2];
+    _mm_storeu_si128((__m128i *)sums, total);
+    return sums[0] + sums[1] + _countScalar(f, i, end);
+}
+
+static void _maskSse2(const ScanFilter *f, size_t begin, size_t end, uint64_t *bits)
+{
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16)
+        bits[(i - begin) / 64] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_hitSse2(f, i)) << ((i - begin) % 64);
+
+    _maskScalar(f, begin, i, end, bits);
+}
+
+TARGET_AVX2 static __m256i _hitAvx2(const ScanFilter *f, size_t i)
+{
+    __m256i hit = _mm256_set1_epi8(-1);
+
+    if (f->mode_id >= 0)
+    {
+        // The pack works within 128 bit halves, the permute puts the rows
+        // back in order
+        const __m256i mode = _mm256_set1_epi16((short)f->mode_id);
+        __m256i lo = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(f->mode + i)), mode);
+        __m256i hi = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(f->mode + i + 16)), mode);
+        hit = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+    if (f->a != NULL)
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(f->a + i)), _mm256_set1_epi8((char)f->a_value)));
+    if (f->b != NULL)
+        hit = _mm256_and_si256(hit, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(f->b + i)), _mm256_set1_epi8((char)f->b_value)));
+
+    return hit;
+}
+
+TARGET_AVX2 static uint64_t _countAvx2(const ScanFilter *f, size_t begin, size_t end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i total = zero;
+    size_t i = begin;
+
+    while (i + 32 <= end)
+    {
+        __m256i lanes = zero;
+        for (int round = 0; round < 255 && i + 32 <= end; round++, i += 32)
+            lanes = _mm256_sub_epi8(lanes, _hitAvx2(f, i));
+
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(lanes, zero));
+    }
+
+    uint64_t sums[4];
+    _mm256_storeu_si256((__m256i *)sums, total);
+    return sums[0] + sums[1] + sums[2] + sums[3] + _countScalar(f, i, end);
+}
+
+TARGET_AVX2 static void _maskAvx2(const ScanFilter *f, size_t begin, size_t end, uint64_t *bits)
+{
+    size_t i = begin;
+    for (; i + 32 <= end; i += 32)
+        bits[(i - begin) / 64] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_hitAvx2(f, i)) << ((i - begin) % 64);
+
+    _maskScalar(f, begin, i, end, bits);
+}
+#endif
+
+static ScanKernel _scanKernel()
+{
+    static int kernel = -1;
+
+    if (kernel < 0)
+    {
+        kernel = SCAN_KERNEL_SCALAR;
+#ifdef SIMD_X86
+        if (SDL_HasAVX2())
+            kernel = SCAN_KERNEL_AVX2;
+        else if (SDL_HasSSE2())
+            kernel = SCAN_KERNEL_SSE2;
+#endif
+    }
+
+    return (ScanKernel)kernel;
+}
+
+const char *AttemptScanKernel()
+{
+    static const char *names[] = { "scalar", "sse2", "avx2" };
+    return names[_scanKernel()];
+}
+
+static uint64_t _count(const ScanFilter *f, size_t begin, size_t end)
+{
+    if (begin >= end)
+        return 0;
+
+    switch (_scanKernel())
+    {
+#ifdef SIMD_X86
+        case SCAN_KERNEL_AVX2:
+            return _countAvx2(f, begin, end);
+        case SCAN_KERNEL_SSE2:
+            return _countSse2(f, begin, end);
+#endif
+        default:
+            return _countScalar(f, begin, end);
+    }
+}
+
+// Bit i - begin for every row that matches, at most SCAN_CHUNK rows
+static void _mask(const ScanFilter *f, size_t begin, size_t end, uint64_t bits[SCAN_CHUNK / 64])
+{
+    memset(bits, 0, SCAN_CHUNK / 8);
+
+    switch (_scanKernel())
+    {
+#ifdef SIMD_X86
+        case SCAN_KERNEL_AVX2:
+            _maskAvx2(f, begin, end, bits);
+            break;
+        case SCAN_KERNEL_SSE2:
+            _maskSse2(f, begin, end, bits);
+            break;
+#endif
+        default:
+            _maskScalar(f, begin, begin, end, bits);
+            break;
+    }
+}
+
+// Offsets from begin of the rows that match, how many there are
+static int _select(const ScanFilter *f, size_t begin, size_t end, uint16_t rows[SCAN_CHUNK])
+{
+    int count = 0;
+
+    // Nothing to gain from a mask without vectors
+    if (_scanKernel() == SCAN_KERNEL_SCALAR)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            rows[count] = (uint16_t)(i - begin);
+            count += _matches(f, i);
+        }
+        return count;
+    }
+
+    uint64_t bits[SCAN_CHUNK / 64];
+    _mask(f, begin, end, bits);
+
+    for (int w = 0; w < SCAN_CHUNK / 64; w++)
+    {
+        for (uint64_t m = bits[w]; m != 0; m &= m - 1)
+            rows[count++] = (uint16_t)(w * 64 + _lowestBit(m));
+    }
+
+    return count;
+}
+
+// First row that started at or after time_ns
+static size_t _lowerBound(const AttemptStore *store, uint64_t time_ns)
+{
+    size_t lo = 0;
+    size_t hi = store->count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store->start[mid] < time_ns)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void _range(const AttemptStore *store, const AttemptQuery *query, size_t *begin, size_t *end)
+{
+    *begin = _lowerBound(store, query->from_ns);
+    *end = query->to_ns != 0 ? _lowerBound(store, query->to_ns) : store->count;
+}
+
+static ScanFilter _filter(const AttemptStore *store, const AttemptQuery *query)
+{
+    ScanFilter f = {0};
+    f.mode = store->mode;
+    f.mode_id = query->mode;
+    return f;
+}
+
+void QueryAccuracy(const AttemptStore *store, const AttemptQuery *query, uint64_t bucket_ns, AccuracyBucket *out, int count)
+{
+    ScanFilter all = _filter(store, query);
+    ScanFilter done = all;
+    done.a = store->verdict;
+    done.a_value = ATTEMPT_DONE;
+
+    for (int i = 0; i < count; i++)
+    {
+        AttemptQuery bucket = *query;
+        bucket.from_ns = query->from_ns + (uint64_t)i * bucket_ns;
+        bucket.to_ns = bucket.from_ns + bucket_ns;
+        if (query->to_ns != 0 && bucket.to_ns > query->to_ns)
+            bucket.to_ns = query->to_ns;
+
+        size_t begin, end;
+        _range(store, &bucket, &begin, &end);
+
+        out[i].start_ns = bucket.from_ns;
+        out[i].attempts = _count(&all, begin, end);
+        out[i].done = _count(&done, begin, end);
+    }
+}
+
+uint64_t QueryStepMisses(const AttemptStore *store, const AttemptQuery *query, uint64_t reached[ATTEMPT_STEP_LIMIT], uint64_t missed[ATTEMPT_STEP_LIMIT])
+{
+    size_t begin, end;
+    _range(store, query, &begin, &end);
+
+    ScanFilter f = _filter(store, query);
+    uint16_t rows[SCAN_CHUNK];
+
+    // Every (verdict, steps) pair at once, one pass whatever the kernel
+    uint64_t hist[2][ATTEMPT_STEP_LIMIT] = {{0}};
+    for (size_t chunk = begin; chunk < end; chunk += SCAN_CHUNK)
+    {
+        int n = _select(&f, chunk, end - chunk < SCAN_CHUNK ? end : chunk + SCAN_CHUNK, rows);
+        for (int r = 0; r < n; r++)
+        {
+            size_t i = chunk + rows[r];
+            hist[store->verdict[i] & 1][store->steps[i]]++;
+        }
+    }
+
+    // A miss at step k had k right inputs, a finished attempt with n
+    // steps got through every step before n
+    uint64_t through = 0;
+    uint64_t clipped = 0;
+    for (int k = ATTEMPT_STEP_LIMIT - 1; k >= 0; k--)
+    {
+        if (k + 1 < ATTEMPT_STEP_LIMIT)
+            through += hist[ATTEMPT_DONE][k + 1];
+
+        missed[k] = hist[ATTEMPT_MISSED][k];
+        reached[k] = through + missed[k];
+        through += missed[k];
+
+        if (k > ATTEMPT_MAX_STEPS)
+            clipped += hist[ATTEMPT_DONE][k] + hist[ATTEMPT_MISSED][k];
+    }
+
+    return clipped;
+}
+
+uint64_t QueryCyclePercentiles(const AttemptStore *store, const AttemptQuery *query, const double *p, uint64_t *out_ns, int count)
+{
+    size_t begin, end;
+    _range(store, query, &begin, &end);
+
+    uint32_t *hist = calloc(ATTEMPT_CYCLE_BUCKETS, sizeof(uint32_t));
+    if (hist == NULL)
+        return 0;
+
+    ScanFilter f = _filter(store, query);
+    f.a = store->verdict;
+    f.a_value = ATTEMPT_DONE;
+    uint16_t rows[SCAN_CHUNK];
+
+    uint64_t total = 0;
+    for (size_t chunk = begin; chunk < end; chunk += SCAN_CHUNK)
+    {
+        int n = _select(&f, chunk, end - chunk < SCAN_CHUNK ? end : chunk + SCAN_CHUNK, rows);
+        for (int r = 0; r < n; r++)
+        {
+            uint32_t bucket = store->cycle[chunk + rows[r]] / ATTEMPT_CYCLE_BUCKET_US;
+            hist[bucket < ATTEMPT_CYCLE_BUCKETS ? bucket : ATTEMPT_CYCLE_BUCKETS - 1]++;
+        }
+        total += n;
+    }
+
+    for (int q = 0; q < count; q++)
+    {
+        out_ns[q] = 0;
+        if (total == 0)
+            continue;
+
+        uint64_t rank = (uint64_t)(p[q] * (double)(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < ATTEMPT_CYCLE_BUCKETS; b++)
+        {
+            seen += hist[b];
+            if (seen >= rank)
+            {
+                out_ns[q] = (uint64_t)(b + 1) * ATTEMPT_CYCLE_BUCKET_US * 1000;
+                break;
+            }
+        }
+    }
+
+    free(hist);
+    return total;
+}
@@ -0,0 +1,1024 @@
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "judge.h"
+#include "judge_batch.h"
+#include "notation.h"
+#include "replay.h"
+
+typedef struct {
+    BatchArchive *archive;
+    int player;
+    bool root;
+} ScanDir;
+
+static int _addPlayer(BatchArchive *archive, const char *name)
+{
+    for (int i = 0; i < archive->player_count; i++)
+    {
+        if (strcmp(archive->players[i], name) == 0)
+            return i;
+    }
+
+    if (archive->player_count == archive->player_capacity)
+    {
+        int capacity = archive->player_capacity ? archive->player_capacity * 2 : 16;
+        char **players = realloc(archive->players, capacity * sizeof(char *));
+        if (players == NULL)
+            return -1;
+
+        archive->players = players;
+        archive->player_capacity = capacity;
+    }
+
+    archive->players[archive->player_count] = SDL_strdup(name);
+    return archive->player_count++;
+}
+
+static bool _addFile(BatchArchive *archive, const char *path, int player, uint64_t size)
+{
+    if (archive->count == archive->capacity)
+    {
+        size_t capacity = archive->capacity ? archive->capacity * 2 : 256;
+        BatchFile *files = realloc(archive->files, capacity * sizeof(BatchFile));
+        if (files == NULL)
+            return false;
+
+        archive->files = files;
+        archive->capacity = capacity;
+    }
+
+    BatchFile *file = &archive->files[archive->count++];
+    file->path = SDL_strdup(path);
+    file->player = player;
+    file->size = size;
+
+    archive->bytes += size;
+    return true;
+}
+
+static bool _hasExtension(const char *name, const char *ext)
+{
+    size_t len = strlen(name);
+    size_t ext_len = strlen(ext);
+    return len > ext_len && strcmp(name + len - ext_len, ext) == 0;
+}
+
+static SDL_EnumerationResult _scanEntry(void *data, const char *dirname, const char *fname)
+{
+    ScanDir *dir = data;
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%s", dirname, fname);
+
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+        return SDL_ENUM_CONTINUE;
+
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        // First level down names the player
+        ScanDir sub = { dir->archive, dir->player, false };
+        if (dir->root)
+            sub.player = _addPlayer(dir->archive, fname);
+
+        if (sub.player < 0 || !SDL_EnumerateDirectory(path, _scanEntry, &sub))
+            return SDL_ENUM_FAILURE;
+    }
+    else if (info.type == SDL_PATHTYPE_FILE && _hasExtension(fname, RECORDING_EXTENSION))
+    {
+        int player = dir->root ? _addPlayer(dir->archive, "-") : dir->player;
+        if (player < 0 || !_addFile(dir->archive, path, player, info.size))
+            return SDL_ENUM_FAILURE;
+    }
+
+    return SDL_ENUM_CONTINUE;
+}
+
+bool ScanBatchArchive(BatchArchive *archive, const char *root)
+{
+    memset(archive, 0, sizeof(*archive));
+
+    ScanDir dir = { archive, -1, true };
+    if (!SDL_EnumerateDirectory(root, _scanEntry, &dir))
+    {
+        printf("Error reading %s: %s\n", root, SDL_GetError());
+        DestroyBatchArchive(archive);
+        return false;
+    }
+
+    return true;
+}
+
+void DestroyBatchArchive(BatchArchive *archive)
+{
+    for (size_t i = 0; i < archive->count; i++)
+        SDL_free(archive->files[i].path);
+    for (int i = 0; i < archive->player_count; i++)
+        SDL_free(archive->players[i]);
+
+    free(archive->files);
+    free(archive->players);
+    memset(archive, 0, sizeof(*archive));
+}
+
+// Recordings of one mode ScoreRecording() judges side by side, and how
+// many steps they get at a time
+#define SCORE_LANES 16
+#define SCORE_CHUNK 256
+
+typedef struct {
+    const BatchFile *file;
+    int stats;              // row in the worker's table
+    InputEvent *events;     // NULL when the lane is free
+    size_t count;
+    size_t next;
+
+    // Kept apart until the lane finishes, a lane that has to be judged
+    // again with ReplayInput() throws them away
+    uint64_t misses_at[PATTERN_MAX_STATES];
+    uint16_t *cycles;       // cycle_hist buckets
+    size_t cycle_count;
+    size_t cycle_capacity;
+    bool spilled;           // no memory for cycles
+} ScoreLane;
+
+typedef struct {
+    bool tried;
+    bool ready;             // InitJudgeBatch() took the mode
+    int busy;
+    JudgeBatch batch;
+    ScoreLane lanes[SCORE_LANES];
+
+    // Between a lane's first hit and its next miss, see _scoreGame()
+    uint32_t in_cycle[SCORE_LANES];
+    uint64_t cycle_start[SCORE_LANES];
+} ScoreGroup;
+
+struct BatchLanes {
+    ScoreGroup *groups;     // by registry index
+    int count;
+
+    // One row per step
+    uint8_t inputs[SCORE_CHUNK * SCORE_LANES];
+    uint32_t ts_lo[SCORE_CHUNK * SCORE_LANES];
+    uint32_t ts_hi[SCORE_CHUNK * SCORE_LANES];
+};
+
+bool InitBatchWorker(BatchWorker *worker, const ModeRegistry *modes, bool lanes)
+{
+    memset(worker, 0, sizeof(*worker));
+
+    if (modes->practice != NULL)
+        worker->practice = *modes->practice;
+    else
+        InitRecognizer(&worker->practice);
+
+    if (!lanes || modes->count == 0)
+        return true;
+
+    worker->lanes = calloc(1, sizeof(BatchLanes));
+    if (worker->lanes == NULL)
+        return false;
+
+    worker->lanes->groups = calloc(modes->count, sizeof(ScoreGroup));
+    if (worker->lanes->groups == NULL)
+    {
+        free(worker->lanes);
+        worker->lanes = NULL;
+        return false;
+    }
+
+    worker->lanes->count = modes->count;
+    return true;
+}
+
+void DestroyBatchWorker(BatchWorker *worker)
+{
+    BatchLanes *lanes = worker->lanes;
+    for (int g = 0; lanes != NULL && g < lanes->count; g++)
+    {
+        ScoreGroup *group = &lanes->groups[g];
+        for (int l = 0; l < SCORE_LANES; l++)
+        {
+            free(group->lanes[l].events);
+            free(group->lanes[l].cycles);
+        }
+
+        if (group->ready)
+            DestroyJudgeBatch(&group->batch);
+    }
+
+    if (lanes != NULL)
+        free(lanes->groups);
+    free(lanes);
+    worker->lanes = NULL;
+
+    DestroyBatchTable(&worker->table);
+}
+
+// hints is the pattern's dfa->hint, NULL for free practice
+static BatchStats *_findStats(BatchTable *table, int player, const char *mode_name, const uint8_t *hints, int states)
+{
+    bool practice = hints == NULL;
+    if (practice)
+        states = 0;
+
+    for (int i = table->count - 1; i >= 0; i--)
+    {
+        BatchStats *stats = &table->stats[i];
+        if (stats->player == player && stats->practice == practice && stats->states == states
+            && strcmp(stats->mode_name, mode_name) == 0
+            && memcmp(stats->expected, hints != NULL ? hints : stats->expected, (size_t)states) == 0)
+            return stats;
+    }
+
+    if (table->count == table->capacity)
+    {
+        int capacity = table->capacity ? table->capacity * 2 : 8;
+        BatchStats *grown = realloc(table->stats, capacity * sizeof(BatchStats));
+        if (grown == NULL)
+            return NULL;
+
+        table->stats = grown;
+        table->capacity = capacity;
+    }
+
+    BatchStats *stats = &table->stats[table->count++];
+    memset(stats, 0, sizeof(*stats));
+    stats->player = player;
+    snprintf(stats->mode_name, sizeof(stats->mode_name), "%s", mode_name);
+    stats->practice = practice;
+    stats->states = states;
+    if (!practice)
+        memcpy(stats->expected, hints, (size_t)states);
+    return stats;
+}
+
+static int _cycleBucket(uint64_t ns)
+{
+    uint64_t bucket = ns / BATCH_CYCLE_BUCKET_NS;
+    return bucket < BATCH_CYCLE_BUCKETS ? (int)bucket : BATCH_CYCLE_BUCKETS - 1;
+}
+
+static void _addCycle(BatchStats *stats, uint64_t ns)
+{
+    stats->cycle_hist[_cycleBucket(ns)]++;
+}
+
+static uint64_t _scorePractice(BatchWorker *worker, BatchStats *stats, const RecordingReader *reader)
+{
+    ResetRecognizer(&worker->practice);
+    ReplayPracticeRecording(&worker->practice, reader);
+
+    stats->inputs += worker->practice.inputs;
+    stats->cycles += RecognizedTotal(&worker->practice);
+    return worker->practice.inputs;
+}
+
+static uint64_t _scoreGame(BatchStats *stats, GameMode *mode, const RecordingReader *reader)
+{
+    Replay replay;
+    InitReplay(&replay, mode, 0);
+
+    RecordingIter it;
+    InputEvent ev;
+    uint64_t cycle_start = 0;
+    bool in_cycle = false;
+
+    BeginRecordingIter(reader, &it);
+    while (NextRecordedInput(&it, &ev))
+    {
+        int pos = replay.state.player_pos;
+        uint64_t completions = replay.state.completions;
+
+        JudgeResult result = ReplayInput(&replay, &ev);
+
+        if (result == JUDGE_MISS)
+        {
+            stats->misses_at[pos]++;
+            in_cycle = false;
+        }
+        else if (result == JUDGE_HIT && pos == PATTERN_START && !in_cycle)
+        {
+            cycle_start = ev.timestamp_ns;
+            in_cycle = true;
+        }
+
+        if (replay.state.completions > completions)
+        {
+            if (in_cycle)
+                _addCycle(stats, ev.timestamp_ns - cycle_start);
+
+            cycle_start = ev.timestamp_ns;
+            in_cycle = true;
+        }
+    }
+
+    const ReplaySummary *summary = &replay.summary;
+    stats->inputs += summary->inputs;
+    stats->hits += summary->hits;
+    stats->misses += summary->misses;
+    stats->cycles += summary->cycles;
+    stats->duration_ns += summary->duration_ns;
+    return summary->inputs;
+}
+
+static InputEvent *_readEvents(const RecordingReader *reader, size_t *count)
+{
+    InputEvent *events = malloc((reader->record_count > 0 ? reader->record_count : 1) * sizeof(InputEvent));
+    if (events == NULL)
+        return NULL;
+
+    RecordingIter it;
+    size_t n = 0;
+
+    BeginRecordingIter(reader, &it);
+    while (n < reader->record_count && NextRecordedInput(&it, &events[n]))
+        n++;
+
+    *count = n;
+    return events;
+}
+
+static void _laneCycle(ScoreLane *lane, uint64_t ns)
+{
+    if (lane->cycle_count == lane->cycle_capacity)
+    {
+        size_t capacity = lane->cycle_capacity > 0 ? lane->cycle_capacity * 2 : 256;
+        uint16_t *grown = realloc(lane->cycles, capacity * sizeof(uint16_t));
+        if (grown == NULL)
+        {
+            lane->spilled = true;
+            return;
+        }
+
+        lane->cycles = grown;
+        lane->cycle_capacity = capacity;
+    }
+
+    lane->cycles[lane->cycle_count++] = (uint16_t)_cycleBucket(ns);
+}
+
+static void _finishScoreLane(BatchWorker *worker, GameMode *mode, ScoreGroup *group, int l)
+{
+    ScoreLane *lane = &group->lanes[l];
+    JudgeBatch *batch = &group->batch;
+    BatchStats *stats = &worker->table.stats[lane->stats];
+
+    if (batch->overflow[l] || lane->spilled)
+    {
+        // Judged again the long way, with 64 bit counts
+        RecordingReader reader;
+        if (OpenRecordingReader(&reader, lane->file->path))
+        {
+            worker->inputs += _scoreGame(stats, mode, &reader);
+            CloseRecordingReader(&reader);
+        }
+        else
+            worker->failed++;
+    }
+    else
+    {
+        ReplaySummary summary;
+        JudgeBatchSummary(batch, l, &summary);
+
+        stats->inputs += summary.inputs;
+        stats->hits += summary.hits;
+        stats->misses += summary.misses;
+        stats->cycles += summary.cycles;
+        // Every input is counted up to a quit
+        stats->duration_ns += lane->events[summary.inputs - 1].timestamp_ns - lane->events[0].timestamp_ns;
+        worker->inputs += summary.inputs;
+
+        for (int s = 0; s < stats->states; s++)
+            stats->misses_at[s] += lane->misses_at[s];
+        for (size_t c = 0; c < lane->cycle_count; c++)
+            stats->cycle_hist[lane->cycles[c]]++;
+    }
+
+    ResetJudgeLane(batch, l);
+    free(lane->events);
+    lane->events = NULL;
+    group->busy--;
+}
+
+// Every busy lane on by the same number of steps, up to where the
+// shortest one runs out. What _scoreGame() keeps per input comes from
+// the counts before and after every step, only for lanes where one of
+// them moved.
+static void _stepScoreGroup(BatchWorker *worker, GameMode *mode, ScoreGroup *group)
+{
+    BatchLanes *lanes = worker->lanes;
+    JudgeBatch *batch = &group->batch;
+    size_t steps = SCORE_CHUNK;
+
+    for (int l = 0; l < SCORE_LANES; l++)
+    {
+        const ScoreLane *lane = &group->lanes[l];
+        if (lane->events != NULL && lane->count - lane->next < steps)
+            steps = lane->count - lane->next;
+    }
+
+    for (size_t s = 0; s < steps; s++)
+    {
+        for (int l = 0; l < SCORE_LANES; l++)
+        {
+            const ScoreLane *lane = &group->lanes[l];
+            const InputEvent *ev = lane->events != NULL ? &lane->events[lane->next + s] : NULL;
+            size_t cell = s * SCORE_LANES + l;
+
+            lanes->inputs[cell] = ev != NULL ? JudgeBatchInput(ev) : JUDGE_BATCH_IDLE;
+            lanes->ts_lo[cell] = ev != NULL ? (uint32_t)ev->timestamp_ns : 0;
+            lanes->ts_hi[cell] = ev != NULL ? (uint32_t)(ev->timestamp_ns >> 32) : 0;
+        }
+    }
+
+    uint32_t pos[SCORE_LANES];
+    uint32_t hits[SCORE_LANES];
+    uint32_t misses[SCORE_LANES];
+    uint32_t completions[SCORE_LANES];
+
+    for (size_t s = 0; s < steps; s++)
+    {
+        memcpy(pos, batch->pos, sizeof(pos));
+        memcpy(hits, batch->hits, sizeof(hits));
+        memcpy(misses, batch->misses, sizeof(misses));
+        memcpy(completions, batch->completions, sizeof(completions));
+
+        size_t row = s * SCORE_LANES;
+        JudgeBatchStep(batch, lanes->inputs + row, lanes->ts_lo + row, lanes->ts_hi + row);
+
+        // A hit anywhere but the start of a cycle changes nothing here
+        uint32_t marks = 0;
+        for (int l = 0; l < SCORE_LANES; l++)
+        {
+            uint32_t starts = (batch->hits[l] != hits[l]) & (pos[l] == PATTERN_START) & !group->in_cycle[l];
+            uint32_t mark = (batch->misses[l] != misses[l]) | (batch->completions[l] != completions[l]) | starts;
+            marks |= mark << l;
+        }
+
+        for (int l = 0; marks != 0; l++, marks >>= 1)
+        {
+            if (!(marks & 1))
+                continue;
+
+            ScoreLane *lane = &group->lanes[l];
+            uint64_t ts = lane->events[lane->next + s].timestamp_ns;
+
+            if (batch->misses[l] != misses[l])
+            {
+                lane->misses_at[pos[l]]++;
+                group->in_cycle[l] = 0;
+            }
+            else if (batch->hits[l] != hits[l] && pos[l] == PATTERN_START && !group->in_cycle[l])
+            {
+                group->cycle_start[l] = ts;
+                group->in_cycle[l] = 1;
+            }
+
+            if (batch->completions[l] != completions[l])
+            {
+                if (group->in_cycle[l])
+                    _laneCycle(lane, ts - group->cycle_start[l]);
+
+                group->cycle_start[l] = ts;
+                group->in_cycle[l] = 1;
+            }
+        }
+    }
+
+    for (int l = 0; l < SCORE_LANES; l++)
+    {
+        ScoreLane *lane = &group->lanes[l];
+        if (lane->events == NULL)
+            continue;
+
+        lane->next += steps;
+        if (lane->next == lane->count)
+            _finishScoreLane(worker, mode, group, l);
+    }
+}
+
+// Reads the recording into a free lane of its mode's batch, stepping the
+// batch until one frees up. False if the mode can't be batched.
+static bool _queueLane(BatchWorker *worker, const ModeRegistry *modes, int index, int stats, const BatchFile *file, const RecordingReader *reader)
+{
+    ScoreGroup *group = &worker->lanes->groups[index];
+    GameMode *mode = &modes->modes[index];
+
+    if (!group->tried)
+    {
+        group->tried = true;
+        group->ready = InitJudgeBatch(&group->batch, mode, SCORE_LANES);
+    }
+
+    // Nothing to step through
+    if (!group->ready || reader->record_count == 0)
+        return false;
+
+    while (group->busy == SCORE_LANES)
+        _stepScoreGroup(worker, mode, group);
+
+    int l = 0;
+    while (group->lanes[l].events != NULL)
+        l++;
+
+    ScoreLane *lane = &group->lanes[l];
+    lane->events = _readEvents(reader, &lane->count);
+    if (lane->events == NULL)
+        return false;
+
+    if (lane->count == 0)
+    {
+        free(lane->events);
+        lane->events = NULL;
+        return false;
+    }
+
+    lane->file = file;
+    lane->stats = stats;
+    lane->next = 0;
+    group->in_cycle[l] = 0;
+    memset(lane->misses_at, 0, sizeof(lane->misses_at));
+    lane->cycle_count = 0;
+    lane->spilled = false;
+
+    group->busy++;
+    return true;
+}
+
+void FinishBatchWorker(BatchWorker *worker, const ModeRegistry *modes)
+{
+    BatchLanes *lanes = worker->lanes;
+    for (int g = 0; lanes != NULL && g < lanes->count; g++)
+    {
+        while (lanes->groups[g].busy > 0)
+            _stepScoreGroup(worker, &modes->modes[g], &lanes->groups[g]);
+    }
+}
+
+uint64_t ScoreRecording(BatchWorker *worker, const ModeRegistry *modes, const BatchFile *file)
+{
+    RecordingReader reader;
+    if (!OpenRecordingReader(&reader, file->path))
+    {
+        worker->failed++;
+        return 0;
+    }
+
+    char name[RECORDING_NAME_SIZE];
+    snprintf(name, sizeof(name), "%.*s", RECORDING_NAME_SIZE - 1, reader.header->mode_name);
+
+    // Judge the way the game does today, with step windows, when the mode
+    // still exists. Otherwise by the order stored in the recording.
+    int index = name[0] != '\0' ? FindGameMode(modes, name) : -1;
+    GameMode *mode = index >= 0 ? &modes->modes[index] : NULL;
+
+    // Played in free practice, there's no pattern stored then
+    bool practice = mode != NULL ? mode->free_practice : reader.header->pattern_size == 0;
+
+    GameDirection pattern[RECORDING_MAX_PATTERN];
+    PatternDfa dfa;
+    GameMode recorded;
+    if (mode == NULL && !practice && GameModeFromRecording(reader.header, &recorded, pattern, &dfa))
+        mode = &recorded;
+
+    // Nothing to judge it against
+    if (mode == NULL && !practice)
+    {
+        CloseRecordingReader(&reader);
+        worker->failed++;
+        return 0;
+    }
+
+    BatchStats *stats = practice
+        ? _findStats(&worker->table, file->player, name[0] != '\0' ? name : "?", NULL, 0)
+        : _findStats(&worker->table, file->player, name[0] != '\0' ? name : "?", mode->dfa->hint, mode->dfa->state_count);
+    uint64_t inputs = 0;
+    // Read into a lane, counted in worker->inputs once that finishes
+    uint64_t queued = 0;
+
+    if (stats == NULL)
+        worker->failed++;
+    else if (practice)
+        inputs = _scorePractice(worker, stats, &reader);
+    else if (index >= 0 && worker->lanes != NULL
+        && _queueLane(worker, modes, index, (int)(stats - worker->table.stats), file, &reader))
+        queued = reader.record_count;
+    else
+        inputs = _scoreGame(stats, mode, &reader);
+
+    if (stats != NULL)
+        stats->files++;
+
+    CloseRecordingReader(&reader);
+
+    worker->inputs += inputs;
+    return inputs + queued;
+}
+
+void MergeBatchTable(BatchTable *into, const BatchTable *from)
+{
+    for (int i = 0; i < from->count; i++)
+    {
+        const BatchStats *src = &from->stats[i];
+        BatchStats *dst = _findStats(into, src->player, src->mode_name,
+            src->practice ? NULL : src->expected, src->states);
+        if (dst == NULL)
+            continue;
+
+        dst->files += src->files;
+        dst->inputs += src->inputs;
+        dst->hits += src->hits;
+        dst->misses += src->misses;
+        dst->cycles += src->cycles;
+        dst->duration_ns += src->duration_ns;
+
+        for (int s = 0; s < PATTERN_MAX_STATES; s++)
+            dst->misses_at[s] += src->misses_at[s];
+
+        for (int b = 0; b < BATCH_CYCLE_BUCKETS; b++)
+            dst->cycle_hist[b] += src->cycle_hist[b];
+    }
+}
+
+void DestroyBatchTable(BatchTable *table)
+{
+    free(table->stats);
+    memset(table, 0, sizeof(*table));
+}
+
+uint64_t CyclePercentileNs(const BatchStats *stats, double p)
+{
+    uint64_t total = 0;
+    for (int b = 0; b < BATCH_CYCLE_BUCKETS; b++)
+        total += stats->cycle_hist[b];
+
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t)(p * (double)(total - 1)) + 1;
+    uint64_t seen = 0;
+
+    for (int b = 0; b < BATCH_CYCLE_BUCKETS; b++)
+    {
+        seen += stats->cycle_hist[b];
+        if (seen >= rank)
+            return (uint64_t)(b + 1) * BATCH_CYCLE_BUCKET_NS;
+    }
+
+    return BATCH_CYCLE_BUCKETS * BATCH_CYCLE_BUCKET_NS;
+}
+
+// The three inputs missed most, by the direction that was expected
+static void _printMisses(const BatchStats *stats)
+{
+    uint64_t by_dir[PATTERN_COLUMNS] = {0};
+
+    for (int s = 0; s < PATTERN_MAX_STATES; s++)
+    {
+        if (stats->expected[s] < PATTERN_COLUMNS)
+            by_dir[stats->expected[s]] += stats->misses_at[s];
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        int best = -1;
+        for (int d = 0; d < PATTERN_COLUMNS; d++)
+        {
+            if (by_dir[d] > 0 && (best < 0 || by_dir[d] > by_dir[best]))
+                best = d;
+        }
+
+        if (best < 0)
+            break;
+
+        printf(" %s %.0f%%", DirectionName((GameDirection)best), 100.0 * by_dir[best] / stats->misses);
+        by_dir[best] = 0;
+    }
+}
+
+static int _compareStats(const BatchStats *a, const BatchStats *b, const BatchArchive *archive)
+{
+    int order = strcmp(archive->players[a->player], archive->players[b->player]);
+    return order != 0 ? order : strcmp(a->mode_name, b->mode_name);
+}
+
+void PrintBatchTable(const BatchTable *table, const BatchArchive *archive)
+{
+    // Few enough rows for an insertion sort, by player then mode
+    int *order = malloc((table->count > 0 ? table->count : 1) * sizeof(int));
+    if (order == NULL)
+        return;
+
+    for (int i = 0; i < table->count; i++)
+    {
+        int j = i;
+        while (j > 0 && _compareStats(&table->stats[order[j - 1]], &table->stats[i], archive) > 0)
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    printf("%-16s %-16s %6s %10s %8s %23s  %s\n",
+        "player", "mode", "files", "inputs", "accuracy", "cycle ms p50/p90/p99", "missed most");
+
+    for (int i = 0; i < table->count; i++)
+    {
+        const BatchStats *stats = &table->stats[order[i]];
+
+        printf("%-16s %-16s %6llu %10llu ",
+            archive->players[stats->player], stats->mode_name,
+            (unsigned long long)stats->files, (unsigned long long)stats->inputs);
+
+        if (stats->practice)
+        {
+            printf("%8s %23llu  techniques\n", "-", (unsigned long long)stats->cycles);
+            continue;
+        }
+
+        uint64_t judged = stats->hits + stats->misses;
+        printf("%7.1f%% %7.1f/%7.1f/%7.1f ",
+            judged > 0 ? 100.0 * stats->hits / judged : 0.0,
+            CyclePercentileNs(stats, 0.50) / 1e6,
+            CyclePercentileNs(stats, 0.90) / 1e6,
+            CyclePercentileNs(stats, 0.99) / 1e6);
+
+        _printMisses(stats);
+        printf("\n");
+    }
+
+    free(order);
+}
+
+// Recordings judged side by side by VerifyBatchJudge(), and how many
+// steps they get at a time
+#define VERIFY_LANES 64
+#define VERIFY_CHUNK 256
+
+typedef struct {
+    const char *path;
+    InputEvent *events;
+    size_t count;
+    size_t next;
+    ReplaySummary expected;
+} VerifyLane;
+
+typedef struct {
+    JudgeBatch batches[JUDGE_KERNEL_COUNT];
+    bool ready[JUDGE_KERNEL_COUNT];
+    VerifyLane lanes[VERIFY_LANES];
+
+    uint8_t inputs[VERIFY_CHUNK * VERIFY_LANES];
+    uint32_t ts_lo[VERIFY_CHUNK * VERIFY_LANES];
+    uint32_t ts_hi[VERIFY_CHUNK * VERIFY_LANES];
+
+    uint64_t recordings;
+    uint64_t skipped;
+    uint64_t overflowed;
+    uint64_t mismatches;
+
+    uint64_t inputs_total;
+    uint64_t cells;
+    uint64_t replay_ns;
+    uint64_t kernel_ns[JUDGE_KERNEL_COUNT];
+} Verifier;
+
+static bool _sameSummary(const ReplaySummary *a, const ReplaySummary *b)
+{
+    for (int v = 0; v < TIMING_COUNT; v++)
+    {
+        if (a->timing[v] != b->timing[v])
+            return false;
+    }
+
+    return a->inputs == b->inputs && a->hits == b->hits && a->misses == b->misses &&
+        a->paused == b->paused && a->resets == b->resets && a->cycles == b->cycles &&
+        a->score == b->score && a->highscore == b->highscore && a->quit == b->quit;
+}
+
+// Mode index of a recording, -1 if it isn't one the batch judge can take
+static int _batchableMode(const ModeRegistry *modes, const BatchFile *file)
+{
+    RecordingReader reader;
+    if (!OpenRecordingReader(&reader, file->path))
+        return -1;
+
+    // Only modes in the registry, there's nothing to batch a pattern
+    // that lives in one recording with
+    char name[RECORDING_NAME_SIZE];
+    snprintf(name, sizeof(name), "%.*s", RECORDING_NAME_SIZE - 1, reader.header->mode_name);
+    int index = name[0] != '\0' ? FindGameMode(modes, name) : -1;
+    CloseRecordingReader(&reader);
+
+    return index >= 0 && !modes->modes[index].free_practice ? index : -1;
+}
+
+// Reads the recording and judges it the scalar way for reference
+static bool _loadLane(Verifier *v, VerifyLane *lane, GameMode *mode, const BatchFile *file)
+{
+    RecordingReader reader;
+    if (!OpenRecordingReader(&reader, file->path))
+        return false;
+
+    lane->events = _readEvents(&reader, &lane->count);
+    CloseRecordingReader(&reader);
+    if (lane->events == NULL)
+        return false;
+
+    lane->path = file->path;
+    lane->next = 0;
+
+    Replay replay;
+    InitReplay(&replay, mode, 0);
+
+    Uint64 start = SDL_GetTicksNS();
+    ReplayInputs(&replay, lane->events, lane->count, NULL);
+    v->replay_ns += SDL_GetTicksNS() - start;
+
+    lane->expected = replay.summary;
+    v->inputs_total += lane->count;
+    return true;
+}
+
+static void _finishLane(Verifier *v, int l)
+{
+    VerifyLane *lane = &v->lanes[l];
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        if (!v->ready[k])
+            continue;
+
+        JudgeBatch *batch = &v->batches[k];
+        ReplaySummary summary;
+        JudgeBatchSummary(batch, l, &summary);
+
+        if (batch->overflow[l])
+            v->overflowed += k == JUDGE_KERNEL_SCALAR;
+        else if (!_sameSummary(&summary, &lane->expected))
+        {
+            printf("%s: %s judge disagrees, %llu hits %llu misses, replay has %llu hits %llu misses\n",
+                lane->path, JudgeKernelName((JudgeKernel)k),
+                (unsigned long long)summary.hits, (unsigned long long)summary.misses,
+                (unsigned long long)lane->expected.hits, (unsigned long long)lane->expected.misses);
+            v->mismatches++;
+        }
+
+        ResetJudgeLane(batch, l);
+    }
+
+    free(lane->events);
+    lane->events = NULL;
+    v->recordings++;
+}
+
+// Every recording of one mode through every kernel. Lanes that run out
+// take the next recording, so they all stay busy until the last few.
+static void _verifyMode(Verifier *v, GameMode *mode, const BatchArchive *archive, const int *file_modes, int index)
+{
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        v->ready[k] = InitJudgeBatch(&v->batches[k], mode, VERIFY_LANES);
+        if (v->ready[k] && !SetJudgeKernel(&v->batches[k], (JudgeKernel)k))
+        {
+            DestroyJudgeBatch(&v->batches[k]);
+            v->ready[k] = false;
+        }
+    }
+
+    size_t file = 0;
+
+    for (;;)
+    {
+        size_t steps = VERIFY_CHUNK;
+        bool busy = false;
+
+        for (int l = 0; l < VERIFY_LANES; l++)
+        {
+            VerifyLane *lane = &v->lanes[l];
+
+            while (lane->events == NULL || lane->next == lane->count)
+            {
+                if (lane->events != NULL)
+                    _finishLane(v, l);
+
+                while (file < archive->count && file_modes[file] != index)
+                    file++;
+                if (file == archive->count)
+                    break;
+
+                if (!_loadLane(v, lane, mode, &archive->files[file++]))
+                    v->skipped++;
+            }
+
+            if (lane->events != NULL)
+            {
+                busy = true;
+                if (lane->count - lane->next < steps)
+                    steps = lane->count - lane->next;
+            }
+        }
+
+        if (!busy)
+            break;
+
+        // One row per step, empty lanes sit idle
+        for (size_t s = 0; s < steps; s++)
+        {
+            for (int l = 0; l < VERIFY_LANES; l++)
+            {
+                const VerifyLane *lane = &v->lanes[l];
+                const InputEvent *ev = lane->events != NULL ? &lane->events[lane->next + s] : NULL;
+                size_t cell = s * VERIFY_LANES + l;
+
+                v->inputs[cell] = ev != NULL ? JudgeBatchInput(ev) : JUDGE_BATCH_IDLE;
+                v->ts_lo[cell] = ev != NULL ? (uint32_t)ev->timestamp_ns : 0;
+                v->ts_hi[cell] = ev != NULL ? (uint32_t)(ev->timestamp_ns >> 32) : 0;
+            }
+        }
+
+        for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+        {
+            if (!v->ready[k])
+                continue;
+
+            Uint64 start = SDL_GetTicksNS();
+            for (size_t s = 0; s < steps; s++)
+            {
+                size_t row = s * VERIFY_LANES;
+                JudgeBatchStep(&v->batches[k], v->inputs + row, v->ts_lo + row, v->ts_hi + row);
+            }
+            v->kernel_ns[k] += SDL_GetTicksNS() - start;
+        }
+
+        for (int l = 0; l < VERIFY_LANES; l++)
+        {
+            if (v->lanes[l].events != NULL)
+                v->lanes[l].next += steps;
+        }
+        v->cells += steps * VERIFY_LANES;
+    }
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        if (v->ready[k])
+            DestroyJudgeBatch(&v->batches[k]);
+    }
+}
+
+bool VerifyBatchJudge(const BatchArchive *archive, const ModeRegistry *modes)
+{
+    Verifier *v = calloc(1, sizeof(Verifier));
+    int *file_modes = malloc((archive->count > 0 ? archive->count : 1) * sizeof(int));
+    if (v == NULL || file_modes == NULL)
+    {
+        free(v);
+        free(file_modes);
+        return false;
+    }
+
+    for (size_t i = 0; i < archive->count; i++)
+    {
+        file_modes[i] = _batchableMode(modes, &archive->files[i]);
+        v->skipped += file_modes[i] < 0;
+    }
+
+    bool ran[JUDGE_KERNEL_COUNT] = {0};
+    for (int m = 0; m < modes->count; m++)
+    {
+        _verifyMode(v, &modes->modes[m], archive, file_modes, m);
+        for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+            ran[k] |= v->ready[k];
+    }
+
+    printf("%llu recordings judged %d at a time, %llu skipped, %llu with scores past 32 bits, lanes %.0f%% busy\n",
+        (unsigned long long)v->recordings, VERIFY_LANES, (unsigned long long)v->skipped,
+        (unsigned long long)v->overflowed, v->cells > 0 ? 100.0 * v->inputs_total / v->cells : 0);
+
+    double replay = v->replay_ns > 0 ? v->inputs_total / (v->replay_ns / 1e9) : 0;
+    printf("  %-8s %8.1fM inputs/s\n", "replay", replay / 1e6);
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        if (!ran[k])
+            continue;
+
+        double rate = v->kernel_ns[k] > 0 ? v->inputs_total / (v->kernel_ns[k] / 1e9) : 0;
+        printf("  %-8s %8.1fM inputs/s, %.1fx\n", JudgeKernelName((JudgeKernel)k), rate / 1e6, replay > 0 ? rate / replay : 0);
+    }
+
+    bool same = v->mismatches == 0;
+    printf("%llu mismatches\n", (unsigned long long)v->mismatches);
+
+    free(file_modes);
+    free(v);
+    return same;
+}
@@ -0,0 +1,329 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <SDL3/SDL.h>
+
+#include "attempt_store.h"
+#include "batch.h"
+#include "modes.h"
+#include "work_pool.h"
+
+#define PROGRESS_INTERVAL_NS 1000000000ULL
+
+// How often the main thread checks whether the pool is done
+#define POLL_INTERVAL_MS 5
+
+typedef struct {
+    const BatchArchive *archive;
+    const ModeRegistry *modes;
+    BatchWorker *workers;
+
+    // Inputs per worker for the progress line. Wraps, only the change
+    // between two reads is used.
+    SDL_AtomicInt *events;
+} BatchJob;
+
+static void _scoreItem(void *ctx, int worker, size_t item)
+{
+    BatchJob *job = ctx;
+    uint64_t inputs = ScoreRecording(&job->workers[worker], job->modes, &job->archive->files[item]);
+    SDL_AddAtomicInt(&job->events[worker], (int)(uint32_t)inputs);
+}
+
+static void _finishItem(void *ctx, int worker, size_t item)
+{
+    (void)worker;
+    BatchJob *job = ctx;
+    FinishBatchWorker(&job->workers[item], job->modes);
+}
+
+static uint32_t _eventsSeen(const BatchJob *job, int workers)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < workers; i++)
+        total += (uint32_t)SDL_GetAtomicInt(&job->events[i]);
+
+    return total;
+}
+
+static const char *_parseStringArg(int argc, char *argv[], const char *prefix)
+{
+    size_t len = strlen(prefix);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], prefix, len) == 0)
+            return argv[i] + len;
+    }
+
+    return NULL;
+}
+
+static bool _hasFlag(int argc, char *argv[], const char *flag)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], flag) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static void _printAttemptMode(const AttemptStore *store, int mode, uint64_t from_ns, int days)
+{
+    const uint64_t DAY_NS = 86400ULL * 1000000000ULL;
+
+    // Step and cycle stats are over everything kept, not just the days shown
+    AttemptQuery all = { mode, 0, 0 };
+    uint64_t reached[ATTEMPT_STEP_LIMIT];
+    uint64_t missed[ATTEMPT_STEP_LIMIT];
+    uint64_t clipped = QueryStepMisses(store, &all, reached, missed);
+
+    // Every attempt has a first step
+    if (reached[0] == 0)
+        return;
+
+    AttemptQuery query = { mode, from_ns, 0 };
+    AccuracyBucket *buckets = calloc(days, sizeof(AccuracyBucket));
+    if (buckets == NULL)
+        return;
+
+    QueryAccuracy(store, &query, DAY_NS, buckets, days);
+
+    printf("\n%s\n", store->mode_names[mode]);
+    for (int d = 0; d < days; d++)
+    {
+        if (buckets[d].attempts == 0)
+            continue;
+
+        char date[16];
+        time_t day = (time_t)(buckets[d].start_ns / 1000000000ULL);
+        strftime(date, sizeof(date), "%Y-%m-%d", localtime(&day));
+
+        printf("  %s %8llu attempts %6.1f%%\n", date, (unsigned long long)buckets[d].attempts,
+            100.0 * buckets[d].done / buckets[d].attempts);
+    }
+
+    for (int k = 0; k < ATTEMPT_STEP_LIMIT && reached[k] > 0; k++)
+    {
+        printf("  step %-2d %10llu reached %6.2f%% missed\n", k + 1, (unsigned long long)reached[k],
+            100.0 * missed[k] / reached[k]);
+    }
+
+    if (clipped > 0)
+    {
+        printf("  %llu attempts ran past step %d, their later holds weren't kept\n",
+            (unsigned long long)clipped, ATTEMPT_MAX_STEPS);
+    }
+
+    const double p[] = { 0.5, 0.9, 0.99 };
+    uint64_t cycle[3];
+    uint64_t done = QueryCyclePercentiles(store, &all, p, cycle, 3);
+    if (done > 0)
+    {
+        printf("  cycle p50 %.1f ms, p90 %.1f ms, p99 %.1f ms over %llu finished\n",
+            cycle[0] / 1e6, cycle[1] / 1e6, cycle[2] / 1e6, (unsigned long long)done);
+    }
+
+    free(buckets);
+}
+
+// Accuracy a day at a time up to the latest attempt, misses by step and
+// cycle times, for one mode or every one in the store
+static int _printAttempts(const char *dir, const char *modeName, int days)
+{
+    AttemptStore store;
+    if (!OpenAttemptStore(&store, dir))
+        return 1;
+
+    int only = modeName != NULL ? FindAttemptMode(&store, modeName) : ATTEMPT_ANY_MODE;
+    if (modeName != NULL && only < 0)
+    {
+        printf("No attempts at %s in %s\n", modeName, dir);
+        CloseAttemptStore(&store);
+        return 1;
+    }
+
+    printf("%zu attempts in %s, scanning with %s\n", store.count, dir, AttemptScanKernel());
+    if (store.count == 0)
+    {
+        CloseAttemptStore(&store);
+        return 0;
+    }
+
+    // Local midnight of the latest attempt's day, days - 1 days back
+    time_t last = (time_t)(store.start[store.count - 1] / 1000000000ULL);
+    struct tm midnight = *localtime(&last);
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+
+    int64_t from = ((int64_t)mktime(&midnight) - (int64_t)(days - 1) * 86400) * 1000000000LL;
+
+    Uint64 start = SDL_GetTicksNS();
+    for (int m = 0; m < store.mode_count; m++)
+    {
+        if (only < 0 || m == only)
+            _printAttemptMode(&store, m, from > 0 ? (uint64_t)from : 0, days);
+    }
+
+    printf("\nQueried in %.1f ms\n", (SDL_GetTicksNS() - start) / 1e6);
+    CloseAttemptStore(&store);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Reports on the attempt store the game keeps instead of an archive
+    const char *attempts = _parseStringArg(argc, argv, "--attempts=");
+    if (attempts != NULL)
+    {
+        const char *days = _parseStringArg(argc, argv, "--days=");
+        int dayCount = days != NULL ? atoi(days) : 30;
+        return _printAttempts(attempts, _parseStringArg(argc, argv, "--mode="), dayCount > 0 ? dayCount : 30);
+    }
+
+    const char *root = NULL;
+    for (int i = 1; i < argc && root == NULL; i++)
+    {
+        if (strncmp(argv[i], "--", 2) != 0)
+            root = argv[i];
+    }
+
+    if (root == NULL)
+    {
+        printf("Usage: kbd-batch <dir> [--threads=<n>] [--modes=<file>] [--scalar] [--verify]\n"
+               "       kbd-batch --attempts=<dir> [--mode=<name>] [--days=<n>]\n");
+        return 1;
+    }
+
+    const char *threads = _parseStringArg(argc, argv, "--threads=");
+    int threadCount = threads != NULL ? atoi(threads) : 0;
+
+    ModeRegistry modes;
+    if (!LoadGameModes(&modes, _parseStringArg(argc, argv, "--modes=")))
+        return 1;
+
+    BatchArchive archive;
+    if (!ScanBatchArchive(&archive, root))
+    {
+        DestroyModeRegistry(&modes);
+        return 1;
+    }
+
+    printf("%zu recordings, %d players, %.1f MB\n", archive.count, archive.player_count, archive.bytes / 1e6);
+
+    // Checks the batch judge instead of scoring, on one thread
+    if (_hasFlag(argc, argv, "--verify"))
+    {
+        bool same = VerifyBatchJudge(&archive, &modes);
+        DestroyBatchArchive(&archive);
+        DestroyModeRegistry(&modes);
+        return same ? 0 : 1;
+    }
+
+    int workers = threadCount > 0 ? threadCount : SDL_GetNumLogicalCPUCores();
+    if (workers <= 0)
+        workers = 1;
+
+    BatchJob job = { &archive, &modes, NULL, NULL };
+    job.workers = malloc(workers * sizeof(BatchWorker));
+    job.events = calloc(workers, sizeof(SDL_AtomicInt));
+    if (job.workers == NULL || job.events == NULL)
+    {
+        printf("Error allocating %d workers\n", workers);
+        return 1;
+    }
+
+    // --scalar judges every recording with ReplayInput(), for comparing
+    bool lanes = !_hasFlag(argc, argv, "--scalar");
+    for (int i = 0; i < workers; i++)
+    {
+        if (!InitBatchWorker(&job.workers[i], &modes, lanes))
+        {
+            printf("Error allocating %d workers\n", workers);
+            return 1;
+        }
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    WorkPool *pool = StartWorkPool(workers, archive.count, _scoreItem, &job);
+    if (pool == NULL)
+    {
+        printf("Error starting the worker pool\n");
+        return 1;
+    }
+
+    uint32_t lastSeen = 0;
+    size_t lastDone = 0;
+    Uint64 lastTick = start;
+
+    while (!WorkPoolIdle(pool))
+    {
+        SDL_Delay(POLL_INTERVAL_MS);
+
+        Uint64 now = SDL_GetTicksNS();
+        if (now - lastTick < PROGRESS_INTERVAL_NS)
+            continue;
+
+        double seconds = (now - lastTick) / 1e9;
+        uint32_t seen = _eventsSeen(&job, workers);
+        size_t done = WorkPoolDone(pool);
+
+        printf("  %zu/%zu files, %.0f files/s, %.1fM events/s\n",
+            done, archive.count,
+            (done - lastDone) / seconds,
+            (uint32_t)(seen - lastSeen) / seconds / 1e6);
+
+        lastSeen = seen;
+        lastDone = done;
+        lastTick = now;
+    }
+
+    int poolWorkers = WorkPoolWorkers(pool);
+    uint64_t steals = WorkPoolSteals(pool);
+    FinishWorkPool(pool);
+
+    // Each worker's last few recordings per mode are still in lanes, one
+    // item per worker so those finish in parallel too
+    pool = StartWorkPool(workers, workers, _finishItem, &job);
+    if (pool == NULL)
+    {
+        printf("Error starting the worker pool\n");
+        return 1;
+    }
+    FinishWorkPool(pool);
+
+    Uint64 wallTime = SDL_GetTicksNS() - start;
+    double seconds = wallTime > 0 ? wallTime / 1e9 : 1e-9;
+
+    // Per worker tables only meet here, after every thread is done
+    BatchTable total = {0};
+    uint64_t inputs = 0;
+    uint64_t failed = 0;
+
+    for (int i = 0; i < workers; i++)
+    {
+        MergeBatchTable(&total, &job.workers[i].table);
+        inputs += job.workers[i].inputs;
+        failed += job.workers[i].failed;
+        DestroyBatchWorker(&job.workers[i]);
+    }
+
+    printf("\n");
+    PrintBatchTable(&total, &archive);
+
+    printf("\n%zu files (%llu unreadable or unscorable), %llu events in %.2fs on %d threads, %llu steals: %.0f files/s, %.1fM events/s\n",
+        archive.count, (unsigned long long)failed, (unsigned long long)inputs, seconds, poolWorkers,
+        (unsigned long long)steals, archive.count / seconds, inputs / seconds / 1e6);
+
+    DestroyBatchTable(&total);
+    free(job.workers);
+    free(job.events);
+    DestroyBatchArchive(&archive);
+    DestroyModeRegistry(&modes);
+    return 0;
+}
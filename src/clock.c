@@ -0,0 +1,109 @@
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "clock.h"
+
+static const char *clock_names[GAME_CLOCK_COUNT] = {
+    "realtime",
+    "raw",
+    "simulated"
+};
+
+const char *GameClockName(GameClockKind kind)
+{
+    if (kind < 0 || kind >= GAME_CLOCK_COUNT)
+        return "?";
+    return clock_names[kind];
+}
+
+static uint64_t _realtimeNow(GameClock *clock)
+{
+    return SDL_GetTicksNS() + clock->ns;
+}
+
+static uint64_t _rawCounter()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER count;
+
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+
+    // Split to avoid overflowing the multiply on long uptimes
+    uint64_t secs = count.QuadPart / freq.QuadPart;
+    uint64_t rest = count.QuadPart % freq.QuadPart;
+    return secs * 1000000000ULL + rest * 1000000000ULL / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC_RAW)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return SDL_GetTicksNS();
+#endif
+}
+
+static uint64_t _rawNow(GameClock *clock)
+{
+    return _rawCounter() - clock->ns;
+}
+
+// Both live clocks tick at the same rate, only the origin differs
+static void _liveSleepUntil(GameClock *clock, uint64_t deadline_ns)
+{
+    uint64_t now = clock->now(clock);
+    if (deadline_ns > now)
+        SDL_DelayPrecise(deadline_ns - now);
+}
+
+static uint64_t _simulatedNow(GameClock *clock)
+{
+    return clock->ns;
+}
+
+static void _simulatedSleepUntil(GameClock *clock, uint64_t deadline_ns)
+{
+    if (deadline_ns > clock->ns)
+        clock->ns = deadline_ns;
+}
+
+bool InitGameClock(GameClock *clock, GameClockKind kind, uint64_t start_ns)
+{
+    clock->kind = kind;
+
+    switch (kind)
+    {
+        case GAME_CLOCK_REALTIME:
+            clock->now = _realtimeNow;
+            clock->sleep_until = _liveSleepUntil;
+            clock->ns = start_ns - SDL_GetTicksNS();
+            return true;
+        case GAME_CLOCK_MONOTONIC_RAW:
+            clock->now = _rawNow;
+            clock->sleep_until = _liveSleepUntil;
+            clock->ns = _rawCounter() - start_ns;
+            return true;
+        case GAME_CLOCK_SIMULATED:
+            clock->now = _simulatedNow;
+            clock->sleep_until = _simulatedSleepUntil;
+            clock->ns = start_ns;
+            return true;
+        default:
+            printf("Unknown clock %d\n", kind);
+            return false;
+    }
+}
+
+void AdvanceGameClock(GameClock *clock, uint64_t ns)
+{
+    if (clock->kind == GAME_CLOCK_SIMULATED)
+        clock->ns += ns;
+}
@@ -0,0 +1,226 @@
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "flight_recorder.h"
+#include "input.h"
+#include "notation.h"
+
+FlightRecord flight_records[FLIGHT_RECORDER_SIZE];
+SDL_AtomicInt flight_head;
+
+// Built once up front, nothing is formatted while crashing
+static char flight_path[512] = FLIGHT_RECORDER_DEFAULT_PATH;
+static volatile sig_atomic_t flight_armed = 0;
+
+static const char *_phaseNames[FLIGHT_PHASE_COUNT] = {
+    [FLIGHT_PHASE_POLL]    = "poll",
+    [FLIGHT_PHASE_UPDATE]  = "update",
+    [FLIGHT_PHASE_RENDER]  = "render",
+    [FLIGHT_PHASE_PRESENT] = "present",
+    [FLIGHT_PHASE_FRAME]   = "frame"
+};
+
+static const char *_verdictNames[] = { "none", "hit", "miss", "paused", "quit" };
+
+// Only calls that are safe in a signal handler from here on
+static bool _dump()
+{
+    uint32_t head = (uint32_t)SDL_GetAtomicInt(&flight_head);
+    uint32_t count = head < FLIGHT_RECORDER_SIZE ? head : FLIGHT_RECORDER_SIZE;
+    uint32_t oldest = (head - count) & (FLIGHT_RECORDER_SIZE - 1);
+
+    FlightDumpHeader header = {0};
+    memcpy(header.magic, FLIGHT_RECORDER_MAGIC, 4);
+    header.version = FLIGHT_RECORDER_VERSION;
+    header.record_size = sizeof(FlightRecord);
+    header.count = count;
+
+    // Oldest to the end of the array, then the start of it up to the newest
+    uint32_t first = count < FLIGHT_RECORDER_SIZE - oldest ? count : FLIGHT_RECORDER_SIZE - oldest;
+    const void *parts[3] = { &header, &flight_records[oldest], &flight_records[0] };
+    size_t sizes[3] = { sizeof(header), first * sizeof(FlightRecord), (count - first) * sizeof(FlightRecord) };
+    bool ok = true;
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(flight_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        DWORD written = 0;
+        if (sizes[i] > 0)
+            ok &= WriteFile(file, parts[i], (DWORD)sizes[i], &written, NULL) && written == sizes[i];
+    }
+
+    CloseHandle(file);
+#else
+    int fd = open(flight_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (sizes[i] > 0)
+            ok &= write(fd, parts[i], sizes[i]) == (ssize_t)sizes[i];
+    }
+
+    close(fd);
+#endif
+
+    return ok;
+}
+
+static void _crashHandler(int sig)
+{
+    if (flight_armed)
+        _dump();
+    flight_armed = 0;
+
+    // Let it die the way it was going to
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+#ifdef _WIN32
+static LONG WINAPI _crashFilter(EXCEPTION_POINTERS *info)
+{
+    if (flight_armed)
+        _dump();
+    flight_armed = 0;
+
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+static void _dumpAtExit()
+{
+    if (flight_armed)
+        _dump();
+}
+
+void InitFlightRecorder(const char *path)
+{
+    if (path != NULL)
+        snprintf(flight_path, sizeof(flight_path), "%s", path);
+
+    if (!flight_armed)
+    {
+        signal(SIGSEGV, _crashHandler);
+        signal(SIGABRT, _crashHandler);
+        signal(SIGFPE, _crashHandler);
+        signal(SIGILL, _crashHandler);
+#ifdef _WIN32
+        SetUnhandledExceptionFilter(_crashFilter);
+#else
+        signal(SIGBUS, _crashHandler);
+#endif
+        atexit(_dumpAtExit);
+    }
+
+    flight_armed = 1;
+}
+
+void CloseFlightRecorder()
+{
+    flight_armed = 0;
+}
+
+bool DumpFlightRecorder()
+{
+    bool ok = _dump();
+    if (ok)
+        printf("Flight recorder written to %s\n", flight_path);
+    else
+        printf("Error writing flight recorder to %s\n", flight_path);
+
+    return ok;
+}
+
+bool PrintFlightDump(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Error opening flight recorder dump %s\n", path);
+        return false;
+    }
+
+    FlightDumpHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || memcmp(header.magic, FLIGHT_RECORDER_MAGIC, 4) != 0
+        || header.version != FLIGHT_RECORDER_VERSION
+        || header.record_size != sizeof(FlightRecord)
+        || header.count > FLIGHT_RECORDER_SIZE)
+    {
+        printf("%s is not a flight recorder dump this version can read\n", path);
+        fclose(file);
+        return false;
+    }
+
+    FlightRecord *records = malloc(header.count * sizeof(FlightRecord) + 1);
+    uint32_t count = records != NULL ? (uint32_t)fread(records, sizeof(FlightRecord), header.count, file) : 0;
+    fclose(file);
+
+    uint64_t start = count > 0 ? records[0].timestamp_ns : 0;
+    uint64_t total[FLIGHT_PHASE_COUNT] = {0};
+    uint64_t frames[FLIGHT_PHASE_COUNT] = {0};
+    uint32_t worst[FLIGHT_PHASE_COUNT] = {0};
+    double worst_at[FLIGHT_PHASE_COUNT] = {0};
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const FlightRecord *rec = &records[i];
+        double ms = rec->timestamp_ns >= start ? (rec->timestamp_ns - start) / 1e6 : -((start - rec->timestamp_ns) / 1e6);
+
+        switch (rec->kind)
+        {
+            case FLIGHT_INPUT:
+                printf("%12.3f ms  input    %s%s%s\n", ms,
+                    rec->a <= UP_BACK ? DirectionName((GameDirection)rec->a) : "?",
+                    (rec->b & INPUT_BUTTON_SELECT) ? " select" : "",
+                    (rec->b & INPUT_BUTTON_BACK) ? " back" : "");
+                break;
+            case FLIGHT_VERDICT:
+                printf("%12.3f ms  verdict  %s\n", ms, rec->a < sizeof(_verdictNames) / sizeof(*_verdictNames) ? _verdictNames[rec->a] : "?");
+                break;
+            case FLIGHT_PHASE:
+                if (rec->a >= FLIGHT_PHASE_COUNT)
+                    break;
+
+                printf("%12.3f ms  %-8s %.3f ms\n", ms, _phaseNames[rec->a], rec->value / 1e6);
+                total[rec->a] += rec->value;
+                frames[rec->a]++;
+                if (rec->value >= worst[rec->a])
+                {
+                    worst[rec->a] = rec->value;
+                    worst_at[rec->a] = ms;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    printf("%u records\n", count);
+    for (int phase = 0; phase < FLIGHT_PHASE_COUNT; phase++)
+    {
+        if (frames[phase] == 0)
+            continue;
+
+        printf("  %-8s avg %.3f ms, worst %.3f ms at %.3f ms\n", _phaseNames[phase],
+            total[phase] / (double)frames[phase] / 1e6, worst[phase] / 1e6, worst_at[phase]);
+    }
+
+    free(records);
+    return true;
+}
@@ -0,0 +1,82 @@
+#include <string.h>
+
+#include "frame_sampler.h"
+
+// FRAMES_TO_NS() rounded down, so ceil(d * rate / 1e9) is the first read
+// at or after d
+static uint64_t _frameOf(const FrameSampler *fs, uint64_t timestamp_ns)
+{
+    if (timestamp_ns <= fs->phase_ns)
+        return 0;
+
+    uint64_t since = timestamp_ns - fs->phase_ns;
+    return (since * GAME_FRAME_RATE + 999999999ULL) / 1000000000ULL;
+}
+
+static bool _sameState(const InputEvent *a, const InputEvent *b)
+{
+    return a->direction == b->direction && a->buttons == b->buttons;
+}
+
+static bool _emit(FrameSampler *fs, InputEvent *out)
+{
+    fs->seen = fs->pending;
+    fs->seen.timestamp_ns = PendingReadTime(fs);
+    fs->has_pending = false;
+
+    *out = fs->seen;
+    return true;
+}
+
+void InitFrameSampler(FrameSampler *fs, uint64_t phase_ns)
+{
+    memset(fs, 0, sizeof(*fs));
+    fs->phase_ns = phase_ns % FRAMES_TO_NS(1);
+    fs->seen.direction = NEUTRAL;
+}
+
+bool SampleInput(FrameSampler *fs, const InputEvent *ev, InputEvent *out)
+{
+    const InputEvent *latest = fs->has_pending ? &fs->pending : &fs->seen;
+    if (_sameState(ev, latest))
+        return false;
+
+    uint64_t frame = _frameOf(fs, ev->timestamp_ns);
+    bool shown = false;
+
+    fs->transitions++;
+
+    if (fs->has_pending)
+    {
+        if (fs->pending_frame < frame)
+            shown = _emit(fs, out);
+        else
+        {
+            fs->has_pending = false;
+            fs->dropped++;
+        }
+    }
+
+    // Back to what the game already has, nothing for it to read
+    if (_sameState(ev, &fs->seen))
+        return shown;
+
+    fs->has_pending = true;
+    fs->pending = *ev;
+    fs->pending_frame = frame;
+    return shown;
+}
+
+bool FlushFrameSampler(FrameSampler *fs, uint64_t now_ns, InputEvent *out)
+{
+    // Strictly before, an input stamped now could still beat the read
+    if (!fs->has_pending || PendingReadTime(fs) >= now_ns)
+        return false;
+
+    return _emit(fs, out);
+}
+
+uint64_t SweepPhase(int i, int count)
+{
+    return count > 0 ? FRAMES_TO_NS(1) * (uint64_t)i / (uint64_t)count : 0;
+}
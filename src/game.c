@@ -1,214 +1,426 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <SDL3/SDL.h>
 
+#include "attempt_store.h"
+#include "flight_recorder.h"
 #include "game.h"
 #include "input.h"
+#include "input_ring.h"
+#include "judge.h"
+#include "modes.h"
+#include "recording.h"
+#include "session_log.h"
+#include "stats_journal.h"
 
-ControllerState prev_input = {0};
-int selected_mode = 0;
+void SetRecording(KbdSession *session, const char *dir, RecordingClock clock)
+{
+    session->recording_dir = dir;
+    session->recording_clock = clock;
+}
+
+void SetStatsJournal(KbdSession *session, struct StatsJournal *stats)
+{
+    session->stats = stats;
+
+    StatsEntry entry;
+    for (int i = 0; i < session->mode_count; i++)
+    {
+        if (FindStats(stats, session->modes[i].mode_name, &entry) && entry.highscore > session->highscores[i])
+            session->highscores[i] = entry.highscore;
+    }
+}
+
+bool SetAttemptStore(KbdSession *session, struct AttemptWriter *attempts)
+{
+    if (attempts != NULL && session->attempt_tracker == NULL)
+    {
+        session->attempt_tracker = calloc(1, sizeof(AttemptTracker));
+        if (session->attempt_tracker == NULL)
+        {
+            printf("Error allocating the attempt tracker\n");
+            return false;
+        }
+    }
+
+    session->attempts = attempts;
+    return true;
+}
+
+void SetFrameSampling(KbdSession *session, bool enabled, uint64_t phase_ns)
+{
+    session->sample_frames = enabled;
+    session->frame_phase_ns = phase_ns;
+}
+
+static void _startRecording(KbdSession *session, uint64_t start_ns)
+{
+    GameState *gs = &session->state;
+
+    if (session->recording_dir == NULL)
+        return;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+
+    // Mode names have spaces in them
+    char mode[RECORDING_NAME_SIZE];
+    snprintf(mode, sizeof(mode), "%s", gs->current_mode->mode_name);
+    for (char *c = mode; *c; c++)
+    {
+        if (*c == ' ')
+            *c = '_';
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s-%s%s", session->recording_dir, stamp, mode, RECORDING_EXTENSION);
+
+    RecordingHeader header;
+    if (!InitRecordingHeader(&header, session->recording_clock, session->selected_mode, gs->current_mode->mode_name,
+        gs->current_mode->pattern, gs->current_mode->pattern_size, start_ns))
+        return;
+
+    session->recorder = OpenRecordingWriter(path, &header, gs->current_mode->dfa);
+    if (session->recorder != NULL)
+        printf("Recording to %s\n", path);
+}
+
+static void _stopRecording(KbdSession *session)
+{
+    CloseRecordingWriter(session->recorder);
+    session->recorder = NULL;
+}
 
-uint64_t highscores[GAME_MODE_COUNT] = {0};
+static void _judgeSampled(KbdSession *session, const InputEvent *ev)
+{
+    // Quitting ends the game in the middle of a frame's inputs
+    if (!session->state.run_game)
+        return;
+
+    ControllerState cs = EventToController(ev);
+    _updateGame(session, &cs);
+}
+
+// Recordings keep the raw input, only the judge goes through the sampler
+static void _updateSampled(KbdSession *session, ControllerState *cs)
+{
+    FrameSampler *fs = &session->sampler;
+    InputEvent raw = ControllerToEvent(cs);
+    InputEvent seen;
+    uint64_t dropped = fs->dropped;
+
+    if (SampleInput(fs, &raw, &seen))
+        _judgeSampled(session, &seen);
+
+    if (fs->dropped != dropped && session->state.run_game)
+    {
+        session->state.last_timing = TIMING_DROPPED;
+
+        SessionEvent logged = { .timestamp_ns = cs->timestamp_ns, .kind = SESSION_EVENT_DROPPED };
+        LogSessionEvent(session->log, &logged, &session->state, session->prev_input.direction);
+    }
+
+    // Read strictly after its time, an input stamped then still wins
+    if (fs->has_pending)
+        ScheduleTimer(&session->timers, &session->frame_read, PendingReadTime(fs) + 1);
+    else
+        CancelTimer(&session->timers, &session->frame_read);
+}
+
+static void _readFrame(void *user, uint64_t deadline_ns)
+{
+    KbdSession *session = user;
+    InputEvent seen;
+
+    if (FlushFrameSampler(&session->sampler, deadline_ns, &seen))
+        _judgeSampled(session, &seen);
+}
 
-void InitGame()
+static void _endMissPause(void *user, uint64_t deadline_ns)
 {
-    _initGameModes();
+    KbdSession *session = user;
+
+    if (!session->state.in_miss_pause)
+        return;
+
+    EndMissPause(&session->state);
+
+    SessionEvent logged = { .timestamp_ns = deadline_ns, .kind = SESSION_EVENT_PAUSE_END };
+    LogSessionEvent(session->log, &logged, &session->state, session->prev_input.direction);
+}
+
+bool InitGame(KbdSession *session, GameClock *clock, const ModeRegistry *modes)
+{
+    memset(session, 0, sizeof(*session));
+
+    session->clock = clock;
+    session->registry = modes;
+    session->modes = modes->modes;
+    session->mode_count = modes->count;
+    session->recording_clock = RECORDING_CLOCK_SDL;
+
+    InitTimerWheel(&session->timers, ClockNow(clock));
+    InitTimer(&session->miss_pause, _endMissPause, session);
+    InitTimer(&session->frame_read, _readFrame, session);
+
+    session->log = malloc(sizeof(SessionLog));
+    if (session->log == NULL)
+    {
+        printf("Error allocating the session log\n");
+        return false;
+    }
+
+    if (!InitSessionLog(session->log, SESSION_LOG_DEFAULT_EVENTS, SESSION_LOG_DEFAULT_INTERVAL))
+    {
+        free(session->log);
+        session->log = NULL;
+        return false;
+    }
+
+    session->highscores = calloc(modes->count, sizeof(uint64_t));
+    if (session->highscores == NULL)
+    {
+        printf("Error allocating high scores\n");
+        DestroySessionLog(session->log);
+        free(session->log);
+        session->log = NULL;
+        return false;
+    }
+
+    if (modes->practice != NULL)
+        session->practice = *modes->practice;
+    else
+        InitRecognizer(&session->practice);
     
     GameState initGS = {0};
-    initGS.current_mode = gamemodes;
+    initGS.current_mode = session->modes;
     initGS.miss_time = 0;
     initGS.in_miss_pause = false;
 
-    gamestate = initGS;
+    session->state = initGS;
+    return true;
 }
 
-void Update(ControllerState *cs)
+void Update(KbdSession *session, ControllerState *cs)
 {
-    if (gamestate.run_game)
-        _updateGame(cs);
+    if (session->state.run_game)
+    {
+        if (session->recorder != NULL)
+        {
+            InputEvent ev = ControllerToEvent(cs);
+            RecordInput(session->recorder, &ev);
+        }
+
+        if (session->sample_frames)
+            _updateSampled(session, cs);
+        else
+            _updateGame(session, cs);
+    }
     else
-        _updateMenu(cs);
+        _updateMenu(session, cs);
+}
+
+// Feed every transition queued since the last frame through Update() in
+// order, so changes shorter than a frame are still judged
+void UpdateFromRing(KbdSession *session, InputRing *ring)
+{
+    InputEvent ev;
+
+    while (PopInputEvent(ring, &ev))
+    {
+        RecordFlight(FLIGHT_INPUT, (uint8_t)ev.direction, ev.buttons, 0, ev.timestamp_ns);
+
+        // Anything due before this input happens first
+        RunTimers(&session->timers, ev.timestamp_ns);
+
+        session->held_input = EventToController(&ev);
+        Update(session, &session->held_input);
+    }
+
+    // A pause can end or a frame be read with nothing changing at all
+    RunTimers(&session->timers, ClockNow(session->clock));
 }
 
-void _updateMenu(ControllerState *cs)
+void _updateMenu(KbdSession *session, ControllerState *cs)
 {
-    if (cs->back_pressed == prev_input.back_pressed
-        && cs->select_pressed == prev_input.select_pressed
-        && cs->direction == prev_input.direction)
+    ControllerState *prev = &session->prev_input;
+
+    if (cs->back_pressed == prev->back_pressed
+        && cs->select_pressed == prev->select_pressed
+        && cs->direction == prev->direction)
         return;
 
-    prev_input = *cs;
+    *prev = *cs;
     
     // Start game
     if (cs->select_pressed)
     {
-        _startGame();
+        _startGame(session);
+        _startRecording(session, cs->timestamp_ns);
         return;
     }
 
     if (cs->direction == FORWARD)
     {
-        if (selected_mode == GAME_MODE_COUNT - 1)
-        selected_mode = 0;
+        if (session->selected_mode == session->mode_count - 1)
+        session->selected_mode = 0;
         else
-        selected_mode += 1;
+        session->selected_mode += 1;
     }
     else if (cs->direction == BACK)
     {
-        if (selected_mode == 0)
-        selected_mode = GAME_MODE_COUNT - 1;
+        if (session->selected_mode == 0)
+        session->selected_mode = session->mode_count - 1;
         else
-        selected_mode -= 1;
+        session->selected_mode -= 1;
     }
     
-    gamestate.current_mode = &gamemodes[selected_mode];
+    session->state.current_mode = &session->modes[session->selected_mode];
 }
 
-void _updateGame(ControllerState *cs)
+// Only queued, the journal's own thread writes it
+static void _journalGame(KbdSession *session, uint64_t end_ns)
 {
-    gamestate.curr_input = cs->direction;
-    
-    // Handle miss pause - wait 2 seconds before resetting
-    if (gamestate.in_miss_pause)
+    const GameState *gs = &session->state;
+    uint64_t play_ns = end_ns > session->game_start_ns ? end_ns - session->game_start_ns : 0;
+
+    JournalGame(session->stats, gs->current_mode->mode_name, gs->highscore, gs->completions, play_ns);
+}
+
+static void _quitGame(KbdSession *session)
+{
+    session->highscores[session->selected_mode] = session->state.highscore;
+    _journalGame(session, ClockNow(session->clock));
+    session->state.run_game = false;
+    CancelTimer(&session->timers, &session->miss_pause);
+    CancelTimer(&session->timers, &session->frame_read);
+    FinishNearMiss(&session->near_miss);
+    _stopRecording(session);
+}
+
+// Nothing to get wrong, every technique done scores
+static void _updatePractice(KbdSession *session, ControllerState *cs)
+{
+    GameState *gs = &session->state;
+
+    gs->curr_input = cs->direction;
+
+    if (cs->back_pressed)
     {
-        uint64_t current_time = SDL_GetTicksNS();
-        uint64_t pause_duration = 2000000000ULL; // 2 seconds in nanoseconds
-        
-        if (current_time - gamestate.miss_time >= pause_duration)
-        {
-            // Reset after pause
-            gamestate.player_pos = 0;
-            gamestate.score = 0;
-            gamestate.last_input_acc = NONE;
-            gamestate.in_miss_pause = false;
-            prev_input = *cs;
-        }
+        _quitGame(session);
         return;
     }
-    
-    if (gamestate.last_input_acc == FAIL)
+
+    if (FeedRecognizer(&session->practice, cs->direction, cs->timestamp_ns) == 0)
+        return;
+
+    gs->score = RecognizedTotal(&session->practice) * JUDGE_POINTS;
+    if (gs->score > gs->highscore)
+        gs->highscore = gs->score;
+
+    gs->last_input = cs->direction;
+    gs->last_input_acc = SUCCESS;
+}
+
+void _updateGame(KbdSession *session, ControllerState *cs)
+{
+    if (session->state.current_mode->free_practice)
     {
-        // Start miss pause timer
-        gamestate.miss_time = SDL_GetTicksNS();
-        gamestate.in_miss_pause = true;
+        _updatePractice(session, cs);
         return;
     }
 
-    if (cs->back_pressed)
+    JudgeResult result = JudgeInput(&session->state, &session->prev_input.direction, cs);
+    RecordFlight(FLIGHT_VERDICT, (uint8_t)result, 0, 0, cs->timestamp_ns);
+
+    Attempt attempt;
+    if (session->attempts != NULL && TrackAttempt(session->attempt_tracker, result, &session->state, cs->timestamp_ns, &attempt))
+        StoreAttempt(session->attempts, &attempt);
+
+    InputEvent input = ControllerToEvent(cs);
+    SessionEvent logged = {
+        .timestamp_ns = input.timestamp_ns,
+        .kind = SESSION_EVENT_INPUT,
+        .direction = input.direction,
+        .buttons = input.buttons,
+        .result = (uint8_t)result
+    };
+    LogSessionEvent(session->log, &logged, &session->state, session->prev_input.direction);
+
+    if (result == JUDGE_QUIT)
     {
-        highscores[selected_mode] = gamestate.highscore;
-        gamestate.run_game = false;
+        _quitGame(session);
         return;
     }
-    
-    // No update if input has not changed
-    if (cs->direction == prev_input.direction) return;
-    
-    if (cs->direction == gamestate.current_mode->pattern[ gamestate.player_pos % gamestate.current_mode->pattern_size ])
-    {
-        // Correct input
-        gamestate.score += 50;
-        if (gamestate.score > gamestate.highscore)
-            gamestate.highscore = gamestate.score;
-        
-        if (gamestate.player_pos == gamestate.current_mode->pattern_size - 1)
-            gamestate.player_pos = 0;
-        else
-            gamestate.player_pos += 1;
-        
-        prev_input.direction = cs->direction;
-        
-        gamestate.last_input = cs->direction;
-        gamestate.last_input_acc = SUCCESS;
-    }
-    else
-    {
-        // Incorrect input
-        prev_input.direction = cs->direction;
 
-        if (gamestate.player_pos != 0)
-        {
-            gamestate.last_input = cs->direction;
-            gamestate.last_input_acc = FAIL;
-        }
-    }
+    if (result == JUDGE_MISS)
+        ScheduleTimer(&session->timers, &session->miss_pause, session->state.miss_time + MISS_PAUSE_NS);
+    FeedNearMiss(&session->near_miss, cs->direction, result == JUDGE_MISS);
 }
 
-void _startGame()
+void _startGame(KbdSession *session)
 {
-    printf("Mode(%d) score: %llu\n", selected_mode, (unsigned long long)highscores[selected_mode]);
-    gamestate.player_pos = 0;
-    gamestate.score = 0;
-    gamestate.highscore = highscores[selected_mode];
+    int mode = session->selected_mode;
 
-    gamestate.last_input = NEUTRAL;
-    gamestate.last_input_acc = NONE;
-    gamestate.miss_time = 0;
-    gamestate.in_miss_pause = false;
-    gamestate.run_game = true;
-}
+    printf("Mode(%d) score: %llu\n", mode, (unsigned long long)session->highscores[mode]);
+    ResetGameState(&session->state, &session->modes[mode], session->highscores[mode]);
+    ResetRecognizer(&session->practice);
 
-void DestroyGame()
-{
-    for(int i = 0; i < GAME_MODE_COUNT; i++)
+    GameMode *current = session->state.current_mode;
+    InitNearMiss(&session->near_miss, current->pattern, current->free_practice ? 0 : current->pattern_size);
+    InitFrameSampler(&session->sampler, session->frame_phase_ns);
+    CancelTimer(&session->timers, &session->miss_pause);
+    CancelTimer(&session->timers, &session->frame_read);
+
+    session->game_start_ns = ClockNow(session->clock);
+
+    if (session->attempts != NULL)
     {
-        free(gamemodes[i].pattern);
+        SDL_Time now = 0;
+        SDL_GetCurrentTime(&now);
+        InitAttemptTracker(session->attempt_tracker, AttemptModeId(session->attempts, mode), &session->state,
+            (int64_t)now - (int64_t)session->game_start_ns);
     }
+
+    BeginSessionLog(session->log, &session->state, session->prev_input.direction, session->game_start_ns);
 }
 
-void _initGameModes()
+void DestroyGame(KbdSession *session)
 {
-    GameDirection *pattern;
+    // Closing the window mid game still counts it
+    if (session->state.run_game)
+        _journalGame(session, ClockNow(session->clock));
 
-    // P1 KBD
-    pattern = malloc(4 * sizeof(GameDirection));
-    pattern[0] = BACK;
-    pattern[1] = NEUTRAL;
-    pattern[2] = BACK;
-    pattern[3] = DOWN_BACK;
+    _stopRecording(session);
+    free(session->highscores);
+    session->highscores = NULL;
 
-    gamemodes[0].mode_name = "P1 KBD";
-    gamemodes[0].pattern_size = 4;
-    gamemodes[0].pattern = pattern;
-    
-    // P2 KBD
-    pattern = malloc(4 * sizeof(GameDirection));
-    pattern[0] = FORWARD;
-    pattern[1] = NEUTRAL;
-    pattern[2] = FORWARD;
-    pattern[3] = DOWN_FORWARD;
-
-    gamemodes[1].mode_name = "P2 KBD";
-    gamemodes[1].pattern_size = 4;
-    gamemodes[1].pattern = pattern;
-
-    // P1 WD
-    pattern = malloc(6 * sizeof(GameDirection));
-    pattern[0] = FORWARD;
-    pattern[1] = NEUTRAL;
-    pattern[2] = DOWN;
-    pattern[3] = DOWN_FORWARD;
-    pattern[4] = FORWARD;
-    pattern[5] = NEUTRAL;
-
-    gamemodes[2].mode_name = "P1 WD";
-    gamemodes[2].pattern_size = 6;
-    gamemodes[2].pattern = pattern;
-
-
-    // P2 WD
-    pattern = malloc(6 * sizeof(GameDirection));
-    pattern[0] = BACK;
-    pattern[1] = NEUTRAL;
-    pattern[2] = DOWN;
-    pattern[3] = DOWN_BACK;
-    pattern[4] = BACK;
-    pattern[5] = NEUTRAL;
-
-    gamemodes[3].mode_name = "P2 WD";
-    gamemodes[3].pattern_size = 6;
-    gamemodes[3].pattern = pattern;
-
-    printf("Gamemodes Initialized.\n");
-}
\ No newline at end of file
+    if (session->log != NULL)
+        DestroySessionLog(session->log);
+    free(session->log);
+    session->log = NULL;
+
+    free(session->attempt_tracker);
+    session->attempt_tracker = NULL;
+}
+
+bool RewindGame(KbdSession *session, uint64_t ns_back, GameState *out)
+{
+    uint64_t now = ClockNow(session->clock);
+    uint64_t time_ns = ns_back < now ? now - ns_back : 0;
+    GameDirection prev;
+
+    if (session->state.current_mode->free_practice)
+        return false;
+
+    return RewindSessionLog(session->log, time_ns, out, &prev);
+}
+
+Recognizer *GetPracticeRecognizer(KbdSession *session)
+{
+    return &session->practice;
+}
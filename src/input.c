@@ -3,145 +3,564 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include "clock.h"
 #include "input.h"
-
-SDL_Gamepad *gamepad = NULL;
+#include "input_ring.h"
+#include "socd.h"
+#include "stick.h"
 
 ControllerState controller_state = {0};
 
 // 4 DIGIT BITMASK FOR DIRECTIONS
 short dpad_state = 0;
 
+InputBackend input_backend = INPUT_BACKEND_POLL;
+
+// Applied to the merged state of every device
+SocdState socd_state = { SOCD_NEUTRAL, 0 };
+
+// Dense, slot 0 is the keyboard. Removing a pad moves the last one into
+// its slot so the hot path never skips holes.
+InputDevice devices[MAX_INPUT_DEVICES];
+int device_count = 0;
+
+DeviceMergeRule merge_rule = DEVICE_MERGE_ANY;
+
+// Left stick -> direction lookup, shared by every pad
+StickGate stick_gate = {0};
+
+// Devices are added and removed on the main thread while the input thread
+// may be sampling them
+SDL_Mutex *device_lock = NULL;
+
+// SDL stamps events with SDL_GetTicksNS(), this moves them onto input_clock
+GameClock *input_clock = NULL;
+Sint64 event_clock_offset = 0;
+
+static const char *_mergeRuleNames[DEVICE_MERGE_COUNT] = {
+    [DEVICE_MERGE_ANY]      = "any",
+    [DEVICE_MERGE_LATEST]   = "latest",
+    [DEVICE_MERGE_PRIORITY] = "priority"
+};
+
+// Event backend state, rebuilt one event at a time
+// Bits for every keyboard key we care about, see _keyBit()
+enum {
+    KEY_BIT_W       = 1 << 0,
+    KEY_BIT_UP      = 1 << 1,
+    KEY_BIT_S       = 1 << 2,
+    KEY_BIT_DOWN    = 1 << 3,
+    KEY_BIT_A       = 1 << 4,
+    KEY_BIT_LEFT    = 1 << 5,
+    KEY_BIT_D       = 1 << 6,
+    KEY_BIT_RIGHT   = 1 << 7,
+    KEY_BIT_SPACE   = 1 << 8,
+    KEY_BIT_RETURN  = 1 << 9,
+    KEY_BIT_RETURN2 = 1 << 10,
+    KEY_BIT_ESCAPE  = 1 << 11
+};
+
+Uint16 keys_held = 0;
+
+
+static bool _addGamepad(SDL_JoystickID id)
+{
+    if (device_count == MAX_INPUT_DEVICES)
+    {
+        printf("Ignoring gamepad, already tracking %d devices\n", MAX_INPUT_DEVICES);
+        return false;
+    }
+
+    for (int i = 1; i < device_count; i++)
+    {
+        if (devices[i].id == id)
+            return true;
+    }
+
+    SDL_Gamepad *pad = SDL_OpenGamepad(id);
+    if (pad == NULL)
+    {
+        printf("Error initializing gamepad: %s\n", SDL_GetError());
+        return false;
+    }
+
+    SDL_LockMutex(device_lock);
+    InputDevice *dev = &devices[device_count];
+    SDL_zerop(dev);
+    dev->id = id;
+    dev->pad = pad;
+    device_count++;
+    SDL_UnlockMutex(device_lock);
+
+    printf("Controller connected: %s\n", SDL_GetGamepadName(pad));
+    return true;
+}
+
+static void _removeGamepad(SDL_JoystickID id)
+{
+    SDL_LockMutex(device_lock);
+    for (int i = 1; i < device_count; i++)
+    {
+        if (devices[i].id != id)
+            continue;
+
+        SDL_CloseGamepad(devices[i].pad);
+
+        device_count--;
+        devices[i] = devices[device_count];
+
+        printf("Controller disconnected\n");
+        break;
+    }
+    SDL_UnlockMutex(device_lock);
+}
+
+static InputDevice *_findDevice(SDL_JoystickID id)
+{
+    for (int i = 1; i < device_count; i++)
+    {
+        if (devices[i].id == id)
+            return &devices[i];
+    }
+
+    return NULL;
+}
 
 bool InitController()
 {
-    SDL_SetGamepadEventsEnabled(false);
+    InitSocdState(&socd_state, socd_state.policy);
+
+    if (device_lock == NULL)
+        device_lock = SDL_CreateMutex();
+
+    // The keyboard is always there
+    SDL_zero(devices);
+    device_count = 1;
 
     int numOfPads = 0;
     SDL_JoystickID *padIds = SDL_GetGamepads(&numOfPads);
 
-    if (numOfPads == 0)
-        return false;
-    
     for (int i = 0; i < numOfPads; i++)
     {
-        // Get first compatible gamepad
         if (SDL_IsGamepad(padIds[i]))
+            _addGamepad(padIds[i]);
+    }
+
+    SDL_free(padIds);
+
+    return device_count > 1;
+}
+
+void SetInputBackend(InputBackend backend)
+{
+    input_backend = backend;
+
+    // The polling backends read state directly and don't need the queue,
+    // but everybody needs to hear about pads coming and going
+    SDL_SetGamepadEventsEnabled(backend == INPUT_BACKEND_EVENTS);
+    SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_ADDED, true);
+    SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_REMOVED, true);
+}
+
+InputBackend GetInputBackend()
+{
+    return input_backend;
+}
+
+void SetSocdPolicy(SocdPolicy policy)
+{
+    InitSocdState(&socd_state, policy);
+}
+
+void SetDeviceMergeRule(DeviceMergeRule rule)
+{
+    merge_rule = rule;
+}
+
+const char *DeviceMergeRuleName(DeviceMergeRule rule)
+{
+    if (rule < 0 || rule >= DEVICE_MERGE_COUNT)
+        return "unknown";
+
+    return _mergeRuleNames[rule];
+}
+
+bool SetStickGate(StickGateShape shape, float deadzone)
+{
+    StickGate gate;
+    if (!InitStickGate(&gate, shape, deadzone, STICK_DEFAULT_BITS))
+        return false;
+
+    SDL_LockMutex(device_lock);
+    StickGate old = stick_gate;
+    stick_gate = gate;
+    SDL_UnlockMutex(device_lock);
+
+    DestroyStickGate(&old);
+    return true;
+}
+
+void SetInputClock(GameClock *clock)
+{
+    input_clock = clock;
+    event_clock_offset = clock != NULL ? (Sint64)(ClockNow(clock) - SDL_GetTicksNS()) : 0;
+}
+
+uint64_t InputClockNow()
+{
+    if (input_clock == NULL)
+        return SDL_GetTicksNS();
+
+    return ClockNow(input_clock);
+}
+
+const InputDevice *GetInputDevices(int *count)
+{
+    *count = device_count;
+    return devices;
+}
+
+ControllerState *PollController()
+{
+    // PumpEvents updates keyboard state
+    // Only safe from the main thread, the input thread relies on the
+    // frame loop's SDL_PollEvent to keep the keyboard state fresh
+    SDL_PumpEvents();
+
+    return SampleController();
+}
+
+// Store a device's fresh raw state, remembering when it last changed
+static void _setDeviceState(InputDevice *dev, short dpad, bool select, bool back, Uint64 now)
+{
+    if (dpad != dev->dpad || select != dev->state.select_pressed || back != dev->state.back_pressed)
+        dev->state.timestamp_ns = now;
+
+    dev->dpad = dpad;
+    dev->state.direction = DirectionFromMask(dpad);
+    dev->state.select_pressed = select;
+    dev->state.back_pressed = back;
+}
+
+// Fold every device into dpad_state and the button flags
+static void _mergeDevices()
+{
+    short dpad = 0;
+    bool select = false;
+    bool back = false;
+
+    switch (merge_rule)
+    {
+        case DEVICE_MERGE_LATEST:
         {
-            gamepad = SDL_OpenGamepad(padIds[i]);
-            if (gamepad == NULL)
+            const InputDevice *latest = &devices[0];
+            for (int i = 1; i < device_count; i++)
             {
-                printf("Error initializing gamepad: %s", SDL_GetError());
-                return false;
-            }  
-            
-            return true;
+                if (devices[i].state.timestamp_ns > latest->state.timestamp_ns)
+                    latest = &devices[i];
+            }
+
+            dpad = latest->dpad;
+            select = latest->state.select_pressed;
+            back = latest->state.back_pressed;
+            break;
         }
-    }    
 
-    return false;
+        case DEVICE_MERGE_PRIORITY:
+            for (int i = 0; i < device_count; i++)
+            {
+                const InputDevice *dev = &devices[i];
+                if (dev->dpad != 0 || dev->state.select_pressed || dev->state.back_pressed)
+                {
+                    dpad = dev->dpad;
+                    select = dev->state.select_pressed;
+                    back = dev->state.back_pressed;
+                    break;
+                }
+            }
+            break;
+
+        case DEVICE_MERGE_ANY:
+        default:
+            for (int i = 0; i < device_count; i++)
+            {
+                dpad |= devices[i].dpad;
+                select |= devices[i].state.select_pressed;
+                back |= devices[i].state.back_pressed;
+            }
+            break;
+    }
+
+    dpad_state = dpad;
+    controller_state.select_pressed = select;
+    controller_state.back_pressed = back;
 }
 
-ControllerState *PollController()
+ControllerState *SampleController()
 {
+    Uint64 now = InputClockNow();
+
+    SDL_LockMutex(device_lock);
+
+    // GetKeyboardState returns a bool array of keys
+    // array is indexed by enumeration
+    // Only as fresh as the frame loop's last pump, even on the input thread
+    const bool *keys = SDL_GetKeyboardState(NULL);
+
+    short dpad = 1 * (keys[SDL_SCANCODE_W] || keys[SDL_SCANCODE_UP]);
+    dpad |= 2 * (keys[SDL_SCANCODE_S] || keys[SDL_SCANCODE_DOWN]);
+    dpad |= 4 * (keys[SDL_SCANCODE_A] || keys[SDL_SCANCODE_LEFT]);
+    dpad |= 8 * (keys[SDL_SCANCODE_D] || keys[SDL_SCANCODE_RIGHT]);
+
+    _setDeviceState(&devices[0], dpad,
+        keys[SDL_SCANCODE_SPACE] || keys[SDL_SCANCODE_RETURN] || keys[SDL_SCANCODE_RETURN2],
+        keys[SDL_SCANCODE_ESCAPE],
+        now);
 
     // Just gonna group all these into a bitmask following the XINPUT standard
     // so i dont have to rewrite the XINPUT implementation
     // it's 10pm on a weeknight
-    if (gamepad != NULL)
+    if (device_count > 1)
+        SDL_UpdateGamepads();
+
+    for (int i = 1; i < device_count; i++)
     {
+        SDL_Gamepad *pad = devices[i].pad;
+
         // 0001 is UP, 0010 is DOWN, 0100 is LEFT, 1000 is RIGHT
-        SDL_UpdateGamepads();
-        dpad_state = 1 * SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_DPAD_UP);
-        dpad_state |= 2 * SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_DPAD_DOWN);
-        dpad_state |= 4 * SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_DPAD_LEFT);
-        dpad_state |= 8 * SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_DPAD_RIGHT);
+        dpad = 1 * SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_DPAD_UP);
+        dpad |= 2 * SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_DPAD_DOWN);
+        dpad |= 4 * SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_DPAD_LEFT);
+        dpad |= 8 * SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_DPAD_RIGHT);
+        dpad |= QuantizeStick(&stick_gate,
+            SDL_GetGamepadAxis(pad, SDL_GAMEPAD_AXIS_LEFTX),
+            SDL_GetGamepadAxis(pad, SDL_GAMEPAD_AXIS_LEFTY));
 
         // For Buttons...
-        controller_state.select_pressed = SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_SOUTH);
-        controller_state.back_pressed = SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_EAST) || SDL_GetGamepadButton(gamepad, SDL_GAMEPAD_BUTTON_START);
-    }
-    else
-    {
-        // PumpEvents updates keyboard state
-        // GetKeyboardState returns a bool array of keys
-        // array is indexed by enumeration
-        SDL_PumpEvents();
-        const bool *keys = SDL_GetKeyboardState(NULL);
-    
-        dpad_state = 1 * (keys[SDL_SCANCODE_W] || keys[SDL_SCANCODE_UP]);
-        dpad_state |= 2 * (keys[SDL_SCANCODE_S] || keys[SDL_SCANCODE_DOWN]);
-        dpad_state |= 4 * (keys[SDL_SCANCODE_A] || keys[SDL_SCANCODE_LEFT]);
-        dpad_state |= 8 * (keys[SDL_SCANCODE_D] || keys[SDL_SCANCODE_RIGHT]);
-        
-        // SOCD Cleaning
-        
-        // If 0011 then set the last 2 bits to 00
-        if ((dpad_state & 3) == 3)
-        dpad_state &= 12;
-        
-        // If 1100 then set the first 2 bits to 00
-        if ((dpad_state & 12) == 12)
-            dpad_state &= 3;
-
-        controller_state.select_pressed = keys[SDL_SCANCODE_SPACE] || keys[SDL_SCANCODE_RETURN] || keys[SDL_SCANCODE_RETURN2];
-        controller_state.back_pressed = keys[SDL_SCANCODE_ESCAPE];
+        _setDeviceState(&devices[i], dpad,
+            SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_SOUTH),
+            SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_EAST) || SDL_GetGamepadButton(pad, SDL_GAMEPAD_BUTTON_START),
+            now);
     }
-    
+
+    _mergeDevices();
+
+    SDL_UnlockMutex(device_lock);
+
+    _resolveSOCD();
     _parseDirection();
+    controller_state.timestamp_ns = now;
 
     return &controller_state;
 }
 
-void _parseDirection()
+static Uint16 _keyBit(SDL_Scancode scancode)
 {
-    switch( dpad_state & 0xF )
+    switch (scancode)
     {
-        // 0000
-        case 0x0:
-            controller_state.direction = NEUTRAL;
-            break;
-        // 0001
-        case 0x1:
-            controller_state.direction = UP;
-            break;
-    
-        // 1001
-        case 0x9:
-            controller_state.direction = UP_FORWARD; 
-            break;
-        
-        // 0101
-        case 0x5:
-            controller_state.direction = UP_BACK;
-            break;
-        
-        // 0100
-        case 0x4:
-            controller_state.direction = BACK;
-            break;
-        
-        // 1000
-        case 0x8:
-            controller_state.direction = FORWARD;
+        case SDL_SCANCODE_W:        return KEY_BIT_W;
+        case SDL_SCANCODE_UP:       return KEY_BIT_UP;
+        case SDL_SCANCODE_S:        return KEY_BIT_S;
+        case SDL_SCANCODE_DOWN:     return KEY_BIT_DOWN;
+        case SDL_SCANCODE_A:        return KEY_BIT_A;
+        case SDL_SCANCODE_LEFT:     return KEY_BIT_LEFT;
+        case SDL_SCANCODE_D:        return KEY_BIT_D;
+        case SDL_SCANCODE_RIGHT:    return KEY_BIT_RIGHT;
+        case SDL_SCANCODE_SPACE:    return KEY_BIT_SPACE;
+        case SDL_SCANCODE_RETURN:   return KEY_BIT_RETURN;
+        case SDL_SCANCODE_RETURN2:  return KEY_BIT_RETURN2;
+        case SDL_SCANCODE_ESCAPE:   return KEY_BIT_ESCAPE;
+        default:                    return 0;
+    }
+}
+
+// Low nibble matches the dpad_state layout
+enum {
+    PAD_BIT_UP    = 1 << 0,
+    PAD_BIT_DOWN  = 1 << 1,
+    PAD_BIT_LEFT  = 1 << 2,
+    PAD_BIT_RIGHT = 1 << 3,
+    PAD_BIT_SOUTH = 1 << 4,
+    PAD_BIT_EAST  = 1 << 5,
+    PAD_BIT_START = 1 << 6
+};
+
+static Uint16 _padBit(Uint8 button)
+{
+    switch (button)
+    {
+        case SDL_GAMEPAD_BUTTON_DPAD_UP:    return PAD_BIT_UP;
+        case SDL_GAMEPAD_BUTTON_DPAD_DOWN:  return PAD_BIT_DOWN;
+        case SDL_GAMEPAD_BUTTON_DPAD_LEFT:  return PAD_BIT_LEFT;
+        case SDL_GAMEPAD_BUTTON_DPAD_RIGHT: return PAD_BIT_RIGHT;
+        case SDL_GAMEPAD_BUTTON_SOUTH:      return PAD_BIT_SOUTH;
+        case SDL_GAMEPAD_BUTTON_EAST:       return PAD_BIT_EAST;
+        case SDL_GAMEPAD_BUTTON_START:      return PAD_BIT_START;
+        default:                            return 0;
+    }
+}
+
+// Rebuild a pad's state from what its events told us so far
+static void _setPadEventState(InputDevice *dev, Uint64 now)
+{
+    short dpad = (dev->buttons_held & 0xF) | QuantizeStick(&stick_gate, dev->stick_x, dev->stick_y);
+
+    _setDeviceState(dev, dpad,
+        (dev->buttons_held & PAD_BIT_SOUTH) != 0,
+        (dev->buttons_held & (PAD_BIT_EAST | PAD_BIT_START)) != 0,
+        now);
+}
+
+// Event backend
+// Call for every event the frame loop pulls out of SDL. Any change to the
+// resolved state is pushed to the ring stamped with the event's own time,
+// not the time we got around to looking at it
+bool HandleInputEvent(const SDL_Event *ev, InputRing *ring)
+{
+    Uint64 now = ev->common.timestamp + event_clock_offset;
+
+    switch (ev->type)
+    {
+        // Hot plugging works the same whatever the backend
+        case SDL_EVENT_GAMEPAD_ADDED:
+            _addGamepad(ev->gdevice.which);
+            return true;
+
+        case SDL_EVENT_GAMEPAD_REMOVED:
+            _removeGamepad(ev->gdevice.which);
+
+            // The other backends see the pad gone on their next sample. The
+            // input thread owns both the merged state and the ring there.
+            if (input_backend != INPUT_BACKEND_EVENTS)
+                return true;
             break;
-        
-        // 0010
-        case 0x2:
-            controller_state.direction = DOWN;
+
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        {
+            if (input_backend != INPUT_BACKEND_EVENTS)
+                return false;
+
+            Uint16 bit = _keyBit(ev->key.scancode);
+            if (bit == 0 || ev->key.repeat)
+                return false;
+
+            if (ev->key.down)
+                keys_held |= bit;
+            else
+                keys_held &= ~bit;
+
+            short dpad = 1 * ((keys_held & (KEY_BIT_W | KEY_BIT_UP)) != 0);
+            dpad |= 2 * ((keys_held & (KEY_BIT_S | KEY_BIT_DOWN)) != 0);
+            dpad |= 4 * ((keys_held & (KEY_BIT_A | KEY_BIT_LEFT)) != 0);
+            dpad |= 8 * ((keys_held & (KEY_BIT_D | KEY_BIT_RIGHT)) != 0);
+
+            _setDeviceState(&devices[0], dpad,
+                (keys_held & (KEY_BIT_SPACE | KEY_BIT_RETURN | KEY_BIT_RETURN2)) != 0,
+                (keys_held & KEY_BIT_ESCAPE) != 0,
+                now);
             break;
-        
-        // 1010
-        case 0xA:
-            controller_state.direction = DOWN_FORWARD;
+        }
+
+        case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+        case SDL_EVENT_GAMEPAD_BUTTON_UP:
+        {
+            if (input_backend != INPUT_BACKEND_EVENTS)
+                return false;
+
+            InputDevice *dev = _findDevice(ev->gbutton.which);
+            if (dev == NULL)
+                return false;
+
+            Uint16 bit = _padBit(ev->gbutton.button);
+            if (bit == 0)
+                return false;
+
+            if (ev->gbutton.down)
+                dev->buttons_held |= bit;
+            else
+                dev->buttons_held &= ~bit;
+
+            _setPadEventState(dev, now);
             break;
-        
-        // 0110
-        case 0x6:
-            controller_state.direction = DOWN_BACK;
+        }
+
+        case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+        {
+            if (input_backend != INPUT_BACKEND_EVENTS)
+                return false;
+
+            InputDevice *dev = _findDevice(ev->gaxis.which);
+            if (dev == NULL)
+                return false;
+
+            if (ev->gaxis.axis == SDL_GAMEPAD_AXIS_LEFTX)
+                dev->stick_x = ev->gaxis.value;
+            else if (ev->gaxis.axis == SDL_GAMEPAD_AXIS_LEFTY)
+                dev->stick_y = ev->gaxis.value;
+            else
+                return false;
+
+            _setPadEventState(dev, now);
             break;
-        
+        }
+
         default:
-            controller_state.direction = UNKNOWN; 
+            return false;
+    }
+
+    ControllerState prev = controller_state;
+
+    SDL_LockMutex(device_lock);
+    _mergeDevices();
+    SDL_UnlockMutex(device_lock);
+
+    _resolveSOCD();
+    _parseDirection();
+    controller_state.timestamp_ns = now;
+
+    if (controller_state.direction != prev.direction
+        || controller_state.select_pressed != prev.select_pressed
+        || controller_state.back_pressed != prev.back_pressed)
+    {
+        InputEvent out = ControllerToEvent(&controller_state);
+        PushInputEvent(ring, &out);
     }
-}
\ No newline at end of file
+
+    return true;
+}
+
+void _resolveSOCD()
+{
+    dpad_state = ResolveSocd(&socd_state, (uint8_t)dpad_state);
+}
+
+void _parseDirection()
+{
+    controller_state.direction = DirectionFromMask(dpad_state);
+}
+
+GameDirection DirectionFromMask(short mask)
+{
+    // 0001 is UP, 0010 is DOWN, 0100 is LEFT, 1000 is RIGHT
+    static const GameDirection directions[16] = {
+        [0x0] = NEUTRAL,
+        [0x1] = UP,
+        [0x2] = DOWN,
+        [0x3] = UNKNOWN,
+        [0x4] = BACK,
+        [0x5] = UP_BACK,
+        [0x6] = DOWN_BACK,
+        [0x7] = UNKNOWN,
+        [0x8] = FORWARD,
+        [0x9] = UP_FORWARD,
+        [0xA] = DOWN_FORWARD,
+        [0xB] = UNKNOWN,
+        [0xC] = UNKNOWN,
+        [0xD] = UNKNOWN,
+        [0xE] = UNKNOWN,
+        [0xF] = UNKNOWN
+    };
+
+    return directions[mask & 0xF];
+}
@@ -0,0 +1,309 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "input.h"
+#include "input_ring.h"
+#include "input_evdev.h"
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+enum {
+    EVDEV_UP     = 1 << 0,
+    EVDEV_DOWN   = 1 << 1,
+    EVDEV_LEFT   = 1 << 2,
+    EVDEV_RIGHT  = 1 << 3,
+    EVDEV_SELECT = 1 << 4,
+    EVDEV_BACK   = 1 << 5
+};
+
+// Every mapped key gets its own bit so W and UP held together and released
+// one at a time still leaves the direction held
+typedef struct {
+    uint16_t code;
+    uint8_t meaning;
+} EvdevKeyMap;
+
+static const EvdevKeyMap _evdevKeys[] = {
+    { BTN_DPAD_UP,    EVDEV_UP },
+    { BTN_DPAD_DOWN,  EVDEV_DOWN },
+    { BTN_DPAD_LEFT,  EVDEV_LEFT },
+    { BTN_DPAD_RIGHT, EVDEV_RIGHT },
+    { KEY_W,          EVDEV_UP },
+    { KEY_UP,         EVDEV_UP },
+    { KEY_S,          EVDEV_DOWN },
+    { KEY_DOWN,       EVDEV_DOWN },
+    { KEY_A,          EVDEV_LEFT },
+    { KEY_LEFT,       EVDEV_LEFT },
+    { KEY_D,          EVDEV_RIGHT },
+    { KEY_RIGHT,      EVDEV_RIGHT },
+    { BTN_SOUTH,      EVDEV_SELECT },
+    { KEY_SPACE,      EVDEV_SELECT },
+    { KEY_ENTER,      EVDEV_SELECT },
+    { BTN_EAST,       EVDEV_BACK },
+    { BTN_START,      EVDEV_BACK },
+    { KEY_ESC,        EVDEV_BACK }
+};
+
+#define EVDEV_KEY_COUNT (int)(sizeof(_evdevKeys) / sizeof(_evdevKeys[0]))
+
+typedef struct {
+    int fd;
+    EvdevDecoder decoder;
+} EvdevDevice;
+
+static EvdevDevice evdev_devices[EVDEV_MAX_DEVICES];
+static int evdev_device_count = 0;
+
+static uint32_t _evdevKeyBit(uint16_t code)
+{
+    for (int i = 0; i < EVDEV_KEY_COUNT; i++)
+    {
+        if (_evdevKeys[i].code == code)
+            return 1u << i;
+    }
+
+    return 0;
+}
+
+static uint8_t _evdevHeld(uint32_t keys_held)
+{
+    uint8_t held = 0;
+    for (int i = 0; i < EVDEV_KEY_COUNT; i++)
+    {
+        if (keys_held & (1u << i))
+            held |= _evdevKeys[i].meaning;
+    }
+
+    return held;
+}
+
+// Called on SYN_REPORT, pushes the resolved state if it changed
+static int _evdevFlush(EvdevDecoder *dec, const struct input_event *syn, struct InputRing *ring)
+{
+    uint8_t held = _evdevHeld(dec->keys_held);
+
+    short mask = (held & 0xF) | dec->hat_state;
+
+    InputEvent ev = {0};
+    ev.timestamp_ns = (uint64_t)((int64_t)syn->input_event_sec * 1000000000LL
+                                 + (int64_t)syn->input_event_usec * 1000LL
+                                 + dec->clock_offset_ns);
+    ev.direction = (uint8_t)DirectionFromMask(ResolveSocd(&dec->socd, (uint8_t)mask));
+    ev.buttons = ((held & EVDEV_SELECT) ? INPUT_BUTTON_SELECT : 0)
+               | ((held & EVDEV_BACK) ? INPUT_BUTTON_BACK : 0);
+
+    if (dec->has_last && ev.direction == dec->last.direction && ev.buttons == dec->last.buttons)
+        return 0;
+
+    dec->last = ev;
+    dec->has_last = true;
+
+    PushInputEvent(ring, &ev);
+    return 1;
+}
+
+void InitEvdevDecoder(EvdevDecoder *dec, int64_t clock_offset_ns, SocdPolicy policy)
+{
+    memset(dec, 0, sizeof(EvdevDecoder));
+    dec->clock_offset_ns = clock_offset_ns;
+    InitSocdState(&dec->socd, policy);
+}
+
+int DecodeEvdevBytes(EvdevDecoder *dec, const void *bytes, size_t len, struct InputRing *ring)
+{
+    const unsigned char *p = bytes;
+    int pushed = 0;
+
+    for (size_t off = 0; off + sizeof(struct input_event) <= len; off += sizeof(struct input_event))
+    {
+        // Recorded buffers aren't guaranteed to be aligned
+        struct input_event ie;
+        memcpy(&ie, p + off, sizeof(ie));
+
+        switch (ie.type)
+        {
+            case EV_KEY:
+            {
+                // 2 is autorepeat, the key is already held
+                if (ie.value == 2)
+                    break;
+
+                uint32_t bit = _evdevKeyBit(ie.code);
+                if (ie.value)
+                    dec->keys_held |= bit;
+                else
+                    dec->keys_held &= ~bit;
+                break;
+            }
+
+            case EV_ABS:
+                if (ie.code == ABS_HAT0X)
+                {
+                    dec->hat_state &= ~(EVDEV_LEFT | EVDEV_RIGHT);
+                    if (ie.value < 0)
+                        dec->hat_state |= EVDEV_LEFT;
+                    else if (ie.value > 0)
+                        dec->hat_state |= EVDEV_RIGHT;
+                }
+                else if (ie.code == ABS_HAT0Y)
+                {
+                    dec->hat_state &= ~(EVDEV_UP | EVDEV_DOWN);
+                    if (ie.value < 0)
+                        dec->hat_state |= EVDEV_UP;
+                    else if (ie.value > 0)
+                        dec->hat_state |= EVDEV_DOWN;
+                }
+                break;
+
+            case EV_SYN:
+                if (ie.code == SYN_REPORT)
+                    pushed += _evdevFlush(dec, &ie, ring);
+                else if (ie.code == SYN_DROPPED)
+                {
+                    // Kernel buffer overran, held state is unknown until the
+                    // next full report so start from nothing
+                    dec->keys_held = 0;
+                    dec->hat_state = 0;
+                }
+                break;
+        }
+    }
+
+    return pushed;
+}
+
+static bool _testBit(const unsigned long *bits, int bit)
+{
+    const int per_long = (int)(sizeof(unsigned long) * 8);
+    return (bits[bit / per_long] >> (bit % per_long)) & 1;
+}
+
+// Only keep devices that can actually drive the trainer
+static bool _isUsefulDevice(int fd)
+{
+    unsigned long keybits[KEY_MAX / (sizeof(unsigned long) * 8) + 1] = {0};
+    unsigned long absbits[ABS_MAX / (sizeof(unsigned long) * 8) + 1] = {0};
+
+    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absbits)), absbits) >= 0 && _testBit(absbits, ABS_HAT0X))
+        return true;
+
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keybits)), keybits) < 0)
+        return false;
+
+    return _testBit(keybits, BTN_DPAD_LEFT) || _testBit(keybits, BTN_SOUTH) || _testBit(keybits, KEY_A);
+}
+
+bool OpenEvdevDevices(SocdPolicy policy)
+{
+    DIR *dir = opendir("/dev/input");
+    if (dir == NULL)
+    {
+        printf("Error opening /dev/input: %s\n", strerror(errno));
+        return false;
+    }
+
+    // Ask for CLOCK_MONOTONIC kernel stamps and work out how far that clock
+    // is from the input clock so every backend shares a time base
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t offset = (int64_t)InputClockNow() - ((int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec);
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && evdev_device_count < EVDEV_MAX_DEVICES)
+    {
+        if (strncmp(entry->d_name, "event", 5) != 0)
+            continue;
+
+        char path[280];
+        snprintf(path, sizeof(path), "/dev/input/%s", entry->d_name);
+
+        int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        int clock_id = CLOCK_MONOTONIC;
+        if (!_isUsefulDevice(fd) || ioctl(fd, EVIOCSCLOCKID, &clock_id) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        EvdevDevice *dev = &evdev_devices[evdev_device_count++];
+        dev->fd = fd;
+        InitEvdevDecoder(&dev->decoder, offset, policy);
+    }
+
+    closedir(dir);
+
+    if (evdev_device_count == 0)
+    {
+        printf("No readable evdev devices, is this user in the input group?\n");
+        return false;
+    }
+
+    return true;
+}
+
+void CloseEvdevDevices()
+{
+    for (int i = 0; i < evdev_device_count; i++)
+        close(evdev_devices[i].fd);
+
+    evdev_device_count = 0;
+}
+
+// Each device keeps its own held state and SOCD, and they are drained one
+// after another, so two devices changing within the same poll can reach the
+// ring out of timestamp order
+void PollEvdev(struct InputRing *ring)
+{
+    struct input_event batch[64];
+
+    for (int i = 0; i < evdev_device_count; i++)
+    {
+        ssize_t n;
+        while ((n = read(evdev_devices[i].fd, batch, sizeof(batch))) > 0)
+            DecodeEvdevBytes(&evdev_devices[i].decoder, batch, (size_t)n, ring);
+    }
+}
+
+#else
+
+bool OpenEvdevDevices(SocdPolicy policy)
+{
+    printf("The evdev input backend is only available on Linux\n");
+    return false;
+}
+
+void CloseEvdevDevices()
+{
+}
+
+void PollEvdev(struct InputRing *ring)
+{
+}
+
+void InitEvdevDecoder(EvdevDecoder *dec, int64_t clock_offset_ns, SocdPolicy policy)
+{
+    memset(dec, 0, sizeof(EvdevDecoder));
+    dec->clock_offset_ns = clock_offset_ns;
+    InitSocdState(&dec->socd, policy);
+}
+
+int DecodeEvdevBytes(EvdevDecoder *dec, const void *bytes, size_t len, struct InputRing *ring)
+{
+    return 0;
+}
+
+#endif
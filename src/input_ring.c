@@ -0,0 +1,30 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+
+#include "input_ring.h"
+
+void InitInputRing(InputRing *ring)
+{
+    InitSpscRing(&ring->ring, ring->events, sizeof(InputEvent), INPUT_RING_CAPACITY);
+}
+
+bool PushInputEvent(InputRing *ring, const InputEvent *ev)
+{
+    return PushSpscRing(&ring->ring, ev);
+}
+
+bool PopInputEvent(InputRing *ring, InputEvent *ev)
+{
+    return PopSpscRing(&ring->ring, ev);
+}
+
+bool InputRingFull(InputRing *ring)
+{
+    return SpscRingFull(&ring->ring);
+}
+
+int InputRingDropped(InputRing *ring)
+{
+    return SpscRingDropped(&ring->ring);
+}
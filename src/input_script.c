@@ -0,0 +1,261 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input.h"
+#include "input_ring.h"
+#include "input_source.h"
+#include "notation.h"
+
+typedef struct {
+    InputEvent *events;
+    int count;
+    int next;
+
+    // Script times are relative, anchored to the first poll
+    uint64_t start_ns;
+    bool started;
+} ScriptData;
+
+// Next whitespace separated word in [*p, end)
+static bool _nextWord(const char **p, const char *end, const char **word, size_t *len)
+{
+    while (*p < end && isspace((unsigned char)**p))
+        (*p)++;
+
+    if (*p == end)
+        return false;
+
+    *word = *p;
+    while (*p < end && !isspace((unsigned char)**p))
+        (*p)++;
+
+    *len = (size_t)(*p - *word);
+    return true;
+}
+
+static bool _parseTime(const char *word, size_t len, bool *relative, uint64_t *out_ns)
+{
+    size_t i = 0;
+    *relative = false;
+
+    if (len > 0 && word[0] == '+')
+    {
+        *relative = true;
+        i++;
+    }
+
+    if (i == len || !isdigit((unsigned char)word[i]))
+        return false;
+
+    uint64_t value = 0;
+    while (i < len && isdigit((unsigned char)word[i]))
+        value = value * 10 + (uint64_t)(word[i++] - '0');
+
+    const char *unit = word + i;
+    size_t unit_len = len - i;
+
+    if (unit_len == 0 || (unit_len == 1 && unit[0] == 'f'))
+        *out_ns = FRAMES_TO_NS(value);
+    else if (unit_len == 2 && strncmp(unit, "ms", 2) == 0)
+        *out_ns = value * 1000000ULL;
+    else if (unit_len == 2 && strncmp(unit, "us", 2) == 0)
+        *out_ns = value * 1000ULL;
+    else if (unit_len == 2 && strncmp(unit, "ns", 2) == 0)
+        *out_ns = value;
+    else
+        return false;
+
+    return true;
+}
+
+bool ParseInputScript(const char *text, size_t len, InputEvent **events, int *count)
+{
+    int capacity = 64;
+    int n = 0;
+    InputEvent *out = malloc(capacity * sizeof(InputEvent));
+    if (out == NULL)
+        return false;
+
+    uint64_t last_ns = 0;
+    int line_no = 0;
+
+    const char *p = text;
+    const char *end = text + len;
+
+    while (p < end)
+    {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        if (line_end == NULL)
+            line_end = end;
+
+        line_no++;
+
+        // Strip comments
+        const char *hash = memchr(p, '#', (size_t)(line_end - p));
+        const char *stop = hash != NULL ? hash : line_end;
+
+        const char *word;
+        size_t word_len;
+
+        if (_nextWord(&p, stop, &word, &word_len))
+        {
+            bool relative;
+            uint64_t t;
+            if (!_parseTime(word, word_len, &relative, &t))
+            {
+                printf("Script line %d: bad time '%.*s'\n", line_no, (int)word_len, word);
+                free(out);
+                return false;
+            }
+
+            t = relative ? last_ns + t : t;
+            if (t < last_ns)
+            {
+                printf("Script line %d: time goes backwards\n", line_no);
+                free(out);
+                return false;
+            }
+
+            GameDirection dir;
+            if (!_nextWord(&p, stop, &word, &word_len) || !ParseDirection(word, word_len, &dir))
+            {
+                printf("Script line %d: expected a direction\n", line_no);
+                free(out);
+                return false;
+            }
+
+            uint8_t buttons = 0;
+            while (_nextWord(&p, stop, &word, &word_len))
+            {
+                if (word_len == 6 && strncmp(word, "select", 6) == 0)
+                    buttons |= INPUT_BUTTON_SELECT;
+                else if (word_len == 4 && strncmp(word, "back", 4) == 0)
+                    buttons |= INPUT_BUTTON_BACK;
+                else
+                {
+                    printf("Script line %d: unknown button '%.*s'\n", line_no, (int)word_len, word);
+                    free(out);
+                    return false;
+                }
+            }
+
+            if (n == capacity)
+            {
+                capacity *= 2;
+                InputEvent *grown = realloc(out, capacity * sizeof(InputEvent));
+                if (grown == NULL)
+                {
+                    free(out);
+                    return false;
+                }
+                out = grown;
+            }
+
+            out[n].timestamp_ns = t;
+            out[n].direction = (uint8_t)dir;
+            out[n].buttons = buttons;
+            n++;
+
+            last_ns = t;
+        }
+
+        // The last line may have no newline
+        p = line_end < end ? line_end + 1 : end;
+    }
+
+    *events = out;
+    *count = n;
+    return true;
+}
+
+static bool _scriptSourcePoll(InputSource *source, uint64_t now_ns, InputRing *ring)
+{
+    ScriptData *script = source->data;
+
+    if (!script->started)
+    {
+        script->start_ns = now_ns;
+        script->started = true;
+    }
+
+    while (script->next < script->count)
+    {
+        InputEvent ev = script->events[script->next];
+        ev.timestamp_ns += script->start_ns;
+
+        if (ev.timestamp_ns > now_ns || !PushInputEvent(ring, &ev))
+            break;
+
+        script->next++;
+    }
+
+    return script->next < script->count;
+}
+
+static void _scriptSourceClose(InputSource *source)
+{
+    ScriptData *script = source->data;
+
+    free(script->events);
+    free(script);
+}
+
+bool OpenScriptSourceFromMemory(InputSource *source, const char *text, size_t len)
+{
+    memset(source, 0, sizeof(InputSource));
+
+    ScriptData *script = calloc(1, sizeof(ScriptData));
+    if (script == NULL)
+        return false;
+
+    if (!ParseInputScript(text, len, &script->events, &script->count))
+    {
+        free(script);
+        return false;
+    }
+
+    source->name = "script";
+    source->poll = _scriptSourcePoll;
+    source->close = _scriptSourceClose;
+    source->data = script;
+
+    return true;
+}
+
+bool OpenScriptSource(InputSource *source, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Error opening input script %s\n", path);
+        return false;
+    }
+
+    // A pipe or device has no size to read up to
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        printf("Error reading input script %s\n", path);
+        fclose(file);
+        return false;
+    }
+
+    char *text = malloc(size > 0 ? (size_t)size : 1);
+    if (text == NULL)
+    {
+        fclose(file);
+        return false;
+    }
+
+    size_t read = fread(text, 1, (size_t)size, file);
+    fclose(file);
+
+    bool ok = OpenScriptSourceFromMemory(source, text, read);
+    free(text);
+
+    return ok;
+}
@@ -0,0 +1,114 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "input.h"
+#include "input_ring.h"
+#include "input_source.h"
+#include "input_thread.h"
+#include "input_evdev.h"
+
+// Only transitions go in the ring, remember what was pushed last
+static InputEvent poll_last = {0};
+static bool poll_has_last = false;
+
+static bool _pollSourcePoll(InputSource *source, uint64_t now_ns, InputRing *ring)
+{
+    (void)source;
+    (void)now_ns;
+
+    InputEvent ev = ControllerToEvent(PollController());
+
+    if (!poll_has_last || ev.direction != poll_last.direction || ev.buttons != poll_last.buttons)
+    {
+        PushInputEvent(ring, &ev);
+        poll_last = ev;
+        poll_has_last = true;
+    }
+
+    return true;
+}
+
+// The thread and SDL events push on their own
+static bool _pushedElsewherePoll(InputSource *source, uint64_t now_ns, InputRing *ring)
+{
+    (void)source;
+    (void)now_ns;
+    (void)ring;
+
+    return true;
+}
+
+static void _threadSourceClose(InputSource *source)
+{
+    (void)source;
+
+    StopInputThread();
+}
+
+static bool _evdevSourcePoll(InputSource *source, uint64_t now_ns, InputRing *ring)
+{
+    (void)source;
+    (void)now_ns;
+
+    PollEvdev(ring);
+    return true;
+}
+
+static void _evdevSourceClose(InputSource *source)
+{
+    (void)source;
+
+    CloseEvdevDevices();
+}
+
+bool OpenInputSource(InputSource *source, InputBackend backend, SocdPolicy policy)
+{
+    SDL_zerop(source);
+    SetInputBackend(backend);
+
+    switch (backend)
+    {
+        case INPUT_BACKEND_POLL:
+            source->name = "poll";
+            source->poll = _pollSourcePoll;
+            poll_has_last = false;
+            return true;
+
+        case INPUT_BACKEND_THREAD:
+            if (!StartInputThread(INPUT_THREAD_DEFAULT_HZ))
+                return false;
+
+            source->name = "thread";
+            source->poll = _pushedElsewherePoll;
+            source->close = _threadSourceClose;
+            return true;
+
+        case INPUT_BACKEND_EVENTS:
+            source->name = "events";
+            source->poll = _pushedElsewherePoll;
+            return true;
+
+        case INPUT_BACKEND_EVDEV:
+            if (!OpenEvdevDevices(policy))
+                return false;
+
+            source->name = "evdev";
+            source->poll = _evdevSourcePoll;
+            source->close = _evdevSourceClose;
+            return true;
+
+        default:
+            printf("Input backend %d can't be opened as a live source\n", backend);
+            return false;
+    }
+}
+
+void CloseInputSource(InputSource *source)
+{
+    if (source->close != NULL)
+        source->close(source);
+
+    SDL_zerop(source);
+}
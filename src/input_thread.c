@@ -0,0 +1,99 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "input.h"
+#include "input_ring.h"
+#include "input_thread.h"
+
+static InputRing input_ring;
+
+static SDL_Thread *input_thread = NULL;
+static SDL_AtomicInt input_thread_running;
+
+static Uint64 sample_period = 0;
+
+static int _inputThreadMain(void *data)
+{
+    (void)data;
+
+    ControllerState last = {0};
+    last.direction = DISCONNECTED;
+
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    Uint64 next_sample = InputClockNow();
+
+    while (SDL_GetAtomicInt(&input_thread_running))
+    {
+        ControllerState *cs = SampleController();
+
+        // Only transitions are interesting, the consumer holds the last state
+        if (cs->direction != last.direction
+            || cs->select_pressed != last.select_pressed
+            || cs->back_pressed != last.back_pressed)
+        {
+            InputEvent ev = ControllerToEvent(cs);
+            PushInputEvent(&input_ring, &ev);
+            last = *cs;
+        }
+
+        // Sleep to the next slot on a fixed grid so the rate doesn't drift
+        next_sample += sample_period;
+        Uint64 now = InputClockNow();
+        if (next_sample > now)
+            SDL_DelayPrecise(next_sample - now);
+        else
+            next_sample = now;
+    }
+
+    return 0;
+}
+
+bool StartInputThread(int hz)
+{
+    if (input_thread != NULL)
+        return true;
+
+    if (hz <= 0)
+        hz = INPUT_THREAD_DEFAULT_HZ;
+
+    sample_period = 1000000000ULL / (Uint64)hz;
+    InitInputRing(&input_ring);
+
+    SDL_SetAtomicInt(&input_thread_running, 1);
+    input_thread = SDL_CreateThread(_inputThreadMain, "KBDInput", NULL);
+    if (input_thread == NULL)
+    {
+        printf("Error starting input thread: %s\n", SDL_GetError());
+        SDL_SetAtomicInt(&input_thread_running, 0);
+        return false;
+    }
+
+    return true;
+}
+
+void StopInputThread()
+{
+    if (input_thread == NULL)
+        return;
+
+    SDL_SetAtomicInt(&input_thread_running, 0);
+    SDL_WaitThread(input_thread, NULL);
+    input_thread = NULL;
+
+    int dropped = InputRingDropped(&input_ring);
+    if (dropped > 0)
+        printf("Input thread dropped %d events\n", dropped);
+}
+
+bool InputThreadRunning()
+{
+    return input_thread != NULL;
+}
+
+InputRing *GetInputRing()
+{
+    return &input_ring;
+}
@@ -0,0 +1,135 @@
+#include "judge.h"
+
+void ResetGameState(GameState *gs, GameMode *mode, uint64_t highscore)
+{
+    gs->player_pos = 0;
+    gs->score = 0;
+    gs->highscore = highscore;
+    gs->curr_input = NEUTRAL;
+
+    gs->last_input = NEUTRAL;
+    gs->last_input_acc = NONE;
+    gs->held_state = -1;
+    gs->step_start_ns = 0;
+    gs->last_timing = TIMING_NONE;
+    gs->miss_time = 0;
+    gs->in_miss_pause = false;
+    gs->completions = 0;
+
+    gs->current_mode = mode;
+    gs->run_game = true;
+}
+
+static const int timing_points[TIMING_COUNT] = {
+    [TIMING_NONE]    = JUDGE_POINTS,
+    [TIMING_JUST]    = JUDGE_POINTS,
+    [TIMING_EARLY]   = JUDGE_POINTS_OFF,
+    [TIMING_LATE]    = JUDGE_POINTS_OFF,
+    [TIMING_DROPPED] = 0
+};
+
+TimingVerdict GradeHold(const StepWindow *window, uint64_t held_ns)
+{
+    uint64_t frames = (held_ns * GAME_FRAME_RATE + 500000000ULL) / 1000000000ULL;
+
+    if (frames == 0)
+        return TIMING_DROPPED;
+    if (frames < window->min_frames)
+        return TIMING_EARLY;
+    if (frames > window->max_frames)
+        return TIMING_LATE;
+
+    return TIMING_JUST;
+}
+
+void EndMissPause(GameState *gs)
+{
+    gs->player_pos = 0;
+    gs->score = 0;
+    gs->last_input_acc = NONE;
+    gs->in_miss_pause = false;
+    gs->held_state = -1;
+}
+
+JudgeResult JudgeInput(GameState *gs, GameDirection *prev, const ControllerState *cs)
+{
+    gs->curr_input = cs->direction;
+
+    // The pause runs from the missed input, not from whenever the next
+    // update happens to arrive
+    if (gs->in_miss_pause)
+    {
+        if (cs->timestamp_ns - gs->miss_time < MISS_PAUSE_NS)
+        {
+            *prev = cs->direction;
+            return JUDGE_PAUSED;
+        }
+
+        // Reset after pause, then judge this input as usual
+        EndMissPause(gs);
+    }
+
+    if (cs->back_pressed)
+        return JUDGE_QUIT;
+
+    // No update if input has not changed
+    if (cs->direction == *prev)
+        return JUDGE_NONE;
+
+    *prev = cs->direction;
+
+    const PatternDfa *dfa = gs->current_mode->dfa;
+    int state = gs->player_pos;
+    uint8_t next = dfa->next[state][cs->direction];
+
+    // A finished technique that this input doesn't extend, start the
+    // next one with it
+    if (next == PATTERN_DEAD && dfa->accepting[state])
+    {
+        gs->completions++;
+        state = PATTERN_START;
+        next = dfa->next[state][cs->direction];
+    }
+
+    if (next != PATTERN_DEAD)
+    {
+        // Correct input, the step it ends is graded first
+        gs->last_timing = TIMING_NONE;
+        if (gs->held_state >= 0 && dfa->window[gs->held_state].max_frames != 0)
+            gs->last_timing = GradeHold(&dfa->window[gs->held_state], cs->timestamp_ns - gs->step_start_ns);
+
+        gs->held_state = next;
+        gs->step_start_ns = cs->timestamp_ns;
+
+        gs->score += timing_points[gs->last_timing];
+        if (gs->score > gs->highscore)
+            gs->highscore = gs->score;
+
+        if (dfa->final[next])
+        {
+            gs->completions++;
+            next = PATTERN_START;
+        }
+        gs->player_pos = next;
+
+        gs->last_input = cs->direction;
+        gs->last_input_acc = SUCCESS;
+        return JUDGE_HIT;
+    }
+
+    // Incorrect input, only counts once the pattern has been started
+    if (state == PATTERN_START)
+    {
+        gs->player_pos = PATTERN_START;
+        gs->held_state = -1;
+        return JUDGE_NONE;
+    }
+
+    gs->last_input = cs->direction;
+    gs->last_input_acc = FAIL;
+    gs->last_timing = TIMING_NONE;
+    gs->held_state = -1;
+    gs->miss_time = cs->timestamp_ns;
+    gs->in_miss_pause = true;
+    return JUDGE_MISS;
+}
@@ -0,0 +1,626 @@
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "judge_batch.h"
+#include "simd.h"
+
+// Transition word layout
+#define T_POS(t)    ((t) & 0xFF)
+#define T_HELD(t)   (((t) >> 8) & 0xFF)
+#define T_COMP(t)   (((t) >> 16) & 0x3)
+#define T_HIT       (1u << 24)
+#define T_MISS      (1u << 25)
+
+#define LANE_FIELDS (18 + TIMING_COUNT)
+
+static const uint32_t timing_points[TIMING_COUNT] = {
+    [TIMING_NONE]    = JUDGE_POINTS,
+    [TIMING_JUST]    = JUDGE_POINTS,
+    [TIMING_EARLY]   = JUDGE_POINTS_OFF,
+    [TIMING_LATE]    = JUDGE_POINTS_OFF,
+    [TIMING_DROPPED] = 0
+};
+
+// Scores past this get a lane flagged, one more hit can't wrap it
+#define SCORE_LIMIT (UINT32_MAX - 2 * JUDGE_POINTS)
+
+static const char *_kernelNames[JUDGE_KERNEL_COUNT] = {
+    [JUDGE_KERNEL_SCALAR] = "scalar",
+    [JUDGE_KERNEL_SSE2]   = "sse2",
+    [JUDGE_KERNEL_AVX2]   = "avx2"
+};
+
+const char *JudgeKernelName(JudgeKernel kernel)
+{
+    return kernel < JUDGE_KERNEL_COUNT ? _kernelNames[kernel] : "?";
+}
+
+// JudgeInput() for every (state, direction) worked out up front: where
+// the lane goes, what it holds, how many techniques that finishes and
+// whether it's a hit, a miss or neither. Holding a state without a
+// window grades the same as holding nothing.
+static void _buildTransitions(JudgeBatch *batch, const PatternDfa *dfa)
+{
+    for (int s = 0; s < PATTERN_MAX_STATES; s++)
+    {
+        for (int d = 0; d < JUDGE_BATCH_COLUMNS; d++)
+        {
+            uint32_t t = (uint32_t)s | (JUDGE_BATCH_NO_STATE << 8);
+
+            if (s < dfa->state_count && d < PATTERN_COLUMNS)
+            {
+                int state = s;
+                uint32_t comp = 0;
+                uint8_t next = dfa->next[state][d];
+
+                if (next == PATTERN_DEAD && dfa->accepting[state])
+                {
+                    comp++;
+                    state = PATTERN_START;
+                    next = dfa->next[state][d];
+                }
+
+                if (next != PATTERN_DEAD)
+                {
+                    uint32_t held = dfa->window[next].max_frames != 0 ? next : JUDGE_BATCH_NO_STATE;
+                    comp += dfa->final[next] ? 1 : 0;
+                    t = (dfa->final[next] ? PATTERN_START : next) | (held << 8) | T_HIT;
+                }
+                else if (state == PATTERN_START)
+                    t = PATTERN_START | (JUDGE_BATCH_NO_STATE << 8);
+                else
+                    t = (uint32_t)s | (JUDGE_BATCH_NO_STATE << 8) | T_MISS;
+
+                t |= comp << 16;
+            }
+
+            batch->transitions[s * JUDGE_BATCH_COLUMNS + d] = t;
+        }
+    }
+}
+
+// Shortest hold that GradeHold() rounds to at least frames
+static uint64_t _framesThreshold(uint64_t frames)
+{
+    if (frames == 0)
+        return 0;
+
+    uint64_t scaled = frames * 1000000000ULL - 500000000ULL;
+    return (scaled + GAME_FRAME_RATE - 1) / GAME_FRAME_RATE;
+}
+
+static bool _buildWindows(JudgeBatch *batch, const PatternDfa *dfa)
+{
+    batch->drop_ns = (uint32_t)_framesThreshold(1);
+
+    for (int s = 0; s <= PATTERN_MAX_STATES; s++)
+    {
+        batch->early_ns[s] = 0;
+        batch->late_ns[s] = UINT32_MAX;
+
+        if (s >= dfa->state_count || dfa->window[s].max_frames == 0)
+            continue;
+
+        uint64_t late = _framesThreshold((uint64_t)dfa->window[s].max_frames + 1);
+        if (late > UINT32_MAX)
+            return false;
+
+        batch->early_ns[s] = (uint32_t)_framesThreshold(dfa->window[s].min_frames);
+        batch->late_ns[s] = (uint32_t)late;
+    }
+
+    return true;
+}
+
+bool InitJudgeBatch(JudgeBatch *batch, const GameMode *mode, int lanes)
+{
+    memset(batch, 0, sizeof(*batch));
+
+    if (mode->dfa == NULL || lanes <= 0)
+        return false;
+
+    if (!_buildWindows(batch, mode->dfa))
+    {
+        printf("%s has step windows too long to judge in batches\n", mode->mode_name);
+        return false;
+    }
+    _buildTransitions(batch, mode->dfa);
+
+    batch->lanes = (lanes + JUDGE_BATCH_ALIGN - 1) / JUDGE_BATCH_ALIGN * JUDGE_BATCH_ALIGN;
+    batch->block = calloc((size_t)batch->lanes * LANE_FIELDS, sizeof(uint32_t));
+    if (batch->block == NULL)
+        return false;
+
+    uint32_t **fields[LANE_FIELDS - TIMING_COUNT] = {
+        &batch->pos, &batch->held, &batch->prev, &batch->pausing, &batch->quit,
+        &batch->step_lo, &batch->step_hi, &batch->miss_lo, &batch->miss_hi,
+        &batch->inputs, &batch->hits, &batch->misses, &batch->paused, &batch->resets,
+        &batch->completions, &batch->score, &batch->highscore, &batch->overflow
+    };
+
+    uint32_t *p = batch->block;
+    for (int f = 0; f < LANE_FIELDS - TIMING_COUNT; f++, p += batch->lanes)
+        *fields[f] = p;
+    for (int v = 0; v < TIMING_COUNT; v++, p += batch->lanes)
+        batch->timing[v] = p;
+
+    ResetJudgeBatch(batch);
+
+    batch->kernel = JUDGE_KERNEL_SCALAR;
+    if (!SetJudgeKernel(batch, JUDGE_KERNEL_AVX2))
+        SetJudgeKernel(batch, JUDGE_KERNEL_SSE2);
+
+    return true;
+}
+
+void DestroyJudgeBatch(JudgeBatch *batch)
+{
+    free(batch->block);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void ResetJudgeBatch(JudgeBatch *batch)
+{
+    for (int i = 0; i < batch->lanes; i++)
+        ResetJudgeLane(batch, i);
+}
+
+void ResetJudgeLane(JudgeBatch *batch, int lane)
+{
+    // Fields are lanes apart in the block
+    for (int f = 0; f < LANE_FIELDS; f++)
+        batch->block[(size_t)f * batch->lanes + lane] = 0;
+
+    batch->prev[lane] = NEUTRAL;
+    batch->held[lane] = JUDGE_BATCH_NO_STATE;
+}
+
+bool SetJudgeKernel(JudgeBatch *batch, JudgeKernel kernel)
+{
+    switch (kernel)
+    {
+        case JUDGE_KERNEL_SCALAR:
+            break;
+#ifdef SIMD_X86
+        case JUDGE_KERNEL_SSE2:
+            if (!SDL_HasSSE2())
+                return false;
+            break;
+        case JUDGE_KERNEL_AVX2:
+            if (!SDL_HasAVX2())
+                return false;
+            break;
+#endif
+        default:
+            return false;
+    }
+
+    batch->kernel = kernel;
+    return true;
+}
+
+// Time since an earlier one, saturated at 2^32 - 1
+static inline uint32_t _since(uint32_t lo, uint32_t hi, uint32_t past_lo, uint32_t past_hi)
+{
+    uint32_t borrow = lo < past_lo;
+    uint32_t dhi = hi - past_hi - borrow;
+    return dhi != 0 ? UINT32_MAX : lo - past_lo;
+}
+
+// The reference, every wider kernel has to agree with it bit for bit
+static void _stepLane(JudgeBatch *b, int i, uint8_t input, uint32_t lo, uint32_t hi)
+{
+    if (input == JUDGE_BATCH_IDLE || b->quit[i])
+        return;
+
+    uint32_t dir = input & ~JUDGE_BATCH_BACK;
+    bool expired = false;
+
+    b->inputs[i]++;
+
+    if (b->pausing[i])
+    {
+        if (_since(lo, hi, b->miss_lo[i], b->miss_hi[i]) < MISS_PAUSE_NS)
+        {
+            b->prev[i] = dir;
+            b->paused[i]++;
+            return;
+        }
+
+        b->pos[i] = PATTERN_START;
+        b->score[i] = 0;
+        b->pausing[i] = 0;
+        b->held[i] = JUDGE_BATCH_NO_STATE;
+        expired = true;
+    }
+
+    if (input & JUDGE_BATCH_BACK)
+    {
+        b->quit[i] = UINT32_MAX;
+        b->resets[i] += expired;
+        return;
+    }
+
+    if (dir == b->prev[i])
+    {
+        b->resets[i] += expired;
+        return;
+    }
+
+    b->prev[i] = dir;
+
+    uint32_t t = b->transitions[b->pos[i] * JUDGE_BATCH_COLUMNS + dir];
+    b->completions[i] += T_COMP(t);
+
+    if (t & T_HIT)
+    {
+        uint32_t held = b->held[i];
+        uint32_t held_ns = _since(lo, hi, b->step_lo[i], b->step_hi[i]);
+        TimingVerdict timing = TIMING_NONE;
+
+        if (held != JUDGE_BATCH_NO_STATE)
+        {
+            if (held_ns < b->drop_ns)
+                timing = TIMING_DROPPED;
+            else if (held_ns < b->early_ns[held])
+                timing = TIMING_EARLY;
+            else if (held_ns >= b->late_ns[held])
+                timing = TIMING_LATE;
+            else
+                timing = TIMING_JUST;
+        }
+
+        b->timing[timing][i]++;
+        b->score[i] += timing_points[timing];
+        if (b->score[i] > b->highscore[i])
+            b->highscore[i] = b->score[i];
+        if (b->score[i] > SCORE_LIMIT)
+            b->overflow[i] = UINT32_MAX;
+
+        b->hits[i]++;
+        b->step_lo[i] = lo;
+        b->step_hi[i] = hi;
+    }
+    else if (t & T_MISS)
+    {
+        b->misses[i]++;
+        b->miss_lo[i] = lo;
+        b->miss_hi[i] = hi;
+        b->pausing[i] = UINT32_MAX;
+        expired = false;
+    }
+
+    b->pos[i] = T_POS(t);
+    b->held[i] = T_HELD(t);
+    b->resets[i] += expired;
+}
+
+static void _stepScalar(JudgeBatch *b, const uint8_t *inputs, const uint32_t *lo, const uint32_t *hi)
+{
+    for (int i = 0; i < b->lanes; i++)
+        _stepLane(b, i, inputs[i], lo[i], hi[i]);
+}
+
+#ifdef SIMD_X86
+
+// SSE2 has no unsigned compares, flip the sign bits and compare signed
+static inline __m128i _ult128(__m128i a, __m128i b)
+{
+    const __m128i sign = _mm_set1_epi32((int)0x80000000);
+    return _mm_cmpgt_epi32(_mm_xor_si128(b, sign), _mm_xor_si128(a, sign));
+}
+
+static inline __m128i _select128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i _since128(__m128i lo, __m128i hi, __m128i past_lo, __m128i past_hi)
+{
+    // borrow is all ones, adding it takes one away
+    __m128i borrow = _ult128(lo, past_lo);
+    __m128i dhi = _mm_add_epi32(_mm_sub_epi32(hi, past_hi), borrow);
+    __m128i big = _mm_xor_si128(_mm_cmpeq_epi32(dhi, _mm_setzero_si128()), _mm_set1_epi32(-1));
+    return _mm_or_si128(_mm_sub_epi32(lo, past_lo), big);
+}
+
+// No gathers before AVX2
+static inline __m128i _gather128(const uint32_t *table, __m128i index)
+{
+    uint32_t idx[4];
+    _mm_storeu_si128((__m128i *)idx, index);
+    return _mm_set_epi32((int)table[idx[3]], (int)table[idx[2]], (int)table[idx[1]], (int)table[idx[0]]);
+}
+
+#define LOAD128(p) _mm_loadu_si128((const __m128i *)(p))
+#define STORE128(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+
+static void _stepSse2(JudgeBatch *b, const uint8_t *inputs, const uint32_t *ts_lo, const uint32_t *ts_hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i idle = _mm_set1_epi32(JUDGE_BATCH_IDLE);
+    const __m128i back_bit = _mm_set1_epi32(JUDGE_BATCH_BACK);
+    const __m128i pause_ns = _mm_set1_epi32((int)MISS_PAUSE_NS);
+    const __m128i no_state = _mm_set1_epi32(JUDGE_BATCH_NO_STATE);
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128i three = _mm_set1_epi32(3);
+    const __m128i hit_bit = _mm_set1_epi32((int)T_HIT);
+    const __m128i miss_bit = _mm_set1_epi32((int)T_MISS);
+    const __m128i full_points = _mm_set1_epi32(JUDGE_POINTS);
+    const __m128i off_points = _mm_set1_epi32(JUDGE_POINTS_OFF);
+    const __m128i limit = _mm_set1_epi32((int)SCORE_LIMIT);
+    const __m128i drop_ns = _mm_set1_epi32((int)b->drop_ns);
+
+    for (int i = 0; i < b->lanes; i += 4)
+    {
+        int packed;
+        memcpy(&packed, inputs + i, sizeof(packed));
+        __m128i input = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        __m128i lo = LOAD128(ts_lo + i);
+        __m128i hi = LOAD128(ts_hi + i);
+
+        __m128i quit = LOAD128(b->quit + i);
+        __m128i active = _mm_andnot_si128(_mm_or_si128(quit, _mm_cmpeq_epi32(input, idle)), ones);
+        if (_mm_movemask_epi8(active) == 0)
+            continue;
+
+        __m128i dir = _mm_andnot_si128(back_bit, input);
+        __m128i back = _mm_cmpeq_epi32(_mm_and_si128(input, back_bit), back_bit);
+        STORE128(b->inputs + i, _mm_sub_epi32(LOAD128(b->inputs + i), active));
+
+        __m128i pos = LOAD128(b->pos + i);
+        __m128i held = LOAD128(b->held + i);
+        __m128i prev = LOAD128(b->prev + i);
+        __m128i score = LOAD128(b->score + i);
+        __m128i pausing = LOAD128(b->pausing + i);
+        __m128i swallowed = zero;
+        __m128i expired = zero;
+
+        // Miss pause, swallowed or expired. Rare, skipped unless a lane
+        // here is in one.
+        if (_mm_movemask_epi8(_mm_and_si128(pausing, active)) != 0)
+        {
+            __m128i since_miss = _since128(lo, hi, LOAD128(b->miss_lo + i), LOAD128(b->miss_hi + i));
+            swallowed = _mm_and_si128(_mm_and_si128(pausing, active), _ult128(since_miss, pause_ns));
+            expired = _mm_andnot_si128(swallowed, _mm_and_si128(pausing, active));
+
+            pos = _mm_andnot_si128(expired, pos);
+            score = _mm_andnot_si128(expired, score);
+            held = _select128(expired, no_state, held);
+            prev = _select128(swallowed, dir, prev);
+            pausing = _mm_andnot_si128(expired, pausing);
+            STORE128(b->paused + i, _mm_sub_epi32(LOAD128(b->paused + i), swallowed));
+        }
+
+        __m128i live = _mm_andnot_si128(swallowed, active);
+        if (_mm_movemask_epi8(_mm_and_si128(live, back)) != 0)
+            STORE128(b->quit + i, _mm_or_si128(quit, _mm_and_si128(live, back)));
+
+        __m128i judge = _mm_andnot_si128(_mm_or_si128(back, _mm_cmpeq_epi32(dir, prev)), live);
+        prev = _select128(judge, dir, prev);
+
+        __m128i t = _gather128(b->transitions, _mm_add_epi32(_mm_slli_epi32(pos, 4), dir));
+        __m128i hit = _mm_and_si128(judge, _mm_cmpeq_epi32(_mm_and_si128(t, hit_bit), hit_bit));
+        __m128i miss = _mm_and_si128(judge, _mm_cmpeq_epi32(_mm_and_si128(t, miss_bit), miss_bit));
+
+        __m128i comp = _mm_and_si128(judge, _mm_and_si128(_mm_srli_epi32(t, 16), three));
+        STORE128(b->completions + i, _mm_add_epi32(LOAD128(b->completions + i), comp));
+
+        // Grade the hold of the step each hit ends
+        __m128i held_ns = _since128(lo, hi, LOAD128(b->step_lo + i), LOAD128(b->step_hi + i));
+        __m128i graded = _mm_andnot_si128(_mm_cmpeq_epi32(held, no_state), ones);
+        __m128i drop = _mm_and_si128(graded, _ult128(held_ns, drop_ns));
+        __m128i early = _mm_andnot_si128(drop, _mm_and_si128(graded, _ult128(held_ns, _gather128(b->early_ns, held))));
+        __m128i late = _mm_andnot_si128(_mm_or_si128(drop, early),
+            _mm_andnot_si128(_ult128(held_ns, _gather128(b->late_ns, held)), graded));
+        __m128i just = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(drop, early), late), graded);
+        __m128i none = _mm_andnot_si128(graded, ones);
+
+        __m128i verdicts[TIMING_COUNT] = { none, just, early, late, drop };
+        for (int v = 0; v < TIMING_COUNT; v++)
+            STORE128(b->timing[v] + i, _mm_sub_epi32(LOAD128(b->timing[v] + i), _mm_and_si128(hit, verdicts[v])));
+
+        __m128i points = _mm_or_si128(_mm_and_si128(_mm_or_si128(none, just), full_points),
+            _mm_and_si128(_mm_or_si128(early, late), off_points));
+        score = _mm_add_epi32(score, _mm_and_si128(hit, points));
+
+        __m128i highscore = LOAD128(b->highscore + i);
+        STORE128(b->highscore + i, _select128(_ult128(highscore, score), score, highscore));
+        STORE128(b->overflow + i, _mm_or_si128(LOAD128(b->overflow + i), _ult128(limit, score)));
+
+        STORE128(b->hits + i, _mm_sub_epi32(LOAD128(b->hits + i), hit));
+        STORE128(b->step_lo + i, _select128(hit, lo, LOAD128(b->step_lo + i)));
+        STORE128(b->step_hi + i, _select128(hit, hi, LOAD128(b->step_hi + i)));
+
+        if (_mm_movemask_epi8(miss) != 0)
+        {
+            STORE128(b->misses + i, _mm_sub_epi32(LOAD128(b->misses + i), miss));
+            STORE128(b->miss_lo + i, _select128(miss, lo, LOAD128(b->miss_lo + i)));
+            STORE128(b->miss_hi + i, _select128(miss, hi, LOAD128(b->miss_hi + i)));
+            pausing = _mm_or_si128(pausing, miss);
+        }
+
+        // A reset only counts if this input didn't miss straight away
+        if (_mm_movemask_epi8(expired) != 0)
+            STORE128(b->resets + i, _mm_sub_epi32(LOAD128(b->resets + i), _mm_andnot_si128(miss, expired)));
+
+        STORE128(b->pos + i, _select128(judge, _mm_and_si128(t, byte), pos));
+        STORE128(b->held + i, _select128(judge, _mm_and_si128(_mm_srli_epi32(t, 8), byte), held));
+        STORE128(b->prev + i, prev);
+        STORE128(b->score + i, score);
+        STORE128(b->pausing + i, pausing);
+    }
+}
+
+static inline TARGET_AVX2 __m256i _ult256(__m256i a, __m256i b)
+{
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000);
+    return _mm256_cmpgt_epi32(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+}
+
+static inline TARGET_AVX2 __m256i _since256(__m256i lo, __m256i hi, __m256i past_lo, __m256i past_hi)
+{
+    __m256i borrow = _ult256(lo, past_lo);
+    __m256i dhi = _mm256_add_epi32(_mm256_sub_epi32(hi, past_hi), borrow);
+    __m256i big = _mm256_xor_si256(_mm256_cmpeq_epi32(dhi, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+    return _mm256_or_si256(_mm256_sub_epi32(lo, past_lo), big);
+}
+
+#define GATHER256(table, index) _mm256_i32gather_epi32((const int *)(table), (index), 4)
+#define LOAD256(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE256(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#define SELECT256(mask, a, b) _mm256_blendv_epi8((b), (a), (mask))
+
+static TARGET_AVX2 void _stepAvx2(JudgeBatch *b, const uint8_t *inputs, const uint32_t *ts_lo, const uint32_t *ts_hi)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i idle = _mm256_set1_epi32(JUDGE_BATCH_IDLE);
+    const __m256i back_bit = _mm256_set1_epi32(JUDGE_BATCH_BACK);
+    const __m256i pause_ns = _mm256_set1_epi32((int)MISS_PAUSE_NS);
+    const __m256i no_state = _mm256_set1_epi32(JUDGE_BATCH_NO_STATE);
+    const __m256i byte = _mm256_set1_epi32(0xFF);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i hit_bit = _mm256_set1_epi32((int)T_HIT);
+    const __m256i miss_bit = _mm256_set1_epi32((int)T_MISS);
+    const __m256i full_points = _mm256_set1_epi32(JUDGE_POINTS);
+    const __m256i off_points = _mm256_set1_epi32(JUDGE_POINTS_OFF);
+    const __m256i limit = _mm256_set1_epi32((int)SCORE_LIMIT);
+    const __m256i drop_ns = _mm256_set1_epi32((int)b->drop_ns);
+
+    for (int i = 0; i < b->lanes; i += 8)
+    {
+        __m256i input = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(inputs + i)));
+        __m256i lo = LOAD256(ts_lo + i);
+        __m256i hi = LOAD256(ts_hi + i);
+
+        __m256i quit = LOAD256(b->quit + i);
+        __m256i active = _mm256_andnot_si256(_mm256_or_si256(quit, _mm256_cmpeq_epi32(input, idle)), ones);
+        if (_mm256_movemask_epi8(active) == 0)
+            continue;
+
+        __m256i dir = _mm256_andnot_si256(back_bit, input);
+        __m256i back = _mm256_cmpeq_epi32(_mm256_and_si256(input, back_bit), back_bit);
+        STORE256(b->inputs + i, _mm256_sub_epi32(LOAD256(b->inputs + i), active));
+
+        __m256i pos = LOAD256(b->pos + i);
+        __m256i held = LOAD256(b->held + i);
+        __m256i prev = LOAD256(b->prev + i);
+        __m256i score = LOAD256(b->score + i);
+        __m256i pausing = LOAD256(b->pausing + i);
+        __m256i swallowed = zero;
+        __m256i expired = zero;
+
+        if (_mm256_movemask_epi8(_mm256_and_si256(pausing, active)) != 0)
+        {
+            __m256i since_miss = _since256(lo, hi, LOAD256(b->miss_lo + i), LOAD256(b->miss_hi + i));
+            swallowed = _mm256_and_si256(_mm256_and_si256(pausing, active), _ult256(since_miss, pause_ns));
+            expired = _mm256_andnot_si256(swallowed, _mm256_and_si256(pausing, active));
+
+            pos = _mm256_andnot_si256(expired, pos);
+            score = _mm256_andnot_si256(expired, score);
+            held = SELECT256(expired, no_state, held);
+            prev = SELECT256(swallowed, dir, prev);
+            pausing = _mm256_andnot_si256(expired, pausing);
+            STORE256(b->paused + i, _mm256_sub_epi32(LOAD256(b->paused + i), swallowed));
+        }
+
+        __m256i live = _mm256_andnot_si256(swallowed, active);
+        if (_mm256_movemask_epi8(_mm256_and_si256(live, back)) != 0)
+            STORE256(b->quit + i, _mm256_or_si256(quit, _mm256_and_si256(live, back)));
+
+        __m256i judge = _mm256_andnot_si256(_mm256_or_si256(back, _mm256_cmpeq_epi32(dir, prev)), live);
+        prev = SELECT256(judge, dir, prev);
+
+        __m256i t = GATHER256(b->transitions, _mm256_add_epi32(_mm256_slli_epi32(pos, 4), dir));
+        __m256i hit = _mm256_and_si256(judge, _mm256_cmpeq_epi32(_mm256_and_si256(t, hit_bit), hit_bit));
+        __m256i miss = _mm256_and_si256(judge, _mm256_cmpeq_epi32(_mm256_and_si256(t, miss_bit), miss_bit));
+
+        __m256i comp = _mm256_and_si256(judge, _mm256_and_si256(_mm256_srli_epi32(t, 16), three));
+        STORE256(b->completions + i, _mm256_add_epi32(LOAD256(b->completions + i), comp));
+
+        __m256i held_ns = _since256(lo, hi, LOAD256(b->step_lo + i), LOAD256(b->step_hi + i));
+        __m256i graded = _mm256_andnot_si256(_mm256_cmpeq_epi32(held, no_state), ones);
+        __m256i drop = _mm256_and_si256(graded, _ult256(held_ns, drop_ns));
+        __m256i early = _mm256_andnot_si256(drop, _mm256_and_si256(graded, _ult256(held_ns, GATHER256(b->early_ns, held))));
+        __m256i late = _mm256_andnot_si256(_mm256_or_si256(drop, early),
+            _mm256_andnot_si256(_ult256(held_ns, GATHER256(b->late_ns, held)), graded));
+        __m256i just = _mm256_andnot_si256(_mm256_or_si256(_mm256_or_si256(drop, early), late), graded);
+        __m256i none = _mm256_andnot_si256(graded, ones);
+
+        __m256i verdicts[TIMING_COUNT] = { none, just, early, late, drop };
+        for (int v = 0; v < TIMING_COUNT; v++)
+            STORE256(b->timing[v] + i, _mm256_sub_epi32(LOAD256(b->timing[v] + i), _mm256_and_si256(hit, verdicts[v])));
+
+        __m256i points = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(none, just), full_points),
+            _mm256_and_si256(_mm256_or_si256(early, late), off_points));
+        score = _mm256_add_epi32(score, _mm256_and_si256(hit, points));
+
+        STORE256(b->highscore + i, _mm256_max_epu32(LOAD256(b->highscore + i), score));
+        STORE256(b->overflow + i, _mm256_or_si256(LOAD256(b->overflow + i), _ult256(limit, score)));
+
+        STORE256(b->hits + i, _mm256_sub_epi32(LOAD256(b->hits + i), hit));
+        STORE256(b->step_lo + i, SELECT256(hit, lo, LOAD256(b->step_lo + i)));
+        STORE256(b->step_hi + i, SELECT256(hit, hi, LOAD256(b->step_hi + i)));
+
+        if (_mm256_movemask_epi8(miss) != 0)
+        {
+            STORE256(b->misses + i, _mm256_sub_epi32(LOAD256(b->misses + i), miss));
+            STORE256(b->miss_lo + i, SELECT256(miss, lo, LOAD256(b->miss_lo + i)));
+            STORE256(b->miss_hi + i, SELECT256(miss, hi, LOAD256(b->miss_hi + i)));
+            pausing = _mm256_or_si256(pausing, miss);
+        }
+
+        if (_mm256_movemask_epi8(expired) != 0)
+            STORE256(b->resets + i, _mm256_sub_epi32(LOAD256(b->resets + i), _mm256_andnot_si256(miss, expired)));
+
+        STORE256(b->pos + i, SELECT256(judge, _mm256_and_si256(t, byte), pos));
+        STORE256(b->held + i, SELECT256(judge, _mm256_and_si256(_mm256_srli_epi32(t, 8), byte), held));
+        STORE256(b->prev + i, prev);
+        STORE256(b->score + i, score);
+        STORE256(b->pausing + i, pausing);
+    }
+}
+
+
+#endif
+
+void JudgeBatchStep(JudgeBatch *batch, const uint8_t *inputs, const uint32_t *ts_lo, const uint32_t *ts_hi)
+{
+    switch (batch->kernel)
+    {
+#ifdef SIMD_X86
+        case JUDGE_KERNEL_AVX2:
+            _stepAvx2(batch, inputs, ts_lo, ts_hi);
+            break;
+        case JUDGE_KERNEL_SSE2:
+            _stepSse2(batch, inputs, ts_lo, ts_hi);
+            break;
+#endif
+        default:
+            _stepScalar(batch, inputs, ts_lo, ts_hi);
+            break;
+    }
+}
+
+void JudgeBatchSummary(const JudgeBatch *batch, int lane, ReplaySummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+
+    summary->inputs = batch->inputs[lane];
+    summary->hits = batch->hits[lane];
+    summary->misses = batch->misses[lane];
+    summary->paused = batch->paused[lane];
+    summary->resets = batch->resets[lane];
+    for (int v = 0; v < TIMING_COUNT; v++)
+        summary->timing[v] = batch->timing[v][lane];
+
+    summary->cycles = batch->completions[lane];
+    summary->score = batch->score[lane];
+    summary->highscore = batch->highscore[lane];
+    summary->quit = batch->quit[lane] != 0;
+}
@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
@@ -10,9 +11,449 @@
 
 #include "render.h"
 #include "input.h"
+#include "input_thread.h"
+#include "input_source.h"
+#include "attempt_store.h"
+#include "clock.h"
+#include "flight_recorder.h"
 #include "game.h"
+#include "modes.h"
+#include "recording_index.h"
+#include "replay.h"
+#include "stats_journal.h"
 
-int main()
+// F9 in a game goes back this far, a second at a time
+#define REVIEW_SECONDS 10
+
+static const char *_parseStringArg(int argc, char *argv[], const char *prefix)
+{
+    size_t len = strlen(prefix);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], prefix, len) == 0)
+            return argv[i] + len;
+    }
+
+    return NULL;
+}
+
+static bool _hasFlag(int argc, char *argv[], const char *flag)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], flag) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// Put back together from the session log, the way a review would
+static void _printRewind(KbdSession *session, double seconds)
+{
+    GameState past;
+    if (RewindGame(session, (uint64_t)(seconds * 1e9), &past))
+        printf("%4.1f s back: score %llu, %llu patterns, state %d%s\n",
+            seconds,
+            (unsigned long long)past.score,
+            (unsigned long long)past.completions,
+            past.player_pos,
+            past.in_miss_pause ? ", paused after a miss" : "");
+    else
+        printf("The session log doesn't go back %.1f s\n", seconds);
+}
+
+static void _printReview(KbdSession *session)
+{
+    if (!session->state.run_game || session->state.current_mode->free_practice)
+        return;
+
+    printf("Last %d s of %s\n", REVIEW_SECONDS, session->state.current_mode->mode_name);
+    for (int s = REVIEW_SECONDS; s >= 0; s--)
+        _printRewind(session, s);
+}
+
+// No window, no sleeping. Simulated frames advance as fast as the
+// game logic can run, straight from a scripted source.
+static int _runHeadless(InputSource *source, const char *modeKey, const ModeRegistry *modes, bool sampleFrames, uint64_t phase,
+                        double rewindSeconds)
+{
+    int mode = FindGameMode(modes, modeKey != NULL ? modeKey : "0");
+    if (mode < 0)
+    {
+        printf("No game mode %s\n", modeKey);
+        return 1;
+    }
+
+    static KbdSession session;
+    GameClock clock;
+    InitGameClock(&clock, GAME_CLOCK_SIMULATED, 0);
+    if (!InitGame(&session, &clock, modes))
+        return 1;
+
+    SetFrameSampling(&session, sampleFrames, phase);
+    session.selected_mode = mode;
+    _startGame(&session);
+
+    GameState *gs = &session.state;
+
+    InputRing *ring = GetInputRing();
+    uint64_t frames = 0;
+    bool more = true;
+
+    Uint64 wallStart = SDL_GetTicksNS();
+
+    while (more)
+    {
+        more = source->poll(source, ClockNow(&clock), ring);
+        UpdateFromRing(&session, ring);
+
+        frames++;
+        ClockSleepUntil(&clock, FRAMES_TO_NS(frames));
+    }
+
+    Uint64 wallTime = SDL_GetTicksNS() - wallStart;
+    double seconds = wallTime > 0 ? wallTime / 1e9 : 1e-9;
+
+    printf("%s: %llu frames, score %llu, high score %llu (%.0f frames/s)\n",
+        gs->current_mode->mode_name,
+        (unsigned long long)frames,
+        (unsigned long long)gs->score,
+        (unsigned long long)gs->highscore,
+        frames / seconds);
+
+    if (gs->current_mode->free_practice)
+        PrintRecognizerStats(GetPracticeRecognizer(&session));
+    else
+    {
+        FinishNearMiss(&session.near_miss);
+        PrintNearMissStats(&session.near_miss);
+    }
+
+    if (sampleFrames)
+        printf("Read once a frame at +%.2f ms: %llu of %llu changes dropped\n",
+            session.sampler.phase_ns / 1e6,
+            (unsigned long long)session.sampler.dropped,
+            (unsigned long long)session.sampler.transitions);
+
+    if (rewindSeconds > 0)
+        _printRewind(&session, rewindSeconds);
+
+    DestroyGame(&session);
+    return 0;
+}
+
+// Same recording read by the game at every phase, how much the score
+// depends on where the frames happened to fall
+static void _printPhaseSweep(GameMode *mode, const RecordingReader *reader, int count)
+{
+    PhaseResult *results = malloc(count * sizeof(PhaseResult));
+    if (results == NULL || !ReplayPhaseSweep(mode, reader, results, count))
+    {
+        free(results);
+        return;
+    }
+
+    int clean = 0;
+    int worst = 0;
+
+    printf("  phase ms  dropped     hits   misses      score\n");
+    for (int i = 0; i < count; i++)
+    {
+        const PhaseResult *r = &results[i];
+        printf("  %8.2f %8llu %8llu %8llu %10llu\n",
+            r->phase_ns / 1e6,
+            (unsigned long long)r->dropped,
+            (unsigned long long)r->summary.hits,
+            (unsigned long long)r->summary.misses,
+            (unsigned long long)r->summary.score);
+
+        if (r->dropped == 0)
+            clean++;
+        if (r->summary.misses > results[worst].summary.misses)
+            worst = i;
+    }
+
+    printf("  nothing dropped at %d of %d phases, worst +%.2f ms with %llu misses\n",
+        clean, count, results[worst].phase_ns / 1e6, (unsigned long long)results[worst].summary.misses);
+    free(results);
+}
+
+// The game at one point of a recording, from the keyframe before it
+static void _printSeek(const char *path, const RecordingReader *reader, GameMode *mode, double seconds)
+{
+    RecordingIndex index;
+    bool indexed = LoadRecordingIndex(&index, path, reader, mode);
+
+    Replay replay;
+    uint64_t time = reader->header->start_ns + (uint64_t)(seconds * 1e9);
+    uint64_t judged = SeekRecording(reader, indexed ? &index : NULL, mode, time, &replay);
+
+    const GameState *gs = &replay.state;
+    printf("%s at %.3f s: score %llu, high score %llu, %llu patterns, state %d%s (%llu of %llu inputs judged to get there)\n",
+        path, seconds,
+        (unsigned long long)gs->score,
+        (unsigned long long)gs->highscore,
+        (unsigned long long)gs->completions,
+        gs->player_pos,
+        gs->in_miss_pause ? ", paused after a miss" : "",
+        (unsigned long long)judged,
+        (unsigned long long)replay.summary.inputs);
+
+    FreeRecordingIndex(&index);
+}
+
+// The registry mode a recording was played in, -1 when it's gone or its
+// main path isn't the one recorded any more
+static int _playedMode(const ModeRegistry *modes, const RecordingHeader *header)
+{
+    char name[RECORDING_NAME_SIZE];
+    snprintf(name, sizeof(name), "%.*s", RECORDING_NAME_SIZE - 1, header->mode_name);
+
+    int m = name[0] != '\0' ? FindGameMode(modes, name) : -1;
+    if (m < 0 || modes->modes[m].pattern_size != header->pattern_size)
+        return -1;
+
+    for (int i = 0; i < header->pattern_size; i++)
+    {
+        if (modes->modes[m].pattern[i] != (GameDirection)header->pattern[i])
+            return -1;
+    }
+
+    return m;
+}
+
+// Re-score a recording against the mode it was played in, or any other
+static int _runReplay(const char *path, const char *mode, const ModeRegistry *modes, int sweepPhases, const char *seek)
+{
+    RecordingReader reader;
+    if (!OpenRecordingReader(&reader, path))
+        return 1;
+
+    GameDirection pattern[RECORDING_MAX_PATTERN];
+    PatternDfa dfa;
+    GameMode recorded;
+    bool hasRecorded = GameModeFromRecording(reader.header, &recorded, pattern, &dfa);
+
+    // Alternatives and all when the mode is still there, otherwise the
+    // main path stored in the recording
+    int played = _playedMode(modes, reader.header);
+    GameMode *target = played >= 0 ? &modes->modes[played] : hasRecorded ? &recorded : NULL;
+    if (mode != NULL)
+    {
+        int m = FindGameMode(modes, mode);
+        if (m < 0)
+        {
+            printf("No game mode %s\n", mode);
+            CloseRecordingReader(&reader);
+            return 1;
+        }
+        target = &modes->modes[m];
+    }
+
+    // Nothing to judge against, just count techniques
+    for (int i = 0; target == NULL && i < modes->count; i++)
+    {
+        if (modes->modes[i].free_practice)
+            target = &modes->modes[i];
+    }
+
+    if (target == NULL)
+    {
+        printf("%s has no pattern and there are no techniques to count\n", path);
+        CloseRecordingReader(&reader);
+        return 1;
+    }
+
+    // Keyframes judged with another pattern are skipped, see
+    // LoadRecordingIndex()
+    if (seek != NULL && !target->free_practice)
+    {
+        _printSeek(path, &reader, target, atof(seek));
+        CloseRecordingReader(&reader);
+        return 0;
+    }
+    else if (seek != NULL)
+        printf("--seek needs a mode with a pattern, replaying the whole recording\n");
+
+    if (target->free_practice)
+    {
+        static Recognizer practice;
+        Recognizer *rec = &practice;
+        *rec = *modes->practice;
+        ResetRecognizer(rec);
+
+        Uint64 wallStart = SDL_GetTicksNS();
+        ReplayPracticeRecording(rec, &reader);
+        Uint64 wallTime = SDL_GetTicksNS() - wallStart;
+        double seconds = wallTime > 0 ? wallTime / 1e9 : 1e-9;
+
+        printf("%s as %s: %llu inputs, %llu techniques (%.0f inputs/s)\n",
+            path, target->mode_name,
+            (unsigned long long)rec->inputs,
+            (unsigned long long)RecognizedTotal(rec),
+            rec->inputs / seconds);
+        PrintRecognizerStats(rec);
+
+        CloseRecordingReader(&reader);
+        return 0;
+    }
+
+    Replay replay;
+    InitReplay(&replay, target, 0);
+
+    NearMiss nearMiss;
+    InitNearMiss(&nearMiss, target->pattern, target->pattern_size);
+
+    RecordingIter it;
+    InputEvent ev;
+    BeginRecordingIter(&reader, &it);
+
+    Uint64 wallStart = SDL_GetTicksNS();
+    while (NextRecordedInput(&it, &ev) && !replay.summary.quit)
+    {
+        JudgeResult result = ReplayInput(&replay, &ev);
+        FeedNearMiss(&nearMiss, (GameDirection)ev.direction, result == JUDGE_MISS);
+    }
+    FinishNearMiss(&nearMiss);
+    Uint64 wallTime = SDL_GetTicksNS() - wallStart;
+    double seconds = wallTime > 0 ? wallTime / 1e9 : 1e-9;
+
+    const ReplaySummary *s = &replay.summary;
+    printf("%s as %s: %llu inputs, %llu hits, %llu misses, %llu patterns, score %llu, high score %llu (%.0f inputs/s)\n",
+        path, target->mode_name,
+        (unsigned long long)s->inputs,
+        (unsigned long long)s->hits,
+        (unsigned long long)s->misses,
+        (unsigned long long)s->cycles,
+        (unsigned long long)s->score,
+        (unsigned long long)s->highscore,
+        s->inputs / seconds);
+    PrintNearMissStats(&nearMiss);
+
+    if (sweepPhases > 0)
+        _printPhaseSweep(target, &reader, sweepPhases);
+
+    CloseRecordingReader(&reader);
+    return 0;
+}
+
+// --frame-phase=<ms>, where in the frame the game reads the controller
+static bool _parseFramePhase(int argc, char *argv[], uint64_t *phase)
+{
+    const char *arg = _parseStringArg(argc, argv, "--frame-phase=");
+    if (arg == NULL)
+        return false;
+
+    double ms = atof(arg);
+    if (ms < 0)
+        ms = 0;
+
+    *phase = (uint64_t)(ms * 1e6) % FRAMES_TO_NS(1);
+    return true;
+}
+
+// --phase-sweep or --phase-sweep=<phases>, 0 when not asked for
+static int _parsePhaseSweep(int argc, char *argv[])
+{
+    const char *arg = _parseStringArg(argc, argv, "--phase-sweep=");
+    if (arg != NULL)
+    {
+        int count = atoi(arg);
+        return count > 0 ? count : FRAME_SAMPLER_DEFAULT_PHASES;
+    }
+
+    return _hasFlag(argc, argv, "--phase-sweep") ? FRAME_SAMPLER_DEFAULT_PHASES : 0;
+}
+
+static InputBackend _parseInputBackend(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--input=poll") == 0)
+            return INPUT_BACKEND_POLL;
+        if (strcmp(argv[i], "--input=thread") == 0)
+            return INPUT_BACKEND_THREAD;
+        if (strcmp(argv[i], "--input=events") == 0)
+            return INPUT_BACKEND_EVENTS;
+        if (strcmp(argv[i], "--input=evdev") == 0)
+            return INPUT_BACKEND_EVDEV;
+    }
+
+    return INPUT_BACKEND_THREAD;
+}
+
+static SocdPolicy _parseSocdPolicy(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--socd=", 7) != 0)
+            continue;
+
+        for (int policy = 0; policy < SOCD_POLICY_COUNT; policy++)
+        {
+            if (strcmp(argv[i] + 7, SocdPolicyName(policy)) == 0)
+                return policy;
+        }
+
+        printf("Unknown SOCD policy %s, using neutral\n", argv[i] + 7);
+    }
+
+    return SOCD_NEUTRAL;
+}
+
+static DeviceMergeRule _parseMergeRule(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--merge=", 8) != 0)
+            continue;
+
+        for (int rule = 0; rule < DEVICE_MERGE_COUNT; rule++)
+        {
+            if (strcmp(argv[i] + 8, DeviceMergeRuleName(rule)) == 0)
+                return rule;
+        }
+
+        printf("Unknown device merge rule %s, using any\n", argv[i] + 8);
+    }
+
+    return DEVICE_MERGE_ANY;
+}
+
+static GameClockKind _parseGameClock(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--clock=realtime") == 0)
+            return GAME_CLOCK_REALTIME;
+        if (strcmp(argv[i], "--clock=raw") == 0)
+            return GAME_CLOCK_MONOTONIC_RAW;
+    }
+
+    return GAME_CLOCK_REALTIME;
+}
+
+static StickGateShape _parseStickGate(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--stick=", 8) != 0)
+            continue;
+
+        for (int shape = 0; shape < STICK_GATE_COUNT; shape++)
+        {
+            if (strcmp(argv[i] + 8, StickGateName(shape)) == 0)
+                return shape;
+        }
+
+        printf("Unknown stick gate %s, using octagon\n", argv[i] + 8);
+    }
+
+    return STICK_GATE_OCTAGON;
+}
+
+int main(int argc, char *argv[])
 { 
     bool isRunning = true;
     bool showGameView = false;
@@ -20,9 +461,59 @@ int main()
     // Frame timing
     const Uint64 FRAME_DELAY = 16666666;
     Uint64 frameStart = 0;
-    Uint64 frameTime = 0;    
     Uint64 prevFrame = 0;
+    GameClock clock;
+    ModeRegistry modes;
+    static KbdSession session;
     
+    InputSource source;
+    const char *replayPath = _parseStringArg(argc, argv, "--replay=");
+    const char *flightDump = _parseStringArg(argc, argv, "--read-flight=");
+
+    if (flightDump != NULL)
+        return PrintFlightDump(flightDump) ? 0 : 1;
+
+    if (!LoadGameModes(&modes, _parseStringArg(argc, argv, "--modes=")))
+        return 1;
+
+    if (replayPath != NULL)
+    {
+        int result = _runReplay(replayPath, _parseStringArg(argc, argv, "--mode="), &modes, _parsePhaseSweep(argc, argv),
+            _parseStringArg(argc, argv, "--seek="));
+        DestroyModeRegistry(&modes);
+        return result;
+    }
+
+    // Anything that plays a game leaves a dump if it goes down
+    InitFlightRecorder(_parseStringArg(argc, argv, "--flight="));
+
+    const char *scriptPath = _parseStringArg(argc, argv, "--script=");
+
+    uint64_t framePhase = 0;
+    bool sampleFrames = _parseFramePhase(argc, argv, &framePhase);
+
+    if (_hasFlag(argc, argv, "--headless"))
+    {
+        const char *mode = _parseStringArg(argc, argv, "--mode=");
+
+        if (scriptPath == NULL)
+        {
+            printf("--headless needs a --script=<file> to play\n");
+            return 1;
+        }
+
+        if (!OpenScriptSource(&source, scriptPath))
+            return 1;
+
+        const char *rewind = _parseStringArg(argc, argv, "--rewind=");
+        int result = _runHeadless(&source, mode, &modes, sampleFrames, framePhase, rewind != NULL ? atof(rewind) : 0);
+        CloseInputSource(&source);
+        DestroyModeRegistry(&modes);
+        if (result == 0)
+            CloseFlightRecorder();
+        return result;
+    }
+
     // SDL Window Management
     SDL_Event ev;    
     SDL_Window *window = NULL;
@@ -37,11 +528,70 @@ int main()
     
     TTF_Init();
 
-    if(InitController())
+    bool hasPad = InitController();
+    if (hasPad)
         printf("Controller found!\n");
     else
-        printf("No compatible controller detected. Using keyboard inputs (WASD)\n");
+        printf("No compatible controller detected. Using keyboard inputs (WASD), plug one in any time\n");
     
+    // Input is stamped on the same clock the frame loop runs on
+    InitGameClock(&clock, _parseGameClock(argc, argv), SDL_GetTicksNS());
+    SetInputClock(&clock);
+
+    SocdPolicy socd_policy = _parseSocdPolicy(argc, argv);
+    SetSocdPolicy(socd_policy);
+    SetDeviceMergeRule(_parseMergeRule(argc, argv));
+    SetStickGate(_parseStickGate(argc, argv), STICK_DEFAULT_DEADZONE);
+
+    const char *recordDir = _parseStringArg(argc, argv, "--record=");
+
+    if (!InitGame(&session, &clock, &modes))
+        return 1;
+
+    StatsJournal *stats = OpenStatsJournal(_parseStringArg(argc, argv, "--stats="));
+    SetStatsJournal(&session, stats);
+
+    AttemptWriter *attempts = OpenAttemptWriter(_parseStringArg(argc, argv, "--attempts="), &modes);
+    if (!SetAttemptStore(&session, attempts))
+        return 1;
+
+    if (scriptPath != NULL)
+    {
+        if (!OpenScriptSource(&source, scriptPath))
+            return 1;
+
+        SetInputBackend(INPUT_BACKEND_SCRIPT);
+        printf("Playing input script %s\n", scriptPath);
+    }
+    // Sample input off the render cadence, fall back to per-frame polling
+    else if (OpenInputSource(&source, _parseInputBackend(argc, argv), socd_policy))
+    {
+        printf("Using %s input\n", source.name);
+        if (GetInputBackend() == INPUT_BACKEND_THREAD && !hasPad)
+            printf("The keyboard is only read once a frame on the thread backend, --input=events keeps each key press's own time\n");
+    }
+    else
+        OpenInputSource(&source, INPUT_BACKEND_POLL, socd_policy);
+
+    if (sampleFrames)
+    {
+        SetFrameSampling(&session, true, framePhase);
+        printf("Judging what the game reads once a frame, at +%.2f ms\n", framePhase / 1e6);
+    }
+
+    if (recordDir != NULL)
+    {
+        RecordingClock recordClock = RECORDING_CLOCK_SDL;
+        if (GetInputBackend() == INPUT_BACKEND_SCRIPT)
+            recordClock = RECORDING_CLOCK_SIMULATED;
+        else if (GetInputBackend() == INPUT_BACKEND_EVDEV)
+            recordClock = RECORDING_CLOCK_EVDEV;
+        else if (clock.kind == GAME_CLOCK_MONOTONIC_RAW)
+            recordClock = RECORDING_CLOCK_MONOTONIC_RAW;
+
+        SetRecording(&session, recordDir, recordClock);
+    }
+
     SDL_CreateWindowAndRenderer("KBD Trainer", INITIAL_VIEW_WIDTH, INITIAL_VIEW_HEIGHT, SDL_WINDOW_ALWAYS_ON_TOP | SDL_WINDOW_BORDERLESS, &window, &renderer);
     if (window == NULL)
     {
@@ -53,12 +603,10 @@ int main()
     // Set window opacity for overlay effect (0.0 = fully transparent, 1.0 = fully opaque)
     SDL_SetWindowOpacity(window, 0.9f);
     
-    InitGame();
-    
     if (InitTextures(renderer))
         printf("Texture load success!\n");
     
-    if (!InitMenuTextures(renderer))
+    if (!InitMenuTextures(renderer, &session))
     {
         printf("Error initializing mode select: %s", SDL_GetError());
         return 1;
@@ -70,39 +618,57 @@ int main()
     while (isRunning)
     {
         prevFrame = frameStart;
-        frameStart = SDL_GetTicksNS();
+        frameStart = ClockNow(&clock);
         while (SDL_PollEvent(&ev) != 0)
         {
             if (ev.type == SDL_EVENT_QUIT)
                 isRunning = false;
+            else
+            {
+                if (ev.type == SDL_EVENT_KEY_DOWN && ev.key.scancode == SDL_SCANCODE_F12 && !ev.key.repeat)
+                    DumpFlightRecorder();
+                if (ev.type == SDL_EVENT_KEY_DOWN && ev.key.scancode == SDL_SCANCODE_F9 && !ev.key.repeat)
+                    _printReview(&session);
+                HandleInputEvent(&ev, GetInputRing());
+            }
         }
 
         // Switch to game view or menu view
-        if (showGameView != gamestate.run_game)
+        if (showGameView != session.state.run_game)
         {
-            showGameView = gamestate.run_game;
-            if(gamestate.run_game)
+            showGameView = session.state.run_game;
+            if(session.state.run_game)
                 DestroyMenuTextures();
             else
-                InitMenuTextures(renderer);
+                InitMenuTextures(renderer, &session);
         }
 
-        Update( PollController() );
-        Render(renderer);
+        source.poll(&source, frameStart, GetInputRing());
+        Uint64 polled = ClockNow(&clock);
+        UpdateFromRing(&session, GetInputRing() );
+        Uint64 updated = ClockNow(&clock);
+        Render(renderer, &session);
 
-        // How long it took to execute the functions
-        frameTime = SDL_GetTicksNS() - frameStart;
+        if (prevFrame != 0)
+            RecordFlightPhase(FLIGHT_PHASE_FRAME, prevFrame, frameStart);
+        RecordFlightPhase(FLIGHT_PHASE_POLL, frameStart, polled);
+        RecordFlightPhase(FLIGHT_PHASE_UPDATE, polled, updated);
+        RecordFlightPhase(FLIGHT_PHASE_RENDER, updated, ClockNow(&clock));
 
         //Wait out the remainder
-        if (FRAME_DELAY > frameTime) 
-            SDL_DelayPrecise(FRAME_DELAY - frameTime);
+        ClockSleepUntil(&clock, frameStart + FRAME_DELAY);
     }
     
-    DestroyGame();
+    CloseInputSource(&source);
+    DestroyGame(&session);
+    CloseStatsJournal(stats);
+    CloseAttemptWriter(attempts);
+    DestroyModeRegistry(&modes);
 
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
 
+    CloseFlightRecorder();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,381 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "modes.h"
+#include "notation.h"
+#include "pattern.h"
+
+typedef enum {
+    SECTION_NONE = 0,
+    SECTION_MODES,
+    SECTION_MIRRORED_MODES,
+    SECTION_TECHNIQUES,
+    SECTION_MIRRORED_TECHNIQUES
+} ModeSection;
+
+static const char *_sectionNames[] = {
+    [SECTION_MODES]               = "modes",
+    [SECTION_MIRRORED_MODES]      = "mirrored modes",
+    [SECTION_TECHNIQUES]          = "techniques",
+    [SECTION_MIRRORED_TECHNIQUES] = "mirrored techniques"
+};
+
+typedef struct {
+    const char *name;
+    size_t name_len;
+    const char *value;
+    size_t value_len;
+} ModeLine;
+
+// Bump allocation, every block 8 byte aligned
+static void *_alloc(ModeRegistry *reg, size_t size)
+{
+    size_t start = (reg->arena_used + 7) & ~(size_t)7;
+    if (start + size > reg->arena_size)
+        return NULL;
+
+    reg->arena_used = start + size;
+    return reg->arena + start;
+}
+
+static char *_allocString(ModeRegistry *reg, const char *prefix, const char *text, size_t len)
+{
+    size_t prefix_len = strlen(prefix);
+    char *out = _alloc(reg, prefix_len + len + 1);
+    if (out == NULL)
+        return NULL;
+
+    memcpy(out, prefix, prefix_len);
+    memcpy(out + prefix_len, text, len);
+    out[prefix_len + len] = '\0';
+    return out;
+}
+
+static void _trim(const char **text, size_t *len)
+{
+    while (*len > 0 && isspace((unsigned char)**text))
+    {
+        (*text)++;
+        (*len)--;
+    }
+
+    while (*len > 0 && isspace((unsigned char)(*text)[*len - 1]))
+        (*len)--;
+}
+
+// Next "name = pattern" line, skipping blanks, comments and section
+// headers. Problems are only printed when origin is set.
+static bool _nextLine(const char **p, const char *end, int *line_no, ModeLine *out, ModeSection *section, const char *origin)
+{
+    while (*p < end)
+    {
+        const char *line = *p;
+        while (*p < end && **p != '\n')
+            (*p)++;
+
+        size_t len = (size_t)(*p - line);
+        if (*p < end)
+            (*p)++;
+        (*line_no)++;
+
+        _trim(&line, &len);
+        if (len == 0 || line[0] == '#')
+            continue;
+
+        if (line[0] == '[' && line[len - 1] == ']')
+        {
+            *section = SECTION_NONE;
+            for (int s = SECTION_MODES; s <= SECTION_MIRRORED_TECHNIQUES; s++)
+            {
+                if (strlen(_sectionNames[s]) == len - 2 && strncmp(line + 1, _sectionNames[s], len - 2) == 0)
+                    *section = (ModeSection)s;
+            }
+
+            if (*section == SECTION_NONE && origin != NULL)
+                printf("%s:%d: unknown section %.*s\n", origin, *line_no, (int)len, line);
+            continue;
+        }
+
+        const char *eq = memchr(line, '=', len);
+        if (eq == NULL || *section == SECTION_NONE)
+        {
+            if (origin != NULL)
+                printf("%s:%d: expected \"name = pattern\" under a section\n", origin, *line_no);
+            continue;
+        }
+
+        out->name = line;
+        out->name_len = (size_t)(eq - line);
+        out->value = eq + 1;
+        out->value_len = len - out->name_len - 1;
+        _trim(&out->name, &out->name_len);
+        _trim(&out->value, &out->value_len);
+
+        if (out->name_len == 0 || out->value_len == 0)
+        {
+            if (origin != NULL)
+                printf("%s:%d: expected \"name = pattern\"\n", origin, *line_no);
+            continue;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+// Technique text with every direction swapped, numpad runs included
+static char *_mirrorTechnique(ModeRegistry *reg, const char *text, size_t len)
+{
+    char *out = _alloc(reg, len * 3 + 1);
+    if (out == NULL)
+        return NULL;
+
+    size_t n = 0;
+    size_t i = 0;
+
+    while (i < len)
+    {
+        if (!isalnum((unsigned char)text[i]))
+        {
+            i++;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < len && isalnum((unsigned char)text[i]))
+            i++;
+
+        bool numpad = isdigit((unsigned char)text[start]);
+        size_t count = numpad ? i - start : 1;
+
+        for (size_t k = 0; k < count; k++)
+        {
+            GameDirection dir;
+            bool ok = numpad ? ParseDirection(text + start + k, 1, &dir) : ParseDirection(text + start, i - start, &dir);
+
+            // Let AddTechnique() report it
+            const char *name = ok ? DirectionName(MirrorDirection(dir)) : "?";
+            size_t name_len = strlen(name);
+
+            memcpy(out + n, name, name_len);
+            n += name_len;
+            out[n++] = ' ';
+        }
+    }
+
+    out[n] = '\0';
+    return out;
+}
+
+static bool _addMode(ModeRegistry *reg, const char *name, const char *source, const PatternDfa *dfa)
+{
+    GameMode *mode = &reg->modes[reg->count];
+    PatternDfa *copy = _alloc(reg, sizeof(PatternDfa));
+    GameDirection *path = _alloc(reg, PATTERN_MAX_STATES * sizeof(GameDirection));
+    if (copy == NULL || path == NULL)
+        return false;
+
+    *copy = *dfa;
+    mode->mode_name = name;
+    mode->source = source;
+    mode->dfa = copy;
+    mode->pattern = path;
+    mode->pattern_size = PatternMainPath(copy, path, PATTERN_MAX_STATES);
+    mode->free_practice = false;
+
+    reg->count++;
+    return true;
+}
+
+bool LoadModeRegistryFromMemory(ModeRegistry *reg, const char *text, size_t len, const char *origin)
+{
+    memset(reg, 0, sizeof(*reg));
+
+    // Size everything first so the arena is allocated once
+    const char *p = text;
+    const char *end = text + len;
+    int line_no = 0;
+    ModeSection section = SECTION_NONE;
+    ModeLine line;
+
+    int mode_count = 0;
+    int technique_count = 0;
+    size_t bytes = 0;
+
+    while (_nextLine(&p, end, &line_no, &line, &section, NULL))
+    {
+        bool mirrored = section == SECTION_MIRRORED_MODES || section == SECTION_MIRRORED_TECHNIQUES;
+        int copies = mirrored ? 2 : 1;
+
+        if (section == SECTION_MODES || section == SECTION_MIRRORED_MODES)
+        {
+            mode_count += copies;
+            bytes += copies * (sizeof(PatternDfa) + PATTERN_MAX_STATES * sizeof(GameDirection) + line.name_len + 8 + 24);
+            bytes += line.value_len + 8;
+        }
+        else
+        {
+            technique_count += copies;
+            bytes += copies * (line.name_len + 8 + 8) + line.value_len * 4 + 16;
+        }
+    }
+
+    // Room for Free Practice
+    int capacity = mode_count + 1;
+    bytes += capacity * sizeof(GameMode) + sizeof(Recognizer) + 32;
+
+    reg->arena = calloc(1, bytes);
+    if (reg->arena == NULL)
+        return false;
+    reg->arena_size = bytes;
+
+    reg->modes = _alloc(reg, capacity * sizeof(GameMode));
+    if (technique_count > 0)
+    {
+        reg->practice = _alloc(reg, sizeof(Recognizer));
+        InitRecognizer(reg->practice);
+    }
+
+    // Now for real
+    p = text;
+    line_no = 0;
+    section = SECTION_NONE;
+
+    while (_nextLine(&p, end, &line_no, &line, &section, origin))
+    {
+        bool mirrored = section == SECTION_MIRRORED_MODES || section == SECTION_MIRRORED_TECHNIQUES;
+        const char *value = _allocString(reg, "", line.value, line.value_len);
+
+        if (section == SECTION_MODES || section == SECTION_MIRRORED_MODES)
+        {
+            PatternDfa dfa;
+            if (!CompilePattern(value, &dfa))
+            {
+                printf("%s:%d: mode %.*s skipped\n", origin, line_no, (int)line.name_len, line.name);
+                continue;
+            }
+
+            if (!mirrored)
+            {
+                _addMode(reg, _allocString(reg, "", line.name, line.name_len), value, &dfa);
+                continue;
+            }
+
+            // The P2 copy keeps the P1 source for reference
+            PatternDfa flipped;
+            MirrorPattern(&dfa, &flipped);
+            _addMode(reg, _allocString(reg, "P1 ", line.name, line.name_len), value, &dfa);
+            _addMode(reg, _allocString(reg, "P2 ", line.name, line.name_len), value, &flipped);
+        }
+        else if (!mirrored)
+            AddTechnique(reg->practice, _allocString(reg, "", line.name, line.name_len), value);
+        else
+        {
+            AddTechnique(reg->practice, _allocString(reg, "P1 ", line.name, line.name_len), value);
+            AddTechnique(reg->practice, _allocString(reg, "P2 ", line.name, line.name_len),
+                _mirrorTechnique(reg, line.value, line.value_len));
+        }
+    }
+
+    if (reg->practice != NULL && reg->practice->technique_count > 0)
+    {
+        BuildRecognizer(reg->practice);
+
+        GameMode *practice = &reg->modes[reg->count++];
+        memset(practice, 0, sizeof(*practice));
+        practice->mode_name = "Free Practice";
+        practice->free_practice = true;
+    }
+    else
+        reg->practice = NULL;
+
+    if (reg->count == 0)
+    {
+        printf("%s: no usable modes\n", origin);
+        DestroyModeRegistry(reg);
+        return false;
+    }
+
+    return true;
+}
+
+bool LoadModeRegistry(ModeRegistry *reg, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        printf("Error opening modes %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (size < 0)
+    {
+        printf("Error reading modes %s\n", path);
+        fclose(file);
+        return false;
+    }
+
+    char *text = malloc(size > 0 ? size : 1);
+    bool ok = text != NULL && fread(text, 1, size, file) == (size_t)size;
+    fclose(file);
+
+    if (ok)
+        ok = LoadModeRegistryFromMemory(reg, text, size, path);
+
+    free(text);
+    return ok;
+}
+
+// Used when the modes file is missing or has nothing usable in it
+static const char *_builtinModes =
+    "[mirrored modes]\n"
+    "KBD = (b n b db):1-3\n"
+    "WD = (f n d df f n):1-3\n"
+    "[mirrored techniques]\n"
+    "KBD = b n b db\n"
+    "Wavedash = f n d df\n";
+
+bool LoadGameModes(ModeRegistry *reg, const char *path)
+{
+    if (path == NULL)
+        path = MODES_DEFAULT_PATH;
+
+    if (!LoadModeRegistry(reg, path))
+    {
+        printf("Using the built in modes\n");
+        if (!LoadModeRegistryFromMemory(reg, _builtinModes, strlen(_builtinModes), "built in modes"))
+            return false;
+    }
+
+    printf("Gamemodes Initialized: %d.\n", reg->count);
+    return true;
+}
+
+void DestroyModeRegistry(ModeRegistry *reg)
+{
+    free(reg->arena);
+    memset(reg, 0, sizeof(*reg));
+}
+
+int FindGameMode(const ModeRegistry *reg, const char *key)
+{
+    char *end;
+    long index = strtol(key, &end, 10);
+    if (*key != '\0' && *end == '\0')
+        return index >= 0 && index < reg->count ? (int)index : -1;
+
+    for (int i = 0; i < reg->count; i++)
+    {
+        if (strcmp(reg->modes[i].mode_name, key) == 0)
+            return i;
+    }
+
+    return -1;
+}
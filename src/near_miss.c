@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "near_miss.h"
+
+static const char *_kindNames[MISS_KIND_COUNT] = {
+    [MISS_UNCLEAR]         = "unclear",
+    [MISS_SKIPPED_NEUTRAL] = "skipped neutral",
+    [MISS_EXTRA_INPUT]     = "extra input",
+    [MISS_WRONG_DIAGONAL]  = "wrong diagonal",
+    [MISS_SWAPPED_ORDER]   = "swapped order"
+};
+
+// When two kinds explain as much, the more specific one wins
+static const MissKind _priority[] = {
+    MISS_SKIPPED_NEUTRAL,
+    MISS_SWAPPED_ORDER,
+    MISS_WRONG_DIAGONAL,
+    MISS_EXTRA_INPUT
+};
+
+#define PRIORITY_COUNT (int)(sizeof(_priority) / sizeof(*_priority))
+
+const char *MissKindName(MissKind kind)
+{
+    return kind < MISS_KIND_COUNT ? _kindNames[kind] : "?";
+}
+
+// Up, forward, down and back bits of each direction
+static const uint8_t _components[PATTERN_COLUMNS] = {
+    [UP] = 1, [UP_FORWARD] = 1 | 2, [FORWARD] = 2, [DOWN_FORWARD] = 4 | 2,
+    [DOWN] = 4, [DOWN_BACK] = 4 | 8, [BACK] = 8, [UP_BACK] = 1 | 8
+};
+
+// A diagonal and its side, or two diagonals on the same side
+static bool _nearDiagonal(GameDirection a, GameDirection b)
+{
+    if (a == b || a >= PATTERN_COLUMNS || b >= PATTERN_COLUMNS)
+        return false;
+
+    uint8_t ca = _components[a];
+    uint8_t cb = _components[b];
+    bool diagonal = (ca & (ca - 1)) != 0 || (cb & (cb - 1)) != 0;
+    return (ca & cb) != 0 && diagonal;
+}
+
+static int _highestBit(uint64_t v)
+{
+    int bit = -1;
+    while (v != 0)
+    {
+        v >>= 1;
+        bit++;
+    }
+
+    return bit;
+}
+
+void InitNearMiss(NearMiss *nm, const GameDirection *pattern, int length)
+{
+    memset(nm, 0, sizeof(*nm));
+    nm->prev = NEUTRAL;
+
+    if (length > NEAR_MISS_MAX_STEPS)
+        length = NEAR_MISS_MAX_STEPS;
+    nm->length = length;
+
+    for (int i = 0; i < length; i++)
+    {
+        uint64_t bit = 1ULL << i;
+        GameDirection dir = pattern[i];
+
+        if (dir < PATTERN_COLUMNS)
+        {
+            nm->at[dir] |= bit;
+            if (i > 0)
+                nm->next_at[dir] |= bit >> 1;
+        }
+
+        for (int d = UP; d <= UP_BACK; d++)
+        {
+            if (_nearDiagonal((GameDirection)d, dir))
+                nm->near[d] |= bit;
+        }
+
+        // b db rolled straight into db
+        if (i + 1 < length && _nearDiagonal(dir, pattern[i + 1]))
+            nm->rolled |= bit;
+
+        // b n b without the n never leaves b, the second b goes with it
+        if (dir == NEUTRAL)
+        {
+            nm->neutral |= bit;
+            if (i > 0 && i + 1 < length && pattern[i - 1] == pattern[i + 1])
+                nm->merged |= bit;
+        }
+    }
+
+    if (length > 0)
+        nm->end = 1ULL << (length - 1);
+}
+
+static void _settle(NearMiss *nm, MissKind kind, int errors)
+{
+    nm->pending = false;
+    nm->diagnosed = true;
+    nm->last.kind = kind;
+    nm->last.step = nm->step;
+    nm->last.errors = errors;
+    nm->counts[kind]++;
+}
+
+// Nothing finished the technique, the kind that got furthest past the
+// miss is the best guess
+static void _settleByReach(NearMiss *nm)
+{
+    MissKind best = MISS_UNCLEAR;
+    int reach = nm->step;
+
+    // Fewest edits that finished the technique, or still keep up
+    int errors = nm->explained;
+    for (int j = NEAR_MISS_MAX_ERRORS; j >= 0; j--)
+    {
+        if (nm->errors[j] != 0 && j < errors)
+            errors = j;
+    }
+
+    for (int p = 0; p < PRIORITY_COUNT; p++)
+    {
+        if (nm->reach[_priority[p]] > reach)
+        {
+            best = _priority[p];
+            reach = nm->reach[best];
+        }
+    }
+
+    _settle(nm, best, errors);
+}
+
+// Wu-Manber: level j from level j - 1 before and after this input, for
+// an extra input, a wrong one and a skipped step
+static void _matchErrors(NearMiss *nm, uint64_t b)
+{
+    uint64_t mask = nm->end | (nm->end - 1);
+    uint64_t below = nm->errors[0];
+
+    nm->errors[0] = (nm->errors[0] << 1) & b;
+    for (int j = 1; j <= NEAR_MISS_MAX_ERRORS; j++)
+    {
+        uint64_t was = nm->errors[j];
+        nm->errors[j] = (((was << 1) & b) | below | (below << 1) | (nm->errors[j - 1] << 1)) & mask;
+        below = was;
+    }
+
+    for (int j = 0; j < nm->explained; j++)
+    {
+        if (nm->errors[j] & nm->end)
+            nm->explained = j;
+    }
+}
+
+// The attempt so far is whatever matched exactly before the missed input
+static void _seed(NearMiss *nm, uint64_t exact, uint64_t open, uint64_t b, GameDirection dir)
+{
+    uint64_t mask = nm->end | (nm->end - 1);
+
+    nm->pending = true;
+    nm->diagnosed = false;
+    nm->step = _highestBit(exact) + 1;
+    nm->waited = 0;
+    nm->explained = NEAR_MISS_MAX_ERRORS + 1;
+
+    // Up to j steps of the pattern may be left out before the miss
+    nm->errors[0] = exact;
+    for (int j = 1; j <= NEAR_MISS_MAX_ERRORS; j++)
+        nm->errors[j] = (nm->errors[j - 1] | (nm->errors[j - 1] << 1)) & mask;
+    _matchErrors(nm, b);
+
+    uint64_t skipped = ((open & nm->neutral) << 1) | ((open & nm->merged) << 2);
+    nm->kinds[MISS_UNCLEAR] = 0;
+    nm->kinds[MISS_SKIPPED_NEUTRAL] = skipped & b;
+    nm->kinds[MISS_EXTRA_INPUT] = exact;
+    nm->kinds[MISS_WRONG_DIAGONAL] = (dir < PATTERN_COLUMNS ? open & nm->near[dir] : 0) | (((open & nm->rolled) << 1) & b);
+    nm->kinds[MISS_SWAPPED_ORDER] = 0;
+    nm->swap = dir < PATTERN_COLUMNS ? open & nm->next_at[dir] : 0;
+
+    for (int k = 0; k < MISS_KIND_COUNT; k++)
+        nm->reach[k] = _highestBit(nm->kinds[k]);
+}
+
+// One more input after the miss, seeded vectors only carry on
+static void _advance(NearMiss *nm, uint64_t b)
+{
+    _matchErrors(nm, b);
+
+    uint64_t extra = nm->kinds[MISS_EXTRA_INPUT];
+    for (int k = MISS_SKIPPED_NEUTRAL; k < MISS_KIND_COUNT; k++)
+        nm->kinds[k] = (nm->kinds[k] << 1) & b;
+
+    // Straight after the miss: the stray input may go back to the step
+    // it left, or the step it jumped may follow it
+    if (nm->waited == 0)
+    {
+        nm->kinds[MISS_EXTRA_INPUT] |= extra & b;
+        nm->kinds[MISS_SWAPPED_ORDER] |= (nm->swap & b) << 1;
+    }
+
+    for (int k = 0; k < MISS_KIND_COUNT; k++)
+    {
+        int bit = _highestBit(nm->kinds[k]);
+        if (bit > nm->reach[k])
+            nm->reach[k] = bit;
+    }
+
+    nm->waited++;
+}
+
+// True once something explains the whole technique, or it's clear nothing will
+static bool _check(NearMiss *nm)
+{
+    for (int p = 0; p < PRIORITY_COUNT; p++)
+    {
+        if (nm->kinds[_priority[p]] & nm->end)
+        {
+            _settle(nm, _priority[p], 1);
+            return true;
+        }
+    }
+
+    // A swap only shows with the input after the miss
+    bool alive = nm->waited == 0 && nm->swap != 0;
+    for (int k = MISS_SKIPPED_NEUTRAL; k < MISS_KIND_COUNT; k++)
+        alive |= nm->kinds[k] != 0;
+
+    // Or enough inputs to finish from where it went wrong, with every
+    // edit allowed spent on extra ones
+    if (!alive || nm->waited > nm->length - nm->step + NEAR_MISS_MAX_ERRORS)
+    {
+        _settleByReach(nm);
+        return true;
+    }
+
+    return false;
+}
+
+bool FeedNearMiss(NearMiss *nm, GameDirection dir, bool missed)
+{
+    if (nm->length == 0 || dir == nm->prev)
+        return false;
+    nm->prev = dir;
+
+    uint64_t b = dir < PATTERN_COLUMNS ? nm->at[dir] : 0;
+    uint64_t exact = nm->exact;
+    uint64_t open = (exact << 1) | 1;
+    bool settled = false;
+
+    nm->exact = open & b;
+
+    // A new miss settles the one before it
+    if (missed)
+    {
+        if (nm->pending)
+        {
+            _settleByReach(nm);
+            settled = true;
+        }
+
+        _seed(nm, exact, open, b, dir);
+        return _check(nm) || settled;
+    }
+
+    if (!nm->pending)
+        return false;
+
+    _advance(nm, b);
+    return _check(nm);
+}
+
+bool FinishNearMiss(NearMiss *nm)
+{
+    if (!nm->pending)
+        return false;
+
+    _settleByReach(nm);
+    return true;
+}
+
+void PrintNearMissStats(const NearMiss *nm)
+{
+    for (int k = MISS_SKIPPED_NEUTRAL; k < MISS_KIND_COUNT; k++)
+        printf("  %-16s %8llu\n", _kindNames[k], (unsigned long long)nm->counts[k]);
+    printf("  %-16s %8llu\n", _kindNames[MISS_UNCLEAR], (unsigned long long)nm->counts[MISS_UNCLEAR]);
+}
@@ -0,0 +1,97 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "input.h"
+#include "notation.h"
+
+const char *direction_names[UNKNOWN + 1] = {
+    [NEUTRAL]      = "n",
+    [UP]           = "u",
+    [UP_FORWARD]   = "uf",
+    [FORWARD]      = "f",
+    [DOWN_FORWARD] = "df",
+    [DOWN]         = "d",
+    [DOWN_BACK]    = "db",
+    [BACK]         = "b",
+    [UP_BACK]      = "ub",
+    [UNKNOWN]      = "?"
+};
+
+// Numpad notation, index is the digit
+static const GameDirection _numpadDirections[10] = {
+    [0] = UNKNOWN,
+    [1] = DOWN_BACK,
+    [2] = DOWN,
+    [3] = DOWN_FORWARD,
+    [4] = BACK,
+    [5] = NEUTRAL,
+    [6] = FORWARD,
+    [7] = UP_BACK,
+    [8] = UP,
+    [9] = UP_FORWARD
+};
+
+bool ParseDirection(const char *token, size_t len, GameDirection *out)
+{
+    if (len == 1 && token[0] >= '1' && token[0] <= '9')
+    {
+        *out = _numpadDirections[token[0] - '0'];
+        return true;
+    }
+
+    for (int dir = NEUTRAL; dir < UNKNOWN; dir++)
+    {
+        const char *name = direction_names[dir];
+        if (strlen(name) != len)
+            continue;
+
+        bool match = true;
+        for (size_t i = 0; i < len; i++)
+        {
+            if (tolower((unsigned char)token[i]) != name[i])
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if (match)
+        {
+            *out = (GameDirection)dir;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static const GameDirection _mirroredDirections[DISCONNECTED + 1] = {
+    [NEUTRAL]      = NEUTRAL,
+    [UP]           = UP,
+    [UP_FORWARD]   = UP_BACK,
+    [FORWARD]      = BACK,
+    [DOWN_FORWARD] = DOWN_BACK,
+    [DOWN]         = DOWN,
+    [DOWN_BACK]    = DOWN_FORWARD,
+    [BACK]         = FORWARD,
+    [UP_BACK]      = UP_FORWARD,
+    [UNKNOWN]      = UNKNOWN,
+    [DISCONNECTED] = DISCONNECTED
+};
+
+GameDirection MirrorDirection(GameDirection dir)
+{
+    if (dir < NEUTRAL || dir > DISCONNECTED)
+        return UNKNOWN;
+
+    return _mirroredDirections[dir];
+}
+
+const char *DirectionName(GameDirection dir)
+{
+    if (dir < NEUTRAL || dir > UNKNOWN)
+        return direction_names[UNKNOWN];
+
+    return direction_names[dir];
+}
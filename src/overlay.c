@@ -1,28 +1,41 @@
 #include "overlay.h"
 #include "render.h"
 #include "game.h"
+#include "modes.h"
 #include <stdio.h>
 #include <imgui.h>
 
 OverlayState g_overlay = {0};
 
+static ModeRegistry overlay_modes;
+static KbdSession overlay_session;
+static GameClock overlay_clock;
+
 bool InitializeOverlay(HWND target_window) {
     g_overlay.target_window = target_window;
     g_overlay.show_overlay = true;
     g_overlay.is_active = true;
     
     // Initialize the game state for overlay mode
-    InitGame();
+    InitGameClock(&overlay_clock, GAME_CLOCK_REALTIME, 0);
+    if (!LoadGameModes(&overlay_modes, NULL) || !InitGame(&overlay_session, &overlay_clock, &overlay_modes))
+        return false;
     
     return InitializeDirectXHook();
 }
 
 void ShutdownOverlay() {
     ShutdownDirectXHook();
-    DestroyGame();
+    DestroyGame(&overlay_session);
+    DestroyModeRegistry(&overlay_modes);
     g_overlay.is_active = false;
 }
 
+static const char* _overlayModeName(void* data, int index) {
+    (void)data;
+    return overlay_session.modes[index].mode_name;
+}
+
 void RenderOverlay() {
     if (!g_overlay.show_overlay || !g_overlay.is_active) {
         return;
@@ -49,26 +62,26 @@ void RenderOverlay() {
         ImGui::Separator();
         
         // Display current training mode
-        if (gamestate.current_mode) {
-            ImGui::Text("Mode: %s", gamestate.current_mode->mode_name);
+        if (overlay_session.state.current_mode) {
+            ImGui::Text("Mode: %s", overlay_session.state.current_mode->mode_name);
             
             // Display input pattern
             ImGui::Text("Pattern:");
             ImGui::SameLine();
             
             const char* input_names[] = {"N", "U", "UF", "F", "DF", "D", "DB", "B", "UB"};
-            for (int i = 0; i < gamestate.current_mode->pattern_size; i++) {
+            for (int i = 0; i < overlay_session.state.current_mode->pattern_size; i++) {
                 if (i > 0) ImGui::SameLine();
                 
-                int input = gamestate.current_mode->pattern[i];
-                if (i == gamestate.player_pos % gamestate.current_mode->pattern_size) {
+                int input = overlay_session.state.current_mode->pattern[i];
+                if (i == overlay_session.state.player_pos % overlay_session.state.current_mode->pattern_size) {
                     // Highlight current input
                     ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "%s", input_names[input]);
                 } else {
                     ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "%s", input_names[input]);
                 }
                 
-                if (i < gamestate.current_mode->pattern_size - 1) {
+                if (i < overlay_session.state.current_mode->pattern_size - 1) {
                     ImGui::SameLine();
                     ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "→");
                 }
@@ -80,12 +93,12 @@ void RenderOverlay() {
         ImGui::Separator();
         
         // Display score
-        ImGui::Text("Score: %lld", gamestate.score);
-        ImGui::Text("High Score: %lld", gamestate.highscore);
+        ImGui::Text("Score: %lld", overlay_session.state.score);
+        ImGui::Text("High Score: %lld", overlay_session.state.highscore);
         
         // Display current input requirement
-        if (gamestate.current_mode && gamestate.current_mode->pattern) {
-            int next_input = gamestate.current_mode->pattern[gamestate.player_pos % gamestate.current_mode->pattern_size];
+        if (overlay_session.state.current_mode && overlay_session.state.current_mode->pattern) {
+            int next_input = overlay_session.state.current_mode->pattern[overlay_session.state.player_pos % overlay_session.state.current_mode->pattern_size];
             const char* input_names[] = {"N", "U", "UF", "F", "DF", "D", "DB", "B", "UB"};
             
             ImGui::Separator();
@@ -95,10 +108,10 @@ void RenderOverlay() {
         }
         
         // Display last result with animation
-        if (gamestate.last_input_acc == SUCCESS) {
+        if (overlay_session.state.last_input_acc == SUCCESS) {
             ImGui::Separator();
             ImGui::TextColored(ImVec4(0.2f, 1.0f, 0.2f, 1.0f), "✓ GREAT!");
-        } else if (gamestate.last_input_acc == FAIL) {
+        } else if (overlay_session.state.last_input_acc == FAIL) {
             ImGui::Separator();
             ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "✗ MISS");
         }
@@ -114,20 +127,16 @@ void RenderOverlay() {
         
         // Mode selection
         static int current_mode_idx = 0;
-        const char* mode_names[GAME_MODE_COUNT];
-        for (int i = 0; i < GAME_MODE_COUNT; i++) {
-            mode_names[i] = gamemodes[i].mode_name;
-        }
         
-        if (ImGui::Combo("Mode", &current_mode_idx, mode_names, GAME_MODE_COUNT)) {
-            gamestate.current_mode = &gamemodes[current_mode_idx];
-            gamestate.player_pos = 0;
-            gamestate.last_input_acc = NONE;
+        if (ImGui::Combo("Mode", &current_mode_idx, _overlayModeName, NULL, overlay_session.mode_count)) {
+            overlay_session.state.current_mode = &overlay_session.modes[current_mode_idx];
+            overlay_session.state.player_pos = 0;
+            overlay_session.state.last_input_acc = NONE;
         }
         
         // Progress bar for current pattern
-        if (gamestate.current_mode) {
-            float progress = (float)gamestate.player_pos / gamestate.current_mode->pattern_size;
+        if (overlay_session.state.current_mode) {
+            float progress = (float)overlay_session.state.player_pos / overlay_session.state.current_mode->pattern_size;
             ImGui::ProgressBar(progress, ImVec2(-1.0f, 0.0f), "");
         }
     }
@@ -177,7 +186,7 @@ void MonitorGameInputs() {
         last_input_time = current_time;
         
         // Process the input
-        if (gamestate.current_mode) {
+        if (overlay_session.state.current_mode) {
             ProcessInput(detected_input);
         }
         
@@ -179,13 +179,14 @@ void RenderOverlay() {
     ImGui::PopStyleColor(2);
 }
 
-// Input processing function for overlay
-void ProcessInput(int input) {
+// Input processing function for overlay, now is in milliseconds from
+// whatever clock the caller runs on
+void ProcessInput(int input, DWORD now) {
     if (!simple_gamestate.current_mode) return;
     
     // Handle miss pause - wait 2 seconds before resetting
     if (simple_gamestate.in_miss_pause) {
-        DWORD current_time = GetTickCount();
+        DWORD current_time = now;
         DWORD pause_duration = 2000; // 2 seconds in milliseconds
         
         if (current_time - simple_gamestate.miss_time >= pause_duration) {
@@ -200,7 +201,7 @@ void ProcessInput(int input) {
     
     if (simple_gamestate.last_input_acc == 2) { // FAIL
         // Start miss pause timer
-        simple_gamestate.miss_time = GetTickCount();
+        simple_gamestate.miss_time = now;
         simple_gamestate.in_miss_pause = true;
         return;
     }
@@ -267,7 +268,7 @@ void MonitorGameInputs() {
         
         // Process the input
         if (simple_gamestate.current_mode) {
-            ProcessInput(detected_input);
+            ProcessInput(detected_input, current_time);
         }
         
         // Keep buffer size manageable
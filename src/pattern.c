@@ -0,0 +1,709 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input.h"
+#include "notation.h"
+#include "pattern.h"
+
+// Parsed into a syntax tree whose leaves are positions (one per direction
+// token), then turned into a position automaton (Glushkov) and finally a
+// DFA by subset construction. Positions fit a 128 bit set.
+
+#define PATTERN_MAX_NODES 512
+#define ANY_DIRECTION 0x1FF
+
+typedef struct {
+    uint64_t bits[2];
+} PosSet;
+
+typedef enum {
+    NODE_EMPTY = 0,
+    NODE_STEP,
+    NODE_CAT,
+    NODE_ALT,
+    NODE_STAR,
+    NODE_OPT
+} NodeKind;
+
+typedef struct {
+    uint8_t kind;
+    int16_t left;
+    int16_t right;
+    // NODE_STEP only
+    int16_t pos;
+} Node;
+
+typedef struct {
+    const char *source;
+    const char *p;
+    bool failed;
+
+    Node nodes[PATTERN_MAX_NODES];
+    int node_count;
+
+    // Per position, directions matched (bit per GameDirection) and hold
+    uint16_t dirs[PATTERN_MAX_POSITIONS];
+    StepWindow windows[PATTERN_MAX_POSITIONS];
+    int pos_count;
+
+    bool nullable[PATTERN_MAX_NODES];
+    PosSet first[PATTERN_MAX_NODES];
+    PosSet last[PATTERN_MAX_NODES];
+    PosSet follow[PATTERN_MAX_POSITIONS];
+} PatternParser;
+
+static void _setAdd(PosSet *set, int pos)
+{
+    set->bits[pos >> 6] |= 1ULL << (pos & 63);
+}
+
+static bool _setHas(const PosSet *set, int pos)
+{
+    return (set->bits[pos >> 6] >> (pos & 63)) & 1;
+}
+
+static PosSet _setUnion(PosSet a, PosSet b)
+{
+    PosSet out = { { a.bits[0] | b.bits[0], a.bits[1] | b.bits[1] } };
+    return out;
+}
+
+static PosSet _setAnd(PosSet a, PosSet b)
+{
+    PosSet out = { { a.bits[0] & b.bits[0], a.bits[1] & b.bits[1] } };
+    return out;
+}
+
+static bool _setEmpty(PosSet a)
+{
+    return (a.bits[0] | a.bits[1]) == 0;
+}
+
+static bool _setEqual(PosSet a, PosSet b)
+{
+    return a.bits[0] == b.bits[0] && a.bits[1] == b.bits[1];
+}
+
+static int _fail(PatternParser *pp, const char *what)
+{
+    if (!pp->failed)
+        printf("Pattern \"%s\", column %d: %s\n", pp->source, (int)(pp->p - pp->source) + 1, what);
+
+    pp->failed = true;
+    return -1;
+}
+
+static int _newNode(PatternParser *pp, NodeKind kind, int left, int right)
+{
+    if (left < 0 && kind != NODE_EMPTY && kind != NODE_STEP)
+        return -1;
+    if (right < 0 && (kind == NODE_CAT || kind == NODE_ALT))
+        return -1;
+    if (pp->node_count == PATTERN_MAX_NODES)
+        return _fail(pp, "pattern too long");
+
+    Node *node = &pp->nodes[pp->node_count];
+    node->kind = kind;
+    node->left = left;
+    node->right = right;
+    node->pos = -1;
+    return pp->node_count++;
+}
+
+static int _newStep(PatternParser *pp, uint16_t dirs)
+{
+    if (pp->pos_count == PATTERN_MAX_POSITIONS)
+        return _fail(pp, "too many steps");
+
+    int node = _newNode(pp, NODE_STEP, -1, -1);
+    if (node < 0)
+        return -1;
+
+    StepWindow none = {0, 0};
+    pp->dirs[pp->pos_count] = dirs;
+    pp->windows[pp->pos_count] = none;
+    pp->nodes[node].pos = pp->pos_count++;
+    return node;
+}
+
+// Repetition copies a subtree, every copy gets positions of its own
+static int _clone(PatternParser *pp, int node)
+{
+    if (node < 0)
+        return -1;
+
+    Node src = pp->nodes[node];
+
+    if (src.kind == NODE_STEP)
+    {
+        int copy = _newStep(pp, pp->dirs[src.pos]);
+        if (copy >= 0)
+            pp->windows[pp->nodes[copy].pos] = pp->windows[src.pos];
+        return copy;
+    }
+
+    int left = src.left >= 0 ? _clone(pp, src.left) : -1;
+    int right = src.right >= 0 ? _clone(pp, src.right) : -1;
+    return _newNode(pp, src.kind, left, right);
+}
+
+static void _setHold(PatternParser *pp, int node, StepWindow window)
+{
+    if (node < 0)
+        return;
+
+    Node *n = &pp->nodes[node];
+    if (n->kind == NODE_STEP)
+    {
+        if (pp->windows[n->pos].max_frames == 0)
+            pp->windows[n->pos] = window;
+        return;
+    }
+
+    _setHold(pp, n->left, window);
+    _setHold(pp, n->right, window);
+}
+
+static void _skipSpace(PatternParser *pp)
+{
+    while (*pp->p == ',' || isspace((unsigned char)*pp->p))
+        pp->p++;
+}
+
+static bool _parseNumber(PatternParser *pp, int *out)
+{
+    if (!isdigit((unsigned char)*pp->p))
+        return false;
+
+    int value = 0;
+    while (isdigit((unsigned char)*pp->p))
+    {
+        value = value * 10 + (*pp->p - '0');
+        if (value > 0xFFFF)
+            return false;
+        pp->p++;
+    }
+
+    *out = value;
+    return true;
+}
+
+// A direction name as a bit, or a run of numpad digits as bits in order
+static int _parseWord(PatternParser *pp, uint16_t *dirs, int max)
+{
+    const char *word = pp->p;
+    while (isalnum((unsigned char)*pp->p))
+        pp->p++;
+
+    size_t len = (size_t)(pp->p - word);
+    GameDirection dir;
+
+    if (len == 0)
+        return _fail(pp, "expected a direction");
+
+    if (isdigit((unsigned char)word[0]))
+    {
+        if ((int)len > max)
+            return _fail(pp, "numpad run too long");
+
+        for (size_t i = 0; i < len; i++)
+        {
+            if (!ParseDirection(word + i, 1, &dir))
+                return _fail(pp, "unknown numpad direction");
+            dirs[i] = 1 << dir;
+        }
+
+        return (int)len;
+    }
+
+    if (!ParseDirection(word, len, &dir))
+        return _fail(pp, "unknown direction");
+
+    dirs[0] = 1 << dir;
+    return 1;
+}
+
+// [n f df], single words only
+static bool _parseClass(PatternParser *pp, uint16_t *dirs)
+{
+    pp->p++;
+    *dirs = 0;
+
+    for (;;)
+    {
+        _skipSpace(pp);
+        if (*pp->p == ']')
+        {
+            pp->p++;
+            break;
+        }
+
+        uint16_t word[1];
+        if (_parseWord(pp, word, 1) < 0)
+            return false;
+        *dirs |= word[0];
+    }
+
+    if (*dirs == 0)
+    {
+        _fail(pp, "empty direction set");
+        return false;
+    }
+
+    return true;
+}
+
+static int _parseAlt(PatternParser *pp);
+
+static int _parseAtom(PatternParser *pp)
+{
+    char c = *pp->p;
+
+    if (c == '(')
+    {
+        pp->p++;
+        int inner = _parseAlt(pp);
+        _skipSpace(pp);
+        if (*pp->p != ')')
+            return _fail(pp, "missing )");
+        pp->p++;
+        return inner;
+    }
+
+    if (c == '.')
+    {
+        pp->p++;
+        return _newStep(pp, ANY_DIRECTION);
+    }
+
+    if (c == '!' || c == '[')
+    {
+        bool negate = c == '!';
+        uint16_t dirs;
+
+        if (negate)
+            pp->p++;
+
+        if (*pp->p == '[')
+        {
+            if (!_parseClass(pp, &dirs))
+                return -1;
+        }
+        else if (_parseWord(pp, &dirs, 1) < 0)
+            return -1;
+
+        if (negate)
+            dirs = ANY_DIRECTION & ~dirs;
+        if (dirs == 0)
+            return _fail(pp, "matches no direction");
+
+        return _newStep(pp, dirs);
+    }
+
+    uint16_t dirs[PATTERN_MAX_POSITIONS];
+    int count = _parseWord(pp, dirs, PATTERN_MAX_POSITIONS);
+    if (count < 0)
+        return -1;
+
+    int node = _newStep(pp, dirs[0]);
+    for (int i = 1; i < count; i++)
+        node = _newNode(pp, NODE_CAT, node, _newStep(pp, dirs[i]));
+
+    return node;
+}
+
+static int _parseItem(PatternParser *pp)
+{
+    int node = _parseAtom(pp);
+
+    while (node >= 0)
+    {
+        char c = *pp->p;
+
+        if (c == '?')
+        {
+            pp->p++;
+            node = _newNode(pp, NODE_OPT, node, -1);
+        }
+        else if (c == '*')
+        {
+            pp->p++;
+            node = _newNode(pp, NODE_STAR, node, -1);
+        }
+        else if (c == '+')
+        {
+            pp->p++;
+            node = _newNode(pp, NODE_CAT, node, _newNode(pp, NODE_STAR, _clone(pp, node), -1));
+        }
+        else if (c == '{')
+        {
+            int min, max;
+            pp->p++;
+            if (!_parseNumber(pp, &min))
+                return _fail(pp, "expected a repeat count");
+            max = min;
+            if (*pp->p == ',' && (pp->p++, !_parseNumber(pp, &max)))
+                return _fail(pp, "expected a repeat count");
+            if (*pp->p != '}')
+                return _fail(pp, "missing }");
+            pp->p++;
+
+            if (min > max || max == 0 || max > PATTERN_MAX_POSITIONS)
+                return _fail(pp, "bad repeat count");
+
+            // x{2,4} is x x x? x?
+            int repeated = node;
+            for (int i = 1; i < max && repeated >= 0; i++)
+            {
+                int copy = _clone(pp, node);
+                if (i >= min)
+                    copy = _newNode(pp, NODE_OPT, copy, -1);
+                repeated = _newNode(pp, NODE_CAT, repeated, copy);
+            }
+            if (min == 0)
+                repeated = _newNode(pp, NODE_OPT, repeated, -1);
+            node = repeated;
+        }
+        else if (c == ':')
+        {
+            int min, max;
+            pp->p++;
+            if (!_parseNumber(pp, &min))
+                return _fail(pp, "expected a hold in frames");
+            max = min;
+            if (*pp->p == '-' && (pp->p++, !_parseNumber(pp, &max)))
+                return _fail(pp, "expected a hold in frames");
+
+            if (min > max || max == 0)
+                return _fail(pp, "bad hold");
+
+            StepWindow window = { (uint16_t)min, (uint16_t)max };
+            _setHold(pp, node, window);
+        }
+        else
+            break;
+    }
+
+    return node;
+}
+
+static int _parseSeq(PatternParser *pp)
+{
+    int node = -1;
+
+    for (;;)
+    {
+        _skipSpace(pp);
+        char c = *pp->p;
+        if (c == '\0' || c == '|' || c == ')')
+            break;
+
+        int item = _parseItem(pp);
+        if (item < 0)
+            return -1;
+
+        node = node < 0 ? item : _newNode(pp, NODE_CAT, node, item);
+    }
+
+    return node < 0 ? _newNode(pp, NODE_EMPTY, -1, -1) : node;
+}
+
+static int _parseAlt(PatternParser *pp)
+{
+    int node = _parseSeq(pp);
+
+    while (node >= 0 && *pp->p == '|')
+    {
+        pp->p++;
+        node = _newNode(pp, NODE_ALT, node, _parseSeq(pp));
+    }
+
+    return node;
+}
+
+// nullable, first and last for every node, follow for every position
+static void _analyze(PatternParser *pp, int node)
+{
+    Node *n = &pp->nodes[node];
+    PosSet none = { { 0, 0 } };
+
+    if (n->left >= 0)
+        _analyze(pp, n->left);
+    if (n->right >= 0)
+        _analyze(pp, n->right);
+
+    int l = n->left;
+    int r = n->right;
+
+    switch (n->kind)
+    {
+        case NODE_EMPTY:
+            pp->nullable[node] = true;
+            pp->first[node] = none;
+            pp->last[node] = none;
+            break;
+        case NODE_STEP:
+            pp->nullable[node] = false;
+            pp->first[node] = none;
+            _setAdd(&pp->first[node], n->pos);
+            pp->last[node] = pp->first[node];
+            break;
+        case NODE_ALT:
+            pp->nullable[node] = pp->nullable[l] || pp->nullable[r];
+            pp->first[node] = _setUnion(pp->first[l], pp->first[r]);
+            pp->last[node] = _setUnion(pp->last[l], pp->last[r]);
+            break;
+        case NODE_CAT:
+            pp->nullable[node] = pp->nullable[l] && pp->nullable[r];
+            pp->first[node] = pp->nullable[l] ? _setUnion(pp->first[l], pp->first[r]) : pp->first[l];
+            pp->last[node] = pp->nullable[r] ? _setUnion(pp->last[l], pp->last[r]) : pp->last[r];
+
+            for (int pos = 0; pos < pp->pos_count; pos++)
+            {
+                if (_setHas(&pp->last[l], pos))
+                    pp->follow[pos] = _setUnion(pp->follow[pos], pp->first[r]);
+            }
+            break;
+        case NODE_STAR:
+        case NODE_OPT:
+            pp->nullable[node] = true;
+            pp->first[node] = pp->first[l];
+            pp->last[node] = pp->last[l];
+
+            if (n->kind == NODE_STAR)
+            {
+                for (int pos = 0; pos < pp->pos_count; pos++)
+                {
+                    if (_setHas(&pp->last[l], pos))
+                        pp->follow[pos] = _setUnion(pp->follow[pos], pp->first[l]);
+                }
+            }
+            break;
+    }
+}
+
+static int _lowestPos(PosSet set)
+{
+    if (set.bits[0] != 0)
+    {
+        for (int i = 0; i < 64; i++)
+            if ((set.bits[0] >> i) & 1)
+                return i;
+    }
+
+    for (int i = 0; i < 64; i++)
+        if ((set.bits[1] >> i) & 1)
+            return 64 + i;
+
+    return -1;
+}
+
+// The hint is the step on the shortest way to finishing the technique,
+// ties go to whichever was written first. Once finished it's the start
+// of the next one.
+static void _pickHints(PatternDfa *dfa, uint8_t rank[PATTERN_MAX_STATES][PATTERN_COLUMNS])
+{
+    int dist[PATTERN_MAX_STATES];
+    for (int s = 0; s < dfa->state_count; s++)
+        dist[s] = dfa->accepting[s] ? 0 : PATTERN_MAX_STATES;
+
+    // Few enough states that relaxing until nothing changes is plenty
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (int s = 0; s < dfa->state_count; s++)
+        {
+            for (int dir = NEUTRAL; dir <= UP_BACK; dir++)
+            {
+                uint8_t next = dfa->next[s][dir];
+                if (next != PATTERN_DEAD && dist[next] + 1 < dist[s])
+                {
+                    dist[s] = dist[next] + 1;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (int s = 0; s < dfa->state_count; s++)
+    {
+        int best = -1;
+        for (int dir = NEUTRAL; dir <= UP_BACK; dir++)
+        {
+            uint8_t next = dfa->next[s][dir];
+            if (next == PATTERN_DEAD)
+                continue;
+
+            if (best < 0 || dist[next] < dist[dfa->next[s][best]]
+                || (dist[next] == dist[dfa->next[s][best]] && rank[s][dir] < rank[s][best]))
+                best = dir;
+        }
+
+        dfa->hint[s] = best >= 0 ? (uint8_t)best : NEUTRAL;
+    }
+
+    for (int s = 0; s < dfa->state_count; s++)
+    {
+        if (dfa->accepting[s])
+            dfa->hint[s] = dfa->hint[PATTERN_START];
+    }
+}
+
+bool CompilePattern(const char *source, PatternDfa *dfa)
+{
+    PatternParser *pp = calloc(1, sizeof(PatternParser));
+    if (pp == NULL)
+        return false;
+
+    pp->source = source;
+    pp->p = source;
+
+    int root = _parseAlt(pp);
+    if (root >= 0 && *pp->p != '\0')
+        root = _fail(pp, "unexpected character");
+
+    if (root < 0)
+    {
+        free(pp);
+        return false;
+    }
+
+    _analyze(pp, root);
+
+    if (pp->nullable[root])
+    {
+        _fail(pp, "pattern can be empty");
+        free(pp);
+        return false;
+    }
+
+    // Which positions each direction can move into
+    PosSet by_dir[PATTERN_COLUMNS];
+    memset(by_dir, 0, sizeof(by_dir));
+    for (int pos = 0; pos < pp->pos_count; pos++)
+    {
+        for (int dir = NEUTRAL; dir <= UP_BACK; dir++)
+        {
+            if (pp->dirs[pos] & (1 << dir))
+                _setAdd(&by_dir[dir], pos);
+        }
+    }
+
+    // DFA states are the sets of positions that could have matched last,
+    // the start state is the empty set
+    PosSet states[PATTERN_MAX_STATES];
+    memset(states, 0, sizeof(states));
+
+    // Per state and direction, the first written position it matches
+    uint8_t rank[PATTERN_MAX_STATES][PATTERN_COLUMNS];
+    memset(dfa, 0, sizeof(*dfa));
+    dfa->state_count = 1;
+
+    for (int s = 0; s < dfa->state_count; s++)
+    {
+        PosSet candidates = pp->first[root];
+        StepWindow window = {0, 0};
+
+        if (s != PATTERN_START)
+        {
+            candidates.bits[0] = candidates.bits[1] = 0;
+            for (int pos = 0; pos < pp->pos_count; pos++)
+            {
+                if (!_setHas(&states[s], pos))
+                    continue;
+
+                candidates = _setUnion(candidates, pp->follow[pos]);
+
+                // Overlapping steps share a state, allow the widest hold
+                StepWindow w = pp->windows[pos];
+                if (w.max_frames == 0)
+                    continue;
+                if (window.max_frames == 0 || w.min_frames < window.min_frames)
+                    window.min_frames = w.min_frames;
+                if (w.max_frames > window.max_frames)
+                    window.max_frames = w.max_frames;
+            }
+
+            dfa->accepting[s] = !_setEmpty(_setAnd(states[s], pp->last[root]));
+        }
+
+        dfa->window[s] = window;
+
+        bool any = false;
+        for (int dir = 0; dir < PATTERN_COLUMNS; dir++)
+        {
+            PosSet target = _setAnd(candidates, by_dir[dir]);
+            dfa->next[s][dir] = PATTERN_DEAD;
+
+            if (_setEmpty(target))
+                continue;
+
+            rank[s][dir] = (uint8_t)_lowestPos(target);
+
+            int t = 1;
+            while (t < dfa->state_count && !_setEqual(states[t], target))
+                t++;
+
+            if (t == dfa->state_count)
+            {
+                if (dfa->state_count == PATTERN_MAX_STATES)
+                {
+                    _fail(pp, "pattern needs too many states");
+                    free(pp);
+                    return false;
+                }
+
+                states[dfa->state_count++] = target;
+            }
+
+            dfa->next[s][dir] = (uint8_t)t;
+            any = true;
+        }
+
+        dfa->final[s] = dfa->accepting[s] && !any;
+    }
+
+    free(pp);
+    _pickHints(dfa, rank);
+    return true;
+}
+
+int PatternMainPath(const PatternDfa *dfa, GameDirection *path, int max)
+{
+    int state = PATTERN_START;
+    int count = 0;
+
+    while (count < max)
+    {
+        GameDirection dir = (GameDirection)dfa->hint[state];
+        uint8_t next = dfa->next[state][dir];
+        if (next == PATTERN_DEAD)
+            break;
+
+        path[count++] = dir;
+        state = next;
+
+        if (dfa->accepting[state])
+            break;
+    }
+
+    return count;
+}
+
+void MirrorPattern(const PatternDfa *dfa, PatternDfa *out)
+{
+    *out = *dfa;
+
+    for (int s = 0; s < dfa->state_count; s++)
+    {
+        for (int dir = 0; dir < PATTERN_COLUMNS; dir++)
+            out->next[s][MirrorDirection((GameDirection)dir)] = dfa->next[s][dir];
+
+        out->hint[s] = (uint8_t)MirrorDirection((GameDirection)dfa->hint[s]);
+    }
+}
@@ -0,0 +1,205 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "notation.h"
+#include "recognizer.h"
+
+void InitRecognizer(Recognizer *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->node_count = 1;
+    rec->last_technique = -1;
+    rec->prev = UNKNOWN;
+}
+
+bool AddTechnique(Recognizer *rec, const char *name, const char *sequence)
+{
+    if (rec->technique_count == RECOGNIZER_MAX_TECHNIQUES)
+    {
+        printf("Too many techniques, %s skipped\n", name);
+        return false;
+    }
+
+    GameDirection steps[RECOGNIZER_MAX_NODES];
+    int length = 0;
+    const char *p = sequence;
+
+    while (*p != '\0')
+    {
+        if (*p == ',' || isspace((unsigned char)*p))
+        {
+            p++;
+            continue;
+        }
+
+        const char *word = p;
+        while (isalnum((unsigned char)*p))
+            p++;
+
+        // A run of numpad digits is one step per digit
+        size_t len = (size_t)(p - word);
+        bool numpad = len > 0 && isdigit((unsigned char)word[0]);
+        size_t count = numpad ? len : 1;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            bool ok = numpad ? ParseDirection(word + i, 1, &steps[length]) : ParseDirection(word, len, &steps[length]);
+            if (!ok || length == RECOGNIZER_MAX_NODES - 1)
+            {
+                printf("Technique %s: %s in \"%s\"\n", name, ok ? "too many steps" : "bad direction", sequence);
+                return false;
+            }
+            length++;
+        }
+    }
+
+    if (length == 0)
+    {
+        printf("Technique %s has no steps\n", name);
+        return false;
+    }
+
+    // Count the new nodes first so a full trie is left untouched
+    int node = RECOGNIZER_ROOT;
+    int shared = 0;
+    while (shared < length && rec->next[node][steps[shared]] != 0)
+        node = rec->next[node][steps[shared++]];
+
+    if (rec->node_count + (length - shared) > RECOGNIZER_MAX_NODES)
+    {
+        printf("Too many technique steps, %s skipped\n", name);
+        return false;
+    }
+
+    for (int i = shared; i < length; i++)
+    {
+        rec->next[node][steps[i]] = (uint16_t)rec->node_count++;
+        node = rec->next[node][steps[i]];
+    }
+
+    int id = rec->technique_count++;
+    rec->matches[node] |= 1u << id;
+    rec->techniques[id].name = name;
+    return true;
+}
+
+// Breadth first so every node's failure target is finished before it's
+// needed, then missing edges borrow the failure target's edge
+void BuildRecognizer(Recognizer *rec)
+{
+    uint16_t queue[RECOGNIZER_MAX_NODES];
+    int head = 0;
+    int tail = 0;
+
+    for (int dir = 0; dir < PATTERN_COLUMNS; dir++)
+    {
+        uint16_t child = rec->next[RECOGNIZER_ROOT][dir];
+        if (child != 0)
+        {
+            rec->fail[child] = RECOGNIZER_ROOT;
+            queue[tail++] = child;
+        }
+    }
+
+    while (head < tail)
+    {
+        uint16_t node = queue[head++];
+        rec->matches[node] |= rec->matches[rec->fail[node]];
+
+        for (int dir = 0; dir < PATTERN_COLUMNS; dir++)
+        {
+            uint16_t child = rec->next[node][dir];
+            uint16_t fallback = rec->next[rec->fail[node]][dir];
+
+            if (child == 0)
+            {
+                rec->next[node][dir] = fallback;
+                continue;
+            }
+
+            rec->fail[child] = fallback;
+            queue[tail++] = child;
+        }
+    }
+
+    // Off-pattern directions keep the stream at the root
+    for (int dir = UNKNOWN; dir < PATTERN_COLUMNS; dir++)
+    {
+        for (int node = 0; node < rec->node_count; node++)
+            rec->next[node][dir] = RECOGNIZER_ROOT;
+    }
+
+    ResetRecognizer(rec);
+}
+
+void ResetRecognizer(Recognizer *rec)
+{
+    for (int i = 0; i < rec->technique_count; i++)
+    {
+        rec->techniques[i].count = 0;
+        rec->techniques[i].first_ns = 0;
+        rec->techniques[i].last_ns = 0;
+    }
+
+    rec->node = RECOGNIZER_ROOT;
+    rec->prev = UNKNOWN;
+    rec->inputs = 0;
+    rec->start_ns = 0;
+    rec->last_technique = -1;
+}
+
+uint32_t FeedRecognizer(Recognizer *rec, GameDirection dir, uint64_t timestamp_ns)
+{
+    if (dir == rec->prev)
+        return 0;
+
+    if (rec->inputs++ == 0)
+        rec->start_ns = timestamp_ns;
+
+    rec->prev = dir;
+    rec->node = rec->next[rec->node][dir];
+
+    uint32_t found = rec->matches[rec->node];
+    for (uint32_t bits = found; bits != 0; bits &= bits - 1)
+    {
+        int id = 0;
+        while (!((bits >> id) & 1))
+            id++;
+
+        TechniqueStats *stats = &rec->techniques[id];
+        if (stats->count++ == 0)
+            stats->first_ns = timestamp_ns;
+        stats->last_ns = timestamp_ns;
+        rec->last_technique = id;
+    }
+
+    return found;
+}
+
+uint64_t RecognizedTotal(const Recognizer *rec)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < rec->technique_count; i++)
+        total += rec->techniques[i].count;
+
+    return total;
+}
+
+double TechniqueRate(const Recognizer *rec, int technique)
+{
+    const TechniqueStats *stats = &rec->techniques[technique];
+    if (stats->count < 2 || stats->last_ns == stats->first_ns)
+        return 0.0;
+
+    return (stats->count - 1) / ((stats->last_ns - stats->first_ns) / 1e9);
+}
+
+void PrintRecognizerStats(const Recognizer *rec)
+{
+    for (int i = 0; i < rec->technique_count; i++)
+    {
+        const TechniqueStats *stats = &rec->techniques[i];
+        printf("  %-16s %8llu  %.2f/s\n", stats->name, (unsigned long long)stats->count, TechniqueRate(rec, i));
+    }
+}
@@ -0,0 +1,328 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "input.h"
+#include "input_ring.h"
+#include "recording.h"
+#include "recording_index.h"
+#include "writer_thread.h"
+
+#define WRITER_BUFFER_RECORDS 8192
+
+#define WRITER_INTERVAL_MS 20
+
+struct RecordingWriter {
+    FILE *file;
+    RecordingHeader header;
+
+    InputRing queue;
+    WriterThread thread;
+
+    // Writer thread only
+    RecordingIndexWriter *index;
+    uint64_t last_ns;
+    RecordedInput buffer[WRITER_BUFFER_RECORDS];
+    int buffered;
+
+    // Frame thread only, to skip repeats
+    InputEvent last_queued;
+    bool has_queued;
+};
+
+static void _flushRecords(RecordingWriter *writer)
+{
+    if (writer->buffered == 0)
+        return;
+
+    fwrite(writer->buffer, sizeof(RecordedInput), (size_t)writer->buffered, writer->file);
+    writer->header.record_count += (uint64_t)writer->buffered;
+    writer->buffered = 0;
+}
+
+static void _appendRecord(RecordingWriter *writer, uint32_t delta_ns, uint8_t direction, uint8_t buttons)
+{
+    if (writer->buffered == WRITER_BUFFER_RECORDS)
+        _flushRecords(writer);
+
+    RecordedInput *rec = &writer->buffer[writer->buffered++];
+    rec->delta_ns = delta_ns;
+    rec->direction = direction;
+    rec->buttons = buttons;
+    rec->reserved = 0;
+}
+
+static void _encodeEvent(void *user, const void *item)
+{
+    RecordingWriter *writer = user;
+    const InputEvent *ev = item;
+
+    uint64_t delta = ev->timestamp_ns > writer->last_ns ? ev->timestamp_ns - writer->last_ns : 0;
+
+    // Long idle stretches become a run of gap records
+    while (delta > UINT32_MAX)
+    {
+        _appendRecord(writer, UINT32_MAX, RECORD_GAP, 0);
+        delta -= UINT32_MAX;
+    }
+
+    _appendRecord(writer, (uint32_t)delta, ev->direction, ev->buttons);
+    writer->last_ns = ev->timestamp_ns > writer->last_ns ? ev->timestamp_ns : writer->last_ns;
+
+    // Judged the way a reader will see it, out of order times clamped
+    InputEvent read_back = *ev;
+    read_back.timestamp_ns = writer->last_ns;
+
+    uint64_t records = writer->header.record_count + (uint64_t)writer->buffered;
+    IndexRecordedInput(writer->index, &read_back, writer->header.header_size + records * sizeof(RecordedInput));
+}
+
+static void _endPass(void *user, int items)
+{
+    (void)items;
+
+    _flushRecords(user);
+}
+
+bool InitRecordingHeader(RecordingHeader *header, RecordingClock clock, int mode, const char *mode_name,
+                         const GameDirection *pattern, int pattern_size, uint64_t start_ns)
+{
+    memset(header, 0, sizeof(RecordingHeader));
+    memcpy(header->magic, RECORDING_MAGIC, 4);
+    header->version = RECORDING_VERSION;
+    header->header_size = sizeof(RecordingHeader);
+
+    header->clock_source = (uint8_t)clock;
+    header->mode = (uint16_t)mode;
+    header->start_ns = start_ns;
+
+    // Cutting either down would replay against another mode
+    if (pattern_size < 0 || pattern_size > RECORDING_MAX_PATTERN || mode < 0 || mode > UINT16_MAX)
+    {
+        printf("Mode %d doesn't fit in a recording header\n", mode);
+        return false;
+    }
+
+    if (mode_name != NULL && strlen(mode_name) >= RECORDING_NAME_SIZE)
+    {
+        printf("Mode name %s is too long to record, at most %d characters\n", mode_name, RECORDING_NAME_SIZE - 1);
+        return false;
+    }
+
+    header->pattern_size = (uint16_t)pattern_size;
+    for (int i = 0; i < pattern_size; i++)
+        header->pattern[i] = (uint8_t)pattern[i];
+
+    if (mode_name != NULL)
+        snprintf(header->mode_name, RECORDING_NAME_SIZE, "%s", mode_name);
+
+    return true;
+}
+
+RecordingWriter *OpenRecordingWriter(const char *path, const RecordingHeader *header, const PatternDfa *dfa)
+{
+    RecordingWriter *writer = calloc(1, sizeof(RecordingWriter));
+    if (writer == NULL)
+        return NULL;
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL)
+    {
+        printf("Error opening recording %s\n", path);
+        free(writer);
+        return NULL;
+    }
+
+    writer->header = *header;
+    writer->header.record_count = 0;
+    writer->last_ns = header->start_ns;
+
+    fwrite(&writer->header, sizeof(RecordingHeader), 1, writer->file);
+    writer->index = OpenRecordingIndexWriter(path, header, dfa);
+
+    InitInputRing(&writer->queue);
+
+    if (!StartWriterThread(&writer->thread, "KBDRecorder", &writer->queue.ring, WRITER_INTERVAL_MS,
+                           _encodeEvent, _endPass, writer))
+    {
+        CloseRecordingIndexWriter(writer->index);
+        fclose(writer->file);
+        free(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+void RecordInput(RecordingWriter *writer, const InputEvent *ev)
+{
+    if (writer->has_queued
+        && ev->direction == writer->last_queued.direction
+        && ev->buttons == writer->last_queued.buttons)
+        return;
+
+    // A full queue drops and counts it, CloseRecordingWriter() reports
+    // the recording has holes. Not remembered, so the next input that
+    // differs from the last one queued still goes in.
+    if (!PushInputEvent(&writer->queue, ev))
+        return;
+
+    writer->last_queued = *ev;
+    writer->has_queued = true;
+}
+
+void CloseRecordingWriter(RecordingWriter *writer)
+{
+    if (writer == NULL)
+        return;
+
+    StopWriterThread(&writer->thread);
+    CloseRecordingIndexWriter(writer->index);
+
+    // Patch in the final count now that it's known
+    fseek(writer->file, 0, SEEK_SET);
+    fwrite(&writer->header, sizeof(RecordingHeader), 1, writer->file);
+    fclose(writer->file);
+
+    int dropped = InputRingDropped(&writer->queue);
+    if (dropped > 0)
+        printf("Recording dropped %d inputs\n", dropped);
+
+    free(writer);
+}
+
+bool OpenRecordingReader(RecordingReader *reader, const char *path)
+{
+    memset(reader, 0, sizeof(RecordingReader));
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        printf("Error opening recording %s\n", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+
+    HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    void *base = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (base == NULL)
+    {
+        if (mapping != NULL)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        printf("Error mapping recording %s\n", path);
+        return false;
+    }
+
+    reader->file = (intptr_t)file;
+    reader->mapping = (intptr_t)mapping;
+    reader->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Error opening recording %s\n", path);
+        return false;
+    }
+
+    struct stat st;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file alive
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        printf("Error mapping recording %s\n", path);
+        return false;
+    }
+
+    reader->size = (size_t)st.st_size;
+#endif
+
+    reader->base = base;
+    reader->header = base;
+
+    if (reader->size < sizeof(RecordingHeader)
+        || memcmp(reader->header->magic, RECORDING_MAGIC, 4) != 0
+        || reader->header->version != RECORDING_VERSION
+        || reader->header->header_size < sizeof(RecordingHeader)
+        || reader->header->header_size > reader->size
+        || reader->header->pattern_size > RECORDING_MAX_PATTERN)
+    {
+        printf("%s is not a recording this version can read\n", path);
+        CloseRecordingReader(reader);
+        return false;
+    }
+
+    reader->records = (const RecordedInput *)((const char *)base + reader->header->header_size);
+
+    // A recording cut short by a crash never got its count patched in
+    uint64_t on_disk = (reader->size - reader->header->header_size) / sizeof(RecordedInput);
+    reader->record_count = reader->header->record_count != 0 && reader->header->record_count <= on_disk
+        ? reader->header->record_count
+        : on_disk;
+
+    return true;
+}
+
+void CloseRecordingReader(RecordingReader *reader)
+{
+    if (reader->base == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(reader->base);
+    CloseHandle((HANDLE)reader->mapping);
+    CloseHandle((HANDLE)reader->file);
+#else
+    munmap(reader->base, reader->size);
+#endif
+
+    memset(reader, 0, sizeof(RecordingReader));
+}
+
+void BeginRecordingIter(const RecordingReader *reader, RecordingIter *iter)
+{
+    iter->next = reader->records;
+    iter->end = reader->records + reader->record_count;
+    iter->timestamp_ns = reader->header->start_ns;
+}
+
+bool NextRecordedInput(RecordingIter *iter, InputEvent *ev)
+{
+    while (iter->next < iter->end)
+    {
+        const RecordedInput *rec = iter->next++;
+        iter->timestamp_ns += rec->delta_ns;
+
+        if (rec->direction == RECORD_GAP)
+            continue;
+
+        // Anything else a damaged file holds would index past the end of
+        // every transition table, it just breaks the pattern instead
+        ev->timestamp_ns = iter->timestamp_ns;
+        ev->direction = rec->direction < PATTERN_COLUMNS ? rec->direction : UNKNOWN;
+        ev->buttons = rec->buttons;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "recording_index.h"
+
+struct RecordingIndexWriter {
+    FILE *file;
+
+    // The recorded mode, judged like a replay of the file would be
+    GameDirection pattern[RECORDING_MAX_PATTERN];
+    PatternDfa dfa;
+    GameMode mode;
+    Replay replay;
+    uint64_t inputs;
+};
+
+// x.kbdrec -> x.kbdidx, anything else gets the extension added
+static void _indexPath(char *out, size_t size, const char *recording_path)
+{
+    size_t len = strlen(recording_path);
+    size_t ext = strlen(RECORDING_EXTENSION);
+
+    if (len >= ext && strcmp(recording_path + len - ext, RECORDING_EXTENSION) == 0)
+        len -= ext;
+
+    snprintf(out, size, "%.*s%s", (int)len, recording_path, RECORDING_INDEX_EXTENSION);
+}
+
+// FNV-1a of the whole table, CompilePattern() zeroes it first
+static uint64_t _patternHash(const PatternDfa *dfa)
+{
+    const uint8_t *bytes = (const uint8_t *)dfa;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < sizeof(PatternDfa); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+static void _toKeyframe(const Replay *replay, uint64_t timestamp_ns, uint64_t offset, uint64_t inputs, RecordingKeyframe *kf)
+{
+    const GameState *gs = &replay->state;
+
+    memset(kf, 0, sizeof(*kf));
+    kf->timestamp_ns = timestamp_ns;
+    kf->offset = offset;
+    kf->inputs = inputs;
+
+    kf->score = gs->score;
+    kf->highscore = gs->highscore;
+    kf->completions = gs->completions;
+    kf->miss_time = gs->miss_time;
+    kf->step_start_ns = gs->step_start_ns;
+
+    const ReplaySummary *summary = &replay->summary;
+    kf->first_ns = replay->first_ns;
+    kf->hits = summary->hits;
+    kf->misses = summary->misses;
+    kf->paused = summary->paused;
+    kf->resets = summary->resets;
+    for (int v = 0; v < TIMING_COUNT; v++)
+        kf->timing[v] = summary->timing[v];
+    kf->quit = summary->quit;
+
+    kf->player_pos = (int16_t)gs->player_pos;
+    kf->held_state = (int16_t)gs->held_state;
+    kf->prev = (uint8_t)replay->prev;
+    kf->curr_input = (uint8_t)gs->curr_input;
+    kf->last_input = (uint8_t)gs->last_input;
+    kf->last_input_acc = (uint8_t)gs->last_input_acc;
+    kf->last_timing = (uint8_t)gs->last_timing;
+    kf->in_miss_pause = gs->in_miss_pause;
+}
+
+static void _fromKeyframe(const RecordingKeyframe *kf, Replay *replay)
+{
+    GameState *gs = &replay->state;
+
+    gs->score = kf->score;
+    gs->highscore = kf->highscore;
+    gs->completions = kf->completions;
+    gs->miss_time = kf->miss_time;
+    gs->step_start_ns = kf->step_start_ns;
+
+    gs->player_pos = kf->player_pos;
+    gs->held_state = kf->held_state;
+    replay->prev = (GameDirection)kf->prev;
+    gs->curr_input = (GameDirection)kf->curr_input;
+    gs->last_input = (GameDirection)kf->last_input;
+    gs->last_input_acc = (InputAccuracy)kf->last_input_acc;
+    gs->last_timing = (TimingVerdict)kf->last_timing;
+    gs->in_miss_pause = kf->in_miss_pause != 0;
+
+    ReplaySummary *summary = &replay->summary;
+    replay->first_ns = kf->first_ns;
+    summary->inputs = kf->inputs;
+    summary->hits = kf->hits;
+    summary->misses = kf->misses;
+    summary->paused = kf->paused;
+    summary->resets = kf->resets;
+    for (int v = 0; v < TIMING_COUNT; v++)
+        summary->timing[v] = kf->timing[v];
+    summary->cycles = kf->completions;
+    summary->score = kf->score;
+    summary->highscore = kf->highscore;
+    summary->quit = kf->quit != 0;
+    summary->duration_ns = kf->timestamp_ns - kf->first_ns;
+}
+
+RecordingIndexWriter *OpenRecordingIndexWriter(const char *recording_path, const RecordingHeader *header, const PatternDfa *dfa)
+{
+    // Free practice, nothing to judge
+    if (header->pattern_size == 0)
+        return NULL;
+
+    RecordingIndexWriter *writer = calloc(1, sizeof(RecordingIndexWriter));
+    if (writer == NULL)
+        return NULL;
+
+    if (!GameModeFromRecording(header, &writer->mode, writer->pattern, &writer->dfa))
+    {
+        free(writer);
+        return NULL;
+    }
+
+    // Alternatives and all, the way the game judges it
+    if (dfa != NULL)
+        writer->dfa = *dfa;
+
+    char path[512];
+    _indexPath(path, sizeof(path), recording_path);
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL)
+    {
+        printf("Error opening recording index %s\n", path);
+        free(writer);
+        return NULL;
+    }
+
+    RecordingIndexHeader index = {0};
+    memcpy(index.magic, RECORDING_INDEX_MAGIC, 4);
+    index.version = RECORDING_INDEX_VERSION;
+    index.keyframe_size = sizeof(RecordingKeyframe);
+    index.interval = RECORDING_INDEX_INTERVAL;
+    index.start_ns = header->start_ns;
+    index.pattern_hash = _patternHash(&writer->dfa);
+    fwrite(&index, sizeof(index), 1, writer->file);
+
+    InitReplay(&writer->replay, &writer->mode, 0);
+    return writer;
+}
+
+void IndexRecordedInput(RecordingIndexWriter *writer, const InputEvent *ev, uint64_t offset)
+{
+    if (writer == NULL)
+        return;
+
+    ReplayInput(&writer->replay, ev);
+    writer->inputs++;
+
+    if (writer->inputs % RECORDING_INDEX_INTERVAL != 0)
+        return;
+
+    RecordingKeyframe kf;
+    _toKeyframe(&writer->replay, ev->timestamp_ns, offset, writer->inputs, &kf);
+    fwrite(&kf, sizeof(kf), 1, writer->file);
+
+    // Out of the stdio buffer right away, a crash keeps every keyframe
+    // but the one being written. One pointing past the records that made
+    // it to disk is left out on load.
+    fflush(writer->file);
+}
+
+void CloseRecordingIndexWriter(RecordingIndexWriter *writer)
+{
+    if (writer == NULL)
+        return;
+
+    fclose(writer->file);
+    free(writer);
+}
+
+bool LoadRecordingIndex(RecordingIndex *index, const char *recording_path, const RecordingReader *reader, const GameMode *mode)
+{
+    memset(index, 0, sizeof(*index));
+
+    char path[512];
+    _indexPath(path, sizeof(path), recording_path);
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    RecordingIndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, RECORDING_INDEX_MAGIC, 4) == 0
+        && header.version == RECORDING_INDEX_VERSION
+        && header.keyframe_size == sizeof(RecordingKeyframe)
+        && header.start_ns == reader->header->start_ns;
+
+    if (!ok)
+    {
+        printf("%s doesn't match its recording, seeking from the start\n", path);
+        fclose(file);
+        return false;
+    }
+
+    if (header.pattern_hash != _patternHash(mode->dfa))
+    {
+        printf("%s was judged with a different pattern than %s, seeking from the start\n", path, mode->mode_name);
+        fclose(file);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, sizeof(header), SEEK_SET);
+
+    int count = (int)((size - (long)sizeof(header)) / (long)sizeof(RecordingKeyframe));
+    index->keyframes = count > 0 ? malloc(count * sizeof(RecordingKeyframe)) : NULL;
+    if (index->keyframes != NULL)
+        count = (int)fread(index->keyframes, sizeof(RecordingKeyframe), count, file);
+    fclose(file);
+
+    // Only what the recording got to before it stopped
+    uint64_t end = reader->header->header_size + reader->record_count * sizeof(RecordedInput);
+    index->count = 0;
+    while (index->keyframes != NULL && index->count < count && index->keyframes[index->count].offset <= end)
+        index->count++;
+
+    return true;
+}
+
+void FreeRecordingIndex(RecordingIndex *index)
+{
+    free(index->keyframes);
+    memset(index, 0, sizeof(*index));
+}
+
+uint64_t SeekRecording(const RecordingReader *reader, const RecordingIndex *index, GameMode *mode, uint64_t time_ns, Replay *replay)
+{
+    RecordingIter it;
+    BeginRecordingIter(reader, &it);
+    InitReplay(replay, mode, 0);
+
+    // Last keyframe at or before time_ns
+    int lo = 0;
+    int hi = index != NULL ? index->count : 0;
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (index->keyframes[mid].timestamp_ns <= time_ns)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo > 0)
+    {
+        const RecordingKeyframe *kf = &index->keyframes[lo - 1];
+        _fromKeyframe(kf, replay);
+
+        it.next = (const RecordedInput *)((const char *)reader->base + kf->offset);
+        it.timestamp_ns = kf->timestamp_ns;
+    }
+
+    uint64_t judged = 0;
+    InputEvent ev;
+    while (NextRecordedInput(&it, &ev) && ev.timestamp_ns <= time_ns)
+    {
+        ReplayInput(replay, &ev);
+        judged++;
+    }
+
+    return judged;
+}
@@ -5,6 +5,7 @@
 #include <SDL3_ttf/SDL_ttf.h>
 #include <SDL3_image/SDL_image.h>
 
+#include "flight_recorder.h"
 #include "render.h"
 #include "game.h"
 #include "input.h"
@@ -26,9 +27,18 @@ SDL_Texture *highscore_texture;
 
 // Input accuracy stuff
 SDL_Texture *acc_textures[3];
+SDL_Texture *timing_textures[TIMING_COUNT];
+// What the last miss turned out to be, shown in place of MISS
+SDL_Texture *miss_kind_textures[MISS_KIND_COUNT];
+
+// Free practice, last technique done and how fast
+SDL_Texture *practice_texture = NULL;
+uint64_t practice_total = 0;
 
 // Menu stuff
-SDL_Texture *menu_textures[GAME_MODE_COUNT];
+// Only the selected mode's name, rebuilt when the selection moves
+SDL_Texture *menu_texture = NULL;
+int menu_texture_mode = -1;
 
 
 
@@ -75,39 +85,61 @@ bool InitTextures(SDL_Renderer *renderer)
     surface = TTF_RenderText_Solid(score_font, failText, strlen(failText), failColor);
     acc_textures[FAIL] = SDL_CreateTextureFromSurface(renderer, surface);
     SDL_DestroySurface(surface);
+
+    // How the last step was held, modes with step windows only
+    const char *timingText[TIMING_COUNT] = { NULL, "JUST", "EARLY", "LATE", "DROP" };
+    SDL_Color timingColor[TIMING_COUNT] = { {0}, {51, 255, 51}, {255, 204, 51}, {255, 204, 51}, {255, 51, 51} };
+    timing_textures[TIMING_NONE] = NULL;
+
+    for (int i = TIMING_JUST; i < TIMING_COUNT; i++)
+    {
+        surface = TTF_RenderText_Solid(score_font, timingText[i], strlen(timingText[i]), timingColor[i]);
+        timing_textures[i] = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_DestroySurface(surface);
+    }
+
+    const char *missKindText[MISS_KIND_COUNT] = { NULL, "SKIPPED N", "EXTRA INPUT", "WRONG DIAGONAL", "SWAPPED ORDER" };
+    miss_kind_textures[MISS_UNCLEAR] = NULL;
+
+    for (int i = MISS_SKIPPED_NEUTRAL; i < MISS_KIND_COUNT; i++)
+    {
+        surface = TTF_RenderText_Solid(score_font, missKindText[i], strlen(missKindText[i]), failColor);
+        miss_kind_textures[i] = SDL_CreateTextureFromSurface(renderer, surface);
+        SDL_DestroySurface(surface);
+    }
  
     return true;
 }
 
-void _updateScore(SDL_Renderer *renderer)
+void _updateScore(SDL_Renderer *renderer, const GameState *gs)
 {
     char scoreText[32];
     SDL_Color scoreColor = {255, 255, 255};
-    if (gamestate.score == curr_score && gamestate.highscore == curr_highscore)
+    if (gs->score == curr_score && gs->highscore == curr_highscore)
         return;
     
     // Update score and destroy old texture
-    curr_score = gamestate.score;
+    curr_score = gs->score;
 
     if (score_texture != NULL)
         SDL_DestroyTexture(score_texture);
     
     
-    snprintf(scoreText, 32, "%06lld\0", gamestate.score);
+    snprintf(scoreText, 32, "%06lld\0", gs->score);
     SDL_Surface *scoreSurface = TTF_RenderText_Solid(score_font, scoreText, strlen(scoreText), scoreColor);
     
     score_texture = SDL_CreateTextureFromSurface(renderer, scoreSurface);
     SDL_DestroySurface(scoreSurface);
     
-    if (gamestate.highscore == curr_highscore)
+    if (gs->highscore == curr_highscore)
         return;
     
     // Update high score and destroy old texture
-    curr_highscore = gamestate.highscore;
+    curr_highscore = gs->highscore;
     if (highscore_texture != NULL)
     SDL_DestroyTexture(highscore_texture);
     
-    snprintf(scoreText, 32, "%06lld\0", gamestate.highscore);
+    snprintf(scoreText, 32, "%06lld\0", gs->highscore);
     scoreSurface = TTF_RenderText_Solid(score_font, scoreText, strlen(scoreText), scoreColor);
     
     highscore_texture = SDL_CreateTextureFromSurface(renderer, scoreSurface);
@@ -117,55 +149,66 @@ void _updateScore(SDL_Renderer *renderer)
 
 
 // Initialize the view for mode select
-bool InitMenuTextures(SDL_Renderer *renderer)
+bool InitMenuTextures(SDL_Renderer *renderer, KbdSession *session)
 {
-    char text[32];
+    const char *text = session->modes[session->selected_mode].mode_name;
     
     SDL_Color textColor = {255, 255, 255};
     
-    for (int i = 0; i < GAME_MODE_COUNT; i++)
+    DestroyMenuTextures();
+    
+    SDL_Surface *surface = TTF_RenderText_Solid(score_font, text, strlen(text), textColor);
+    menu_texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_DestroySurface(surface);
+    
+    if (menu_texture == NULL )
     {
-        snprintf(text, 32, "%s", gamemodes[i].mode_name);
-        SDL_Surface *surface = TTF_RenderText_Solid(score_font, text, strlen(text), textColor);
-        
-        menu_textures[i] = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_DestroySurface(surface);
-        
-        if (menu_textures[i] == NULL )
-        {
-            printf("Error initializing mode select view: %s", SDL_GetError());
-            return false;
-        }
+        printf("Error initializing mode select view: %s", SDL_GetError());
+        return false;
     }
     
+    menu_texture_mode = session->selected_mode;
     return true;
 }
 
 // Destroy mode select textures from memory after game starts
 void DestroyMenuTextures()
 {
-    for (int i = 0; i < GAME_MODE_COUNT; i++)
-    SDL_DestroyTexture(menu_textures[i]);
+    if (menu_texture != NULL)
+        SDL_DestroyTexture(menu_texture);
+    menu_texture = NULL;
+    menu_texture_mode = -1;
+}
+
+// Present on its own in the flight recorder, it's where vsync waits
+static void _present(SDL_Renderer *renderer, KbdSession *session)
+{
+    uint64_t start = ClockNow(session->clock);
+    SDL_RenderPresent(renderer);
+    RecordFlightPhase(FLIGHT_PHASE_PRESENT, start, ClockNow(session->clock));
 }
 
-void Render(SDL_Renderer *renderer)
+void Render(SDL_Renderer *renderer, KbdSession *session)
 {
-    if (gamestate.run_game) 
-        _renderGame(renderer);
+    if (session->state.run_game) 
+        _renderGame(renderer, session);
     else
-        _renderMenu(renderer);
+        _renderMenu(renderer, session);
 }
 
-void _renderMenu(SDL_Renderer *renderer)
+void _renderMenu(SDL_Renderer *renderer, KbdSession *session)
 {
     // Clear with transparent background for overlay effect
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
     SDL_RenderClear(renderer);
     
     SDL_FRect destRect = {SIDE_PADDING, INITIAL_VIEW_HEIGHT / 2 - ICON_HEIGHT / 2, INITIAL_VIEW_WIDTH - (SIDE_PADDING * 2), ICON_HEIGHT};
-    SDL_RenderTexture(renderer, menu_textures[selected_mode], NULL, &destRect);
+    if (menu_texture_mode != session->selected_mode)
+        InitMenuTextures(renderer, session);
     
-    SDL_RenderPresent(renderer);
+    SDL_RenderTexture(renderer, menu_texture, NULL, &destRect);
+    
+    _present(renderer, session);
 }
 
 // ************* GAME RENDER ******************//
@@ -212,27 +255,94 @@ SDL_FRect failed_acc_rect = {
 };
 
 
-void _renderGame(SDL_Renderer *renderer) 
+static void _renderPractice(SDL_Renderer *renderer, KbdSession *session)
 {
+    const GameState *gs = &session->state;
+    const Recognizer *rec = GetPracticeRecognizer(session);
+    uint64_t total = RecognizedTotal(rec);
+
+    // Echo what's held, there's no next input to show
+    SDL_RenderTexture(renderer, direction_textures[ gs->curr_input <= UP_BACK ? gs->curr_input : NEUTRAL ], NULL, &next_input_rect);
+
+    if (total != practice_total || (practice_texture == NULL && rec->last_technique >= 0))
+    {
+        practice_total = total;
+        if (practice_texture != NULL)
+            SDL_DestroyTexture(practice_texture);
+        practice_texture = NULL;
+
+        if (rec->last_technique >= 0)
+        {
+            char text[48];
+            SDL_Color textColor = {51, 255, 51};
+            snprintf(text, sizeof(text), "%s %.1f/s", rec->techniques[rec->last_technique].name, TechniqueRate(rec, rec->last_technique));
+
+            SDL_Surface *surface = TTF_RenderText_Solid(score_font, text, strlen(text), textColor);
+            practice_texture = SDL_CreateTextureFromSurface(renderer, surface);
+            SDL_DestroySurface(surface);
+        }
+    }
+
+    if (practice_texture != NULL)
+    {
+        // Natural size along the bottom, squeezed only if it won't fit
+        float w, h;
+        SDL_GetTextureSize(practice_texture, &w, &h);
+        if (w > INITIAL_VIEW_WIDTH - SIDE_PADDING * 2)
+            w = INITIAL_VIEW_WIDTH - SIDE_PADDING * 2;
+
+        SDL_FRect rect = { SIDE_PADDING, INITIAL_VIEW_HEIGHT - ACC_DISPLAY_HEIGHT - VERT_PADDING, w, ACC_DISPLAY_HEIGHT };
+        SDL_RenderTexture(renderer, practice_texture, NULL, &rect);
+    }
+}
+
+void _renderGame(SDL_Renderer *renderer, KbdSession *session) 
+{
+    const GameState *gs = &session->state;
+
     // Clear with transparent background for overlay effect
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
     SDL_RenderClear(renderer);
+
+    if (gs->current_mode->free_practice)
+    {
+        _updateScore(renderer, gs);
+        SDL_RenderTexture(renderer, score_texture, NULL, &score_rect);
+        SDL_RenderTexture(renderer, highscore_texture, NULL, &highscore_rect);
+        _renderPractice(renderer, session);
+        _present(renderer, session);
+        return;
+    }
     
     // Render inputs
-    SDL_Texture *nextInputTexture = direction_textures[ gamestate.current_mode->pattern[ gamestate.player_pos % gamestate.current_mode->pattern_size ] ];
+    SDL_Texture *nextInputTexture = direction_textures[ gs->current_mode->dfa->hint[ gs->player_pos ] ];
     SDL_RenderTexture(renderer, nextInputTexture, NULL, &next_input_rect);
     
     // Render score and high score panel
-    _updateScore(renderer);
+    _updateScore(renderer, gs);
     SDL_RenderTexture(renderer, score_texture, NULL, &score_rect);
     SDL_RenderTexture(renderer, highscore_texture, NULL, &highscore_rect);
     
     // Success fail panel
-    if (gamestate.last_input_acc == FAIL)
+    if (gs->last_input_acc == FAIL)
     {
         // First the arrow on the left
-        SDL_RenderTexture(renderer, direction_textures[ gamestate.last_input ], NULL, &failed_input_rect);
-        SDL_RenderTexture(renderer, acc_textures[ gamestate.last_input_acc ], NULL, &failed_acc_rect);
+        SDL_RenderTexture(renderer, direction_textures[ gs->last_input ], NULL, &failed_input_rect);
+
+        const NearMiss *nm = &session->near_miss;
+        if (nm->diagnosed && nm->last.kind != MISS_UNCLEAR)
+        {
+            // Natural size, these are longer than MISS
+            float w, h;
+            SDL_GetTextureSize(miss_kind_textures[ nm->last.kind ], &w, &h);
+            if (w > INITIAL_VIEW_WIDTH - failed_acc_rect.x - SIDE_PADDING)
+                w = INITIAL_VIEW_WIDTH - failed_acc_rect.x - SIDE_PADDING;
+
+            SDL_FRect rect = { failed_acc_rect.x, failed_acc_rect.y, w, failed_acc_rect.h };
+            SDL_RenderTexture(renderer, miss_kind_textures[ nm->last.kind ], NULL, &rect);
+        }
+        else
+            SDL_RenderTexture(renderer, acc_textures[ gs->last_input_acc ], NULL, &failed_acc_rect);
         
         // SDL_RenderPresent(renderer);
 
@@ -243,11 +353,13 @@ void _renderGame(SDL_Renderer *renderer)
 
         // return;
     }
-    else if (gamestate.last_input_acc != NONE)
+    else if (gs->last_timing != TIMING_NONE)
+        SDL_RenderTexture(renderer, timing_textures[ gs->last_timing ], NULL, &last_input_acc_rect);
+    else if (gs->last_input_acc != NONE)
     {
         /* TODO: Figure out how to display success in a way that doesn't look fucking stupid */
-        //SDL_RenderTexture(renderer, acc_textures[ gamestate.last_input_acc ], NULL, &last_input_acc_rect);
+        //SDL_RenderTexture(renderer, acc_textures[ gs->last_input_acc ], NULL, &last_input_acc_rect);
     }
 
-    SDL_RenderPresent(renderer);
+    _present(renderer, session);
 }
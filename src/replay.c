@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "notation.h"
+#include "replay.h"
+
+void InitReplay(Replay *replay, GameMode *mode, uint64_t highscore)
+{
+    ResetGameState(&replay->state, mode, highscore);
+    replay->prev = NEUTRAL;
+    replay->first_ns = 0;
+
+    ReplaySummary summary = {0};
+    summary.highscore = highscore;
+    replay->summary = summary;
+}
+
+JudgeResult ReplayInput(Replay *replay, const InputEvent *ev)
+{
+    ReplaySummary *summary = &replay->summary;
+
+    if (summary->quit)
+        return JUDGE_NONE;
+
+    ControllerState cs = EventToController(ev);
+
+    if (summary->inputs == 0)
+        replay->first_ns = cs.timestamp_ns;
+    summary->inputs++;
+    summary->duration_ns = cs.timestamp_ns - replay->first_ns;
+
+    bool was_paused = replay->state.in_miss_pause;
+    JudgeResult result = JudgeInput(&replay->state, &replay->prev, &cs);
+
+    if (was_paused && !replay->state.in_miss_pause)
+        summary->resets++;
+
+    switch (result)
+    {
+        case JUDGE_HIT:
+            summary->hits++;
+            summary->timing[replay->state.last_timing]++;
+            break;
+        case JUDGE_MISS:
+            summary->misses++;
+            break;
+        case JUDGE_PAUSED:
+            summary->paused++;
+            break;
+        case JUDGE_QUIT:
+            summary->quit = true;
+            break;
+        default:
+            break;
+    }
+
+    summary->cycles = replay->state.completions;
+    summary->score = replay->state.score;
+    summary->highscore = replay->state.highscore;
+    return result;
+}
+
+void ReplayInputs(Replay *replay, const InputEvent *events, size_t count, JudgeResult *verdicts)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        JudgeResult result = ReplayInput(replay, &events[i]);
+        if (verdicts != NULL)
+            verdicts[i] = result;
+    }
+}
+
+void ReplayRecording(Replay *replay, const RecordingReader *reader, JudgeResult *verdicts)
+{
+    RecordingIter it;
+    InputEvent ev;
+    size_t i = 0;
+
+    BeginRecordingIter(reader, &it);
+    while (NextRecordedInput(&it, &ev))
+    {
+        JudgeResult result = ReplayInput(replay, &ev);
+        if (verdicts != NULL)
+            verdicts[i++] = result;
+    }
+}
+
+bool ReplayPhaseSweep(GameMode *mode, const RecordingReader *reader, PhaseResult *results, int count)
+{
+    Replay *replays = malloc(count * sizeof(Replay));
+    FrameSampler *samplers = malloc(count * sizeof(FrameSampler));
+    if (replays == NULL || samplers == NULL)
+    {
+        printf("Out of memory sweeping %d phases\n", count);
+        free(replays);
+        free(samplers);
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        InitReplay(&replays[i], mode, 0);
+        InitFrameSampler(&samplers[i], SweepPhase(i, count));
+    }
+
+    RecordingIter it;
+    InputEvent ev;
+    InputEvent seen;
+
+    BeginRecordingIter(reader, &it);
+    while (NextRecordedInput(&it, &ev))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (SampleInput(&samplers[i], &ev, &seen))
+                ReplayInput(&replays[i], &seen);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (FlushFrameSampler(&samplers[i], UINT64_MAX, &seen))
+            ReplayInput(&replays[i], &seen);
+
+        results[i].phase_ns = samplers[i].phase_ns;
+        results[i].dropped = samplers[i].dropped;
+        results[i].summary = replays[i].summary;
+    }
+
+    free(replays);
+    free(samplers);
+    return true;
+}
+
+void ReplayPractice(Recognizer *rec, const InputEvent *events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        FeedRecognizer(rec, (GameDirection)events[i].direction, events[i].timestamp_ns);
+}
+
+void ReplayPracticeRecording(Recognizer *rec, const RecordingReader *reader)
+{
+    RecordingIter it;
+    InputEvent ev;
+
+    BeginRecordingIter(reader, &it);
+    while (NextRecordedInput(&it, &ev))
+        FeedRecognizer(rec, (GameDirection)ev.direction, ev.timestamp_ns);
+}
+
+bool GameModeFromRecording(const RecordingHeader *header, GameMode *mode, GameDirection *pattern, PatternDfa *dfa)
+{
+    // Never judged against part of the pattern
+    int size = header->pattern_size;
+    if (size > RECORDING_MAX_PATTERN)
+        return false;
+
+    // Spelled out as notation so it compiles like any other mode
+    char source[RECORDING_MAX_PATTERN * 3 + 1] = "";
+    size_t len = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        pattern[i] = (GameDirection)header->pattern[i];
+        len += snprintf(source + len, sizeof(source) - len, "%s ", DirectionName(pattern[i]));
+    }
+
+    if (!CompilePattern(source, dfa))
+        return false;
+
+    mode->mode_name = header->mode_name;
+    mode->source = NULL;
+    mode->dfa = dfa;
+    mode->pattern = pattern;
+    mode->pattern_size = size;
+    return true;
+}
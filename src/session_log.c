@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "session_log.h"
+
+bool InitSessionLog(SessionLog *log, int capacity, int interval)
+{
+    memset(log, 0, sizeof(*log));
+
+    int size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    log->capacity = size;
+    log->interval = interval > 0 ? interval : SESSION_LOG_DEFAULT_INTERVAL;
+
+    // One more than fits between the oldest kept event and the newest
+    log->snapshot_count = size / log->interval + 2;
+
+    log->events = calloc(size, sizeof(SessionEvent));
+    log->snapshots = calloc(log->snapshot_count, sizeof(SessionSnapshot));
+    if (log->events == NULL || log->snapshots == NULL)
+    {
+        printf("Error allocating the session log\n");
+        DestroySessionLog(log);
+        return false;
+    }
+
+    return true;
+}
+
+void DestroySessionLog(SessionLog *log)
+{
+    free(log->events);
+    free(log->snapshots);
+    memset(log, 0, sizeof(*log));
+}
+
+static SessionSnapshot *_snapshot(const SessionLog *log, uint64_t index)
+{
+    return &log->snapshots[index % log->snapshot_count];
+}
+
+static void _takeSnapshot(SessionLog *log, uint64_t timestamp_ns, const GameState *gs, GameDirection prev)
+{
+    SessionSnapshot *snap = _snapshot(log, log->head / log->interval);
+    snap->seq = log->head;
+    snap->timestamp_ns = timestamp_ns;
+    snap->state = *gs;
+    snap->prev = prev;
+}
+
+void BeginSessionLog(SessionLog *log, const GameState *gs, GameDirection prev, uint64_t start_ns)
+{
+    log->head = 0;
+    _takeSnapshot(log, start_ns, gs, prev);
+}
+
+void LogSessionEvent(SessionLog *log, const SessionEvent *ev, const GameState *gs, GameDirection prev)
+{
+    log->events[log->head & (log->capacity - 1)] = *ev;
+    log->head++;
+
+    if (log->head % log->interval == 0)
+        _takeSnapshot(log, ev->timestamp_ns, gs, prev);
+}
+
+// First snapshot whose events are all still kept
+static uint64_t _firstSnapshot(const SessionLog *log)
+{
+    uint64_t oldest = log->head > (uint64_t)log->capacity ? log->head - log->capacity : 0;
+    return (oldest + log->interval - 1) / log->interval;
+}
+
+uint64_t SessionLogStart(const SessionLog *log)
+{
+    return _snapshot(log, _firstSnapshot(log))->timestamp_ns;
+}
+
+bool RewindSessionLog(const SessionLog *log, uint64_t time_ns, GameState *gs, GameDirection *prev)
+{
+    uint64_t lo = _firstSnapshot(log);
+    uint64_t hi = log->head / log->interval;
+
+    if (log->events == NULL || _snapshot(log, lo)->timestamp_ns > time_ns)
+        return false;
+
+    // Last snapshot at or before time_ns
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (_snapshot(log, mid)->timestamp_ns <= time_ns)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+
+    const SessionSnapshot *snap = _snapshot(log, lo);
+    *gs = snap->state;
+    *prev = snap->prev;
+
+    for (uint64_t seq = snap->seq; seq < log->head; seq++)
+    {
+        const SessionEvent *ev = &log->events[seq & (log->capacity - 1)];
+        if (ev->timestamp_ns > time_ns)
+            break;
+
+        switch (ev->kind)
+        {
+            case SESSION_EVENT_PAUSE_END:
+                EndMissPause(gs);
+                continue;
+            case SESSION_EVENT_DROPPED:
+                gs->last_timing = TIMING_DROPPED;
+                continue;
+            default:
+                break;
+        }
+
+        InputEvent input = { .timestamp_ns = ev->timestamp_ns, .direction = ev->direction, .buttons = ev->buttons };
+        ControllerState cs = EventToController(&input);
+        JudgeInput(gs, prev, &cs);
+    }
+
+    return true;
+}
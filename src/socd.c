@@ -0,0 +1,91 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "socd.h"
+
+uint8_t socd_table[SOCD_POLICY_COUNT][256][16];
+
+static bool socd_tables_ready = false;
+
+static const char *_socdPolicyNames[SOCD_POLICY_COUNT] = {
+    [SOCD_NEUTRAL]     = "neutral",
+    [SOCD_LAST_INPUT]  = "last",
+    [SOCD_FIRST_INPUT] = "first",
+    [SOCD_UP_PRIORITY] = "up"
+};
+
+// Resolve a single axis. Bit 0 is UP/LEFT, bit 1 is DOWN/RIGHT.
+static uint8_t _resolveAxis(SocdPolicy policy, bool vertical, uint8_t prev_raw, uint8_t prev_out, uint8_t raw)
+{
+    if (raw != 3)
+        return raw;
+
+    switch (policy)
+    {
+        case SOCD_LAST_INPUT:
+            // Only one was down last sample, so the other one is the new press
+            if (prev_raw == 1 || prev_raw == 2)
+                return prev_raw ^ 3;
+            // Both were already down, nothing changed
+            if (prev_raw == 3)
+                return prev_out;
+            // Both landed on the same sample, no way to tell
+            return 0;
+
+        case SOCD_FIRST_INPUT:
+            if (prev_raw == 1 || prev_raw == 2)
+                return prev_raw;
+            if (prev_raw == 3)
+                return prev_out;
+            return 0;
+
+        case SOCD_UP_PRIORITY:
+            return vertical ? 1 : 0;
+
+        case SOCD_NEUTRAL:
+        default:
+            return 0;
+    }
+}
+
+void InitSocdTables()
+{
+    if (socd_tables_ready)
+        return;
+
+    for (int policy = 0; policy < SOCD_POLICY_COUNT; policy++)
+    {
+        for (int history = 0; history < 256; history++)
+        {
+            uint8_t prev_raw = history & 0xF;
+            uint8_t prev_out = history >> 4;
+
+            for (int raw = 0; raw < 16; raw++)
+            {
+                // 0011 is the UP/DOWN axis, 1100 is LEFT/RIGHT
+                uint8_t vert = _resolveAxis(policy, true, prev_raw & 3, prev_out & 3, raw & 3);
+                uint8_t horz = _resolveAxis(policy, false, (prev_raw >> 2) & 3, (prev_out >> 2) & 3, (raw >> 2) & 3);
+
+                socd_table[policy][history][raw] = (uint8_t)(vert | (horz << 2));
+            }
+        }
+    }
+
+    socd_tables_ready = true;
+}
+
+void InitSocdState(SocdState *state, SocdPolicy policy)
+{
+    InitSocdTables();
+
+    state->policy = policy;
+    state->history = 0;
+}
+
+const char *SocdPolicyName(SocdPolicy policy)
+{
+    if (policy < 0 || policy >= SOCD_POLICY_COUNT)
+        return "unknown";
+
+    return _socdPolicyNames[policy];
+}
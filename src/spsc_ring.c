@@ -0,0 +1,77 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "spsc_ring.h"
+
+void InitSpscRing(SpscRing *ring, void *items, size_t item_size, Uint32 capacity)
+{
+    memset(ring, 0, sizeof(SpscRing));
+    ring->items = items;
+    ring->item_size = item_size;
+    ring->capacity = capacity;
+}
+
+bool PushSpscRing(SpscRing *ring, const void *item)
+{
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+
+    // Full, the consumer hasn't caught up yet
+    if (head - tail >= ring->capacity)
+    {
+        SDL_AddAtomicInt(&ring->dropped, 1);
+        return false;
+    }
+
+    memcpy(ring->items + (size_t)(head & (ring->capacity - 1)) * ring->item_size, item, ring->item_size);
+
+    // Publish the slot before moving head past it
+    SDL_MemoryBarrierRelease();
+    SDL_SetAtomicInt(&ring->head, (int)(head + 1));
+
+    return true;
+}
+
+const void *PeekSpscRing(SpscRing *ring)
+{
+    Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+
+    if (head == tail)
+        return NULL;
+
+    SDL_MemoryBarrierAcquire();
+    return ring->items + (size_t)(tail & (ring->capacity - 1)) * ring->item_size;
+}
+
+void ReleaseSpscRing(SpscRing *ring)
+{
+    SDL_SetAtomicInt(&ring->tail, SDL_GetAtomicInt(&ring->tail) + 1);
+}
+
+bool PopSpscRing(SpscRing *ring, void *item)
+{
+    const void *slot = PeekSpscRing(ring);
+    if (slot == NULL)
+        return false;
+
+    memcpy(item, slot, ring->item_size);
+    ReleaseSpscRing(ring);
+
+    return true;
+}
+
+bool SpscRingFull(SpscRing *ring)
+{
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&ring->head);
+    Uint32 tail = (Uint32)SDL_GetAtomicInt(&ring->tail);
+
+    return head - tail >= ring->capacity;
+}
+
+int SpscRingDropped(SpscRing *ring)
+{
+    return SDL_GetAtomicInt(&ring->dropped);
+}
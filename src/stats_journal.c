@@ -0,0 +1,404 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "spsc_ring.h"
+#include "stats_journal.h"
+#include "writer_thread.h"
+
+typedef struct {
+    StatsEntry *entries;
+    int count;
+    int capacity;
+} StatsTable;
+
+struct StatsJournal {
+    char path[512];
+    FILE *file;
+
+    // As the file was at open, read only after
+    StatsTable loaded;
+
+    SpscRing queue;
+    StatsEntry queued[STATS_JOURNAL_QUEUE];
+    WriterThread thread;
+
+    // Writer thread only, what a compaction writes out. Once an entry
+    // couldn't be folded in it's short of that game until the next open,
+    // which reads every entry back from the file.
+    StatsTable summary;
+    bool summary_short;
+    int entries;
+};
+
+static uint32_t _crc32(const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    uint32_t crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+static uint32_t _entryChecksum(const StatsEntry *entry)
+{
+    return _crc32((const char *)entry + sizeof(entry->checksum), sizeof(StatsEntry) - sizeof(entry->checksum));
+}
+
+static bool _fold(StatsTable *table, const StatsEntry *entry)
+{
+    StatsEntry *sum = NULL;
+    for (int i = 0; i < table->count && sum == NULL; i++)
+    {
+        if (strncmp(table->entries[i].mode_name, entry->mode_name, STATS_NAME_SIZE) == 0)
+            sum = &table->entries[i];
+    }
+
+    if (sum == NULL)
+    {
+        if (table->count == table->capacity)
+        {
+            int capacity = table->capacity > 0 ? table->capacity * 2 : 16;
+            StatsEntry *grown = realloc(table->entries, capacity * sizeof(StatsEntry));
+            if (grown == NULL)
+                return false;
+
+            table->entries = grown;
+            table->capacity = capacity;
+        }
+
+        sum = &table->entries[table->count++];
+        memset(sum, 0, sizeof(*sum));
+        sum->kind = STATS_ENTRY_SUMMARY;
+        memcpy(sum->mode_name, entry->mode_name, STATS_NAME_SIZE);
+    }
+
+    sum->games += entry->games;
+    sum->completions += entry->completions;
+    sum->play_ns += entry->play_ns;
+    if (entry->highscore > sum->highscore)
+        sum->highscore = entry->highscore;
+    if (entry->last_played > sum->last_played)
+        sum->last_played = entry->last_played;
+
+    return true;
+}
+
+static bool _copyTable(StatsTable *to, const StatsTable *from)
+{
+    memset(to, 0, sizeof(*to));
+    if (from->count == 0)
+        return true;
+
+    to->entries = malloc(from->count * sizeof(StatsEntry));
+    if (to->entries == NULL)
+        return false;
+
+    memcpy(to->entries, from->entries, from->count * sizeof(StatsEntry));
+    to->count = to->capacity = from->count;
+    return true;
+}
+
+// Down to the disk, not just the OS
+static bool _sync(FILE *file)
+{
+    if (fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+static bool _truncate(FILE *file, long size)
+{
+    fflush(file);
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), size) == 0;
+#else
+    return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+#ifndef _WIN32
+// A rename is only durable once the directory holding it is
+static bool _syncDirectory(const char *path)
+{
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+
+    char *slash = strrchr(dir, '/');
+    if (slash == dir)
+        slash[1] = '\0';
+    else if (slash != NULL)
+        *slash = '\0';
+    else
+        snprintf(dir, sizeof(dir), ".");
+
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+#endif
+
+static bool _writeHeader(FILE *file)
+{
+    StatsJournalHeader header = {0};
+    memcpy(header.magic, STATS_JOURNAL_MAGIC, 4);
+    header.version = STATS_JOURNAL_VERSION;
+    header.entry_size = sizeof(StatsEntry);
+
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+// Every entry up to the first that's cut short or fails its checksum.
+// The file is left positioned for appending after the last good one.
+static bool _load(StatsJournal *journal)
+{
+    FILE *file = journal->file;
+
+    StatsJournalHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1)
+    {
+        // Empty, a crash right after creating it
+        rewind(file);
+        return _writeHeader(file) && _sync(file);
+    }
+
+    if (memcmp(header.magic, STATS_JOURNAL_MAGIC, 4) != 0
+        || header.version != STATS_JOURNAL_VERSION
+        || header.entry_size != sizeof(StatsEntry))
+    {
+        printf("%s is not a stats journal this version can read\n", journal->path);
+        return false;
+    }
+
+    long good = sizeof(header);
+    StatsEntry entry;
+    while (fread(&entry, sizeof(entry), 1, file) == 1)
+    {
+        if (entry.checksum != _entryChecksum(&entry)
+            || (entry.kind != STATS_ENTRY_GAME && entry.kind != STATS_ENTRY_SUMMARY))
+            break;
+
+        if (!_fold(&journal->loaded, &entry))
+            return false;
+
+        journal->entries++;
+        good += sizeof(entry);
+    }
+
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) != good)
+    {
+        printf("%s ends in a torn entry, dropping it\n", journal->path);
+        if (!_truncate(file, good))
+            return false;
+    }
+
+    return fseek(file, good, SEEK_SET) == 0;
+}
+
+// One summary per mode into a new file that replaces the journal whole,
+// a crash at any point leaves either the old journal or the new one
+static void _compact(StatsJournal *journal)
+{
+    char tmp[sizeof(journal->path) + 4];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", journal->path);
+
+    FILE *file = fopen(tmp, "w+b");
+    if (file == NULL)
+        return;
+
+    bool ok = _writeHeader(file);
+    for (int i = 0; i < journal->summary.count && ok; i++)
+    {
+        StatsEntry *sum = &journal->summary.entries[i];
+        sum->checksum = _entryChecksum(sum);
+        ok = fwrite(sum, sizeof(StatsEntry), 1, file) == 1;
+    }
+
+    if (!ok || !_sync(file))
+    {
+        fclose(file);
+        remove(tmp);
+        return;
+    }
+
+    fclose(file);
+    fclose(journal->file);
+
+#ifdef _WIN32
+    ok = MoveFileExA(tmp, journal->path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = rename(tmp, journal->path) == 0;
+    if (ok && !_syncDirectory(journal->path))
+        printf("Error syncing the directory of stats journal %s\n", journal->path);
+#endif
+
+    if (ok)
+        journal->entries = journal->summary.count;
+    else
+        remove(tmp);
+
+    journal->file = fopen(journal->path, "r+b");
+    if (journal->file != NULL)
+        fseek(journal->file, 0, SEEK_END);
+}
+
+static void _writeEntry(void *user, const void *item)
+{
+    StatsJournal *journal = user;
+    const StatsEntry *entry = item;
+
+    // Still written, so the game isn't lost, just not compacted over
+    if (!journal->summary_short && !_fold(&journal->summary, entry))
+    {
+        printf("Out of memory summing stats, not compacting %s until it's opened again\n", journal->path);
+        journal->summary_short = true;
+    }
+
+    if (journal->file != NULL)
+        fwrite(entry, sizeof(StatsEntry), 1, journal->file);
+}
+
+// Everything that queued up since the last pass shares one fsync
+static void _commitEntries(void *user, int items)
+{
+    StatsJournal *journal = user;
+
+    if (items > 0 && journal->file != NULL)
+    {
+        if (!_sync(journal->file))
+            printf("Error writing stats journal %s\n", journal->path);
+        journal->entries += items;
+    }
+
+    if (!journal->summary_short && journal->entries > journal->summary.count + STATS_JOURNAL_COMPACT_AT)
+        _compact(journal);
+}
+
+static void _freeJournal(StatsJournal *journal)
+{
+    if (journal->file != NULL)
+        fclose(journal->file);
+    free(journal->loaded.entries);
+    free(journal->summary.entries);
+    free(journal);
+}
+
+StatsJournal *OpenStatsJournal(const char *path)
+{
+    StatsJournal *journal = calloc(1, sizeof(StatsJournal));
+    if (journal == NULL)
+        return NULL;
+
+    snprintf(journal->path, sizeof(journal->path), "%s", path != NULL ? path : STATS_JOURNAL_DEFAULT_PATH);
+
+    journal->file = fopen(journal->path, "r+b");
+    if (journal->file == NULL)
+        journal->file = fopen(journal->path, "w+b");
+
+    if (journal->file == NULL)
+    {
+        printf("Error opening stats journal %s\n", journal->path);
+        free(journal);
+        return NULL;
+    }
+
+    if (!_load(journal) || !_copyTable(&journal->summary, &journal->loaded))
+    {
+        _freeJournal(journal);
+        return NULL;
+    }
+
+    InitSpscRing(&journal->queue, journal->queued, sizeof(StatsEntry), STATS_JOURNAL_QUEUE);
+
+    if (!StartWriterThread(&journal->thread, "KBDStats", &journal->queue, STATS_JOURNAL_COMMIT_MS,
+                           _writeEntry, _commitEntries, journal))
+    {
+        _freeJournal(journal);
+        return NULL;
+    }
+
+    return journal;
+}
+
+void CloseStatsJournal(StatsJournal *journal)
+{
+    if (journal == NULL)
+        return;
+
+    StopWriterThread(&journal->thread);
+
+    int dropped = SpscRingDropped(&journal->queue);
+    if (dropped > 0)
+        printf("Stats journal dropped %d games\n", dropped);
+
+    _freeJournal(journal);
+}
+
+bool FindStats(const StatsJournal *journal, const char *mode_name, StatsEntry *out)
+{
+    if (journal == NULL || mode_name == NULL)
+        return false;
+
+    // Cut down the way JournalGame() stores it
+    char key[STATS_NAME_SIZE];
+    snprintf(key, sizeof(key), "%s", mode_name);
+
+    for (int i = 0; i < journal->loaded.count; i++)
+    {
+        if (strncmp(journal->loaded.entries[i].mode_name, key, STATS_NAME_SIZE) == 0)
+        {
+            *out = journal->loaded.entries[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JournalGame(StatsJournal *journal, const char *mode_name, uint64_t highscore, uint64_t completions, uint64_t play_ns)
+{
+    if (journal == NULL)
+        return;
+
+    StatsEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.kind = STATS_ENTRY_GAME;
+    snprintf(entry.mode_name, STATS_NAME_SIZE, "%s", mode_name != NULL ? mode_name : "");
+    entry.games = 1;
+    entry.highscore = highscore;
+    entry.completions = completions;
+    entry.play_ns = play_ns;
+    entry.last_played = (int64_t)time(NULL);
+    entry.checksum = _entryChecksum(&entry);
+
+    // Never waits on the writer, nobody finishes 64 games inside one
+    // commit window
+    PushSpscRing(&journal->queue, &entry);
+}
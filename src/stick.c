@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stick.h"
+
+static const char *_stickGateNames[STICK_GATE_COUNT] = {
+    [STICK_GATE_OFF]     = "off",
+    [STICK_GATE_OCTAGON] = "octagon",
+    [STICK_GATE_SQUARE]  = "square"
+};
+
+// 0001 is UP, 0010 is DOWN, 0100 is LEFT, 1000 is RIGHT
+// Sectors start at RIGHT and go counter clockwise
+static const uint8_t _octagonSectors[8] = {
+    0x8,    // RIGHT
+    0x9,    // UP RIGHT
+    0x1,    // UP
+    0x5,    // UP LEFT
+    0x4,    // LEFT
+    0x6,    // DOWN LEFT
+    0x2,    // DOWN
+    0xA     // DOWN RIGHT
+};
+
+// Only ever runs when the table is built, never per sample
+static uint8_t _quantize(StickGateShape shape, float deadzone, float x, float y)
+{
+    switch (shape)
+    {
+        case STICK_GATE_OCTAGON:
+        {
+            if (x * x + y * y < deadzone * deadzone)
+                return 0;
+
+            // SDL's Y axis points down, sectors are 45 degrees wide
+            float angle = atan2f(-y, x);
+            int sector = (int)floorf(angle / 0.78539816f + 0.5f);
+            return _octagonSectors[(sector + 8) % 8];
+        }
+
+        case STICK_GATE_SQUARE:
+        {
+            uint8_t mask = 0;
+            mask |= 1 * (y < -deadzone);
+            mask |= 2 * (y > deadzone);
+            mask |= 4 * (x < -deadzone);
+            mask |= 8 * (x > deadzone);
+            return mask;
+        }
+
+        case STICK_GATE_OFF:
+        default:
+            return 0;
+    }
+}
+
+bool InitStickGate(StickGate *gate, StickGateShape shape, float deadzone, int bits)
+{
+    gate->shape = shape;
+    gate->deadzone = deadzone;
+    gate->bits = bits;
+    gate->table = NULL;
+
+    if (shape == STICK_GATE_OFF)
+        return true;
+
+    if (bits < 2 || bits > 12)
+    {
+        printf("Stick table resolution must be 2-12 bits, got %d\n", bits);
+        return false;
+    }
+
+    int side = 1 << bits;
+    gate->table = malloc((size_t)side * side);
+    if (gate->table == NULL)
+        return false;
+
+    for (int iy = 0; iy < side; iy++)
+    {
+        for (int ix = 0; ix < side; ix++)
+        {
+            // Sample the middle of each cell, mapped back to -1..1
+            float x = ((ix + 0.5f) / side) * 2.0f - 1.0f;
+            float y = ((iy + 0.5f) / side) * 2.0f - 1.0f;
+
+            gate->table[iy * side + ix] = _quantize(shape, deadzone, x, y);
+        }
+    }
+
+    return true;
+}
+
+void DestroyStickGate(StickGate *gate)
+{
+    free(gate->table);
+    gate->table = NULL;
+}
+
+const char *StickGateName(StickGateShape shape)
+{
+    if (shape < 0 || shape >= STICK_GATE_COUNT)
+        return "unknown";
+
+    return _stickGateNames[shape];
+}
+
+void QuantizeStickTrace(const StickGate *gate, const int16_t *xy, size_t count, uint8_t *out)
+{
+    for (size_t i = 0; i < count; i++)
+        out[i] = QuantizeStick(gate, xy[i * 2], xy[i * 2 + 1]);
+}
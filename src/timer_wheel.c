@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "timer_wheel.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define LEVEL_BITS 6
+
+static int _lowestBit(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, v);
+    return (int)bit;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static int _slotAt(uint64_t tick, int level)
+{
+    return (int)((tick >> (level * LEVEL_BITS)) & (TIMER_SLOTS - 1));
+}
+
+static void _link(TimerWheel *wheel, Timer *timer)
+{
+    uint64_t tick = timer->deadline_ns / TIMER_TICK_NS;
+    if (tick < wheel->tick)
+        tick = wheel->tick;
+
+    // Highest 6 bit group where it differs from now
+    int level = 0;
+    for (uint64_t diff = (tick ^ wheel->tick) >> LEVEL_BITS; diff != 0; diff >>= LEVEL_BITS)
+        level++;
+
+    int slot = _slotAt(tick, level);
+    Timer **head = &wheel->slots[level][slot];
+
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL)
+        (*head)->prev = timer;
+    *head = timer;
+
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+static void _unlink(TimerWheel *wheel, Timer *timer)
+{
+    if (timer->prev != NULL)
+        timer->prev->next = timer->next;
+    else
+        wheel->slots[timer->level][timer->slot] = timer->next;
+
+    if (timer->next != NULL)
+        timer->next->prev = timer->prev;
+
+    if (wheel->slots[timer->level][timer->slot] == NULL)
+        wheel->occupied[timer->level] &= ~(1ULL << timer->slot);
+
+    timer->prev = NULL;
+    timer->next = NULL;
+}
+
+// The wheel just reached these slots, spread what's in them over the
+// levels below
+static void _cascade(TimerWheel *wheel)
+{
+    for (int level = TIMER_LEVELS - 1; level > 0; level--)
+    {
+        int slot = _slotAt(wheel->tick, level);
+        if (!(wheel->occupied[level] & (1ULL << slot)))
+            continue;
+
+        Timer *timer = wheel->slots[level][slot];
+        wheel->slots[level][slot] = NULL;
+        wheel->occupied[level] &= ~(1ULL << slot);
+
+        while (timer != NULL)
+        {
+            Timer *next = timer->next;
+            _link(wheel, timer);
+            timer = next;
+        }
+    }
+}
+
+// First tick after the current one that has a slot to look at
+static uint64_t _nextTick(const TimerWheel *wheel, uint64_t limit)
+{
+    uint64_t next = limit;
+
+    for (int level = 0; level < TIMER_LEVELS; level++)
+    {
+        int shift = level * LEVEL_BITS;
+        int slot = _slotAt(wheel->tick, level);
+        uint64_t later = slot == TIMER_SLOTS - 1 ? 0 : wheel->occupied[level] & (~0ULL << (slot + 1));
+        if (later == 0)
+            continue;
+
+        // Start of that slot, higher groups as they are now
+        uint64_t above = shift + LEVEL_BITS < 64 ? wheel->tick >> (shift + LEVEL_BITS) << (shift + LEVEL_BITS) : 0;
+        uint64_t start = above | ((uint64_t)_lowestBit(later) << shift);
+        if (start < next)
+            next = start;
+
+        // Anything on a higher level starts after this one
+        break;
+    }
+
+    return next;
+}
+
+void InitTimerWheel(TimerWheel *wheel, uint64_t now_ns)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->tick = now_ns / TIMER_TICK_NS;
+}
+
+void InitTimer(Timer *timer, TimerCallback fire, void *user)
+{
+    memset(timer, 0, sizeof(*timer));
+    timer->fire = fire;
+    timer->user = user;
+}
+
+void ScheduleTimer(TimerWheel *wheel, Timer *timer, uint64_t deadline_ns)
+{
+    if (timer->armed)
+        _unlink(wheel, timer);
+
+    timer->deadline_ns = deadline_ns;
+    timer->armed = true;
+    _link(wheel, timer);
+}
+
+void CancelTimer(TimerWheel *wheel, Timer *timer)
+{
+    if (!timer->armed)
+        return;
+
+    _unlink(wheel, timer);
+    timer->armed = false;
+}
+
+int RunTimers(TimerWheel *wheel, uint64_t now_ns)
+{
+    uint64_t target = now_ns / TIMER_TICK_NS;
+    int fired = 0;
+
+    if (target < wheel->tick)
+        return 0;
+
+    for (;;)
+    {
+        // Everything in the current tick's slot is due unless it's the
+        // last tick, where the deadlines can still be later in the tick.
+        // Callbacks can change the list, so start over after each one.
+        Timer *timer = wheel->slots[0][_slotAt(wheel->tick, 0)];
+        while (timer != NULL)
+        {
+            if (timer->deadline_ns > now_ns)
+            {
+                timer = timer->next;
+                continue;
+            }
+
+            _unlink(wheel, timer);
+            timer->armed = false;
+            timer->fire(timer->user, timer->deadline_ns);
+            fired++;
+
+            timer = wheel->slots[0][_slotAt(wheel->tick, 0)];
+        }
+
+        if (wheel->tick == target)
+            return fired;
+
+        wheel->tick = _nextTick(wheel, target);
+        _cascade(wheel);
+    }
+}
@@ -0,0 +1,212 @@
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "work_pool.h"
+
+#define WORK_POOL_MAX_WORKERS 256
+
+// Items a worker still owns. The owner takes from begin, thieves cut
+// from end, both under the lock. Held for a few instructions, so a
+// spinlock beats anything that sleeps.
+typedef struct {
+    SDL_SpinLock lock;
+    size_t begin;
+    size_t end;
+
+    // Own cache line, workers hammer their own slot
+    char pad[64 - sizeof(SDL_SpinLock) - 2 * sizeof(size_t)];
+} WorkRange;
+
+typedef struct {
+    WorkPool *pool;
+    int index;
+    SDL_Thread *thread;
+} Worker;
+
+struct WorkPool {
+    WorkPoolFn fn;
+    void *ctx;
+    size_t count;
+
+    int worker_count;
+    Worker *workers;
+    WorkRange *ranges;
+
+    SDL_AtomicInt done;
+    SDL_AtomicInt steals;
+    SDL_AtomicInt running;
+};
+
+static bool _takeOwn(WorkRange *range, size_t *item)
+{
+    bool ok = false;
+
+    SDL_LockSpinlock(&range->lock);
+    if (range->begin < range->end)
+    {
+        *item = range->begin++;
+        ok = true;
+    }
+    SDL_UnlockSpinlock(&range->lock);
+
+    return ok;
+}
+
+// Moves the back half of some other worker's items into ours
+static bool _steal(WorkPool *pool, int thief)
+{
+    for (int i = 1; i < pool->worker_count; i++)
+    {
+        WorkRange *victim = &pool->ranges[(thief + i) % pool->worker_count];
+        size_t begin = 0;
+        size_t end = 0;
+
+        SDL_LockSpinlock(&victim->lock);
+        size_t left = victim->end - victim->begin;
+        if (left > 0)
+        {
+            end = victim->end;
+            begin = end - (left + 1) / 2;
+            victim->end = begin;
+        }
+        SDL_UnlockSpinlock(&victim->lock);
+
+        if (end == begin)
+            continue;
+
+        WorkRange *own = &pool->ranges[thief];
+        SDL_LockSpinlock(&own->lock);
+        own->begin = begin;
+        own->end = end;
+        SDL_UnlockSpinlock(&own->lock);
+
+        SDL_AddAtomicInt(&pool->steals, 1);
+        return true;
+    }
+
+    return false;
+}
+
+static int _workerMain(void *data)
+{
+    Worker *worker = data;
+    WorkPool *pool = worker->pool;
+    WorkRange *own = &pool->ranges[worker->index];
+    size_t item;
+
+    // Nothing is ever added, so once every range is empty we're done
+    for (;;)
+    {
+        while (_takeOwn(own, &item))
+        {
+            pool->fn(pool->ctx, worker->index, item);
+            SDL_AddAtomicInt(&pool->done, 1);
+        }
+
+        if (!_steal(pool, worker->index))
+            break;
+    }
+
+    SDL_AddAtomicInt(&pool->running, -1);
+    return 0;
+}
+
+WorkPool *StartWorkPool(int workers, size_t count, WorkPoolFn fn, void *ctx)
+{
+    if (workers <= 0)
+        workers = SDL_GetNumLogicalCPUCores();
+    if (workers <= 0)
+        workers = 1;
+    if (workers > WORK_POOL_MAX_WORKERS)
+        workers = WORK_POOL_MAX_WORKERS;
+
+    WorkPool *pool = calloc(1, sizeof(WorkPool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->worker_count = workers;
+    pool->workers = calloc(workers, sizeof(Worker));
+    pool->ranges = calloc(workers, sizeof(WorkRange));
+
+    if (pool->workers == NULL || pool->ranges == NULL)
+    {
+        free(pool->workers);
+        free(pool->ranges);
+        free(pool);
+        return NULL;
+    }
+
+    // Even slices up front, stealing evens out the rest
+    for (int i = 0; i < workers; i++)
+    {
+        pool->ranges[i].begin = count * i / workers;
+        pool->ranges[i].end = count * (i + 1) / workers;
+    }
+
+    SDL_SetAtomicInt(&pool->running, workers);
+
+    for (int i = 0; i < workers; i++)
+    {
+        Worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i;
+        worker->thread = SDL_CreateThread(_workerMain, "KBDWorker", worker);
+
+        // The others steal its share
+        if (worker->thread == NULL)
+        {
+            printf("Error starting worker %d: %s\n", i, SDL_GetError());
+            SDL_AddAtomicInt(&pool->running, -1);
+        }
+    }
+
+    // No threads at all, worker 0 steals everything on this one
+    if (SDL_GetAtomicInt(&pool->running) == 0)
+    {
+        SDL_SetAtomicInt(&pool->running, 1);
+        _workerMain(&pool->workers[0]);
+    }
+
+    return pool;
+}
+
+void FinishWorkPool(WorkPool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    for (int i = 0; i < pool->worker_count; i++)
+    {
+        if (pool->workers[i].thread != NULL)
+            SDL_WaitThread(pool->workers[i].thread, NULL);
+    }
+
+    free(pool->workers);
+    free(pool->ranges);
+    free(pool);
+}
+
+int WorkPoolWorkers(const WorkPool *pool)
+{
+    return pool->worker_count;
+}
+
+size_t WorkPoolDone(const WorkPool *pool)
+{
+    return (size_t)(unsigned)SDL_GetAtomicInt((SDL_AtomicInt *)&pool->done);
+}
+
+bool WorkPoolIdle(const WorkPool *pool)
+{
+    return SDL_GetAtomicInt((SDL_AtomicInt *)&pool->running) == 0;
+}
+
+uint64_t WorkPoolSteals(const WorkPool *pool)
+{
+    return (uint64_t)(unsigned)SDL_GetAtomicInt((SDL_AtomicInt *)&pool->steals);
+}
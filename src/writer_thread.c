@@ -0,0 +1,68 @@
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "writer_thread.h"
+
+static int _writerThreadMain(void *data)
+{
+    WriterThread *writer = data;
+
+    for (;;)
+    {
+        // Read the flag first so nothing queued before stopping is lost
+        bool running = SDL_GetAtomicInt(&writer->running) != 0;
+
+        int items = 0;
+        const void *item;
+        while ((item = PeekSpscRing(writer->queue)) != NULL)
+        {
+            writer->item(writer->user, item);
+            ReleaseSpscRing(writer->queue);
+            items++;
+        }
+
+        if (writer->pass != NULL)
+            writer->pass(writer->user, items);
+
+        if (!running)
+            break;
+
+        SDL_Delay(writer->interval_ms);
+    }
+
+    return 0;
+}
+
+bool StartWriterThread(WriterThread *writer, const char *name, SpscRing *queue, int interval_ms,
+                       WriterItemFn item, WriterPassFn pass, void *user)
+{
+    writer->queue = queue;
+    writer->interval_ms = interval_ms;
+    writer->item = item;
+    writer->pass = pass;
+    writer->user = user;
+
+    SDL_SetAtomicInt(&writer->running, 1);
+
+    writer->thread = SDL_CreateThread(_writerThreadMain, name, writer);
+    if (writer->thread == NULL)
+    {
+        printf("Error starting %s thread: %s\n", name, SDL_GetError());
+        SDL_SetAtomicInt(&writer->running, 0);
+        return false;
+    }
+
+    return true;
+}
+
+void StopWriterThread(WriterThread *writer)
+{
+    if (writer->thread == NULL)
+        return;
+
+    SDL_SetAtomicInt(&writer->running, 0);
+    SDL_WaitThread(writer->thread, NULL);
+    writer->thread = NULL;
+}
@@ -0,0 +1,115 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <linux/input.h>
+
+#include "input.h"
+#include "input_ring.h"
+#include "input_evdev.h"
+
+// Drives the evdev decoder from a recorded byte stream, no device needed
+
+#define CLOCK_OFFSET_NS 500
+
+static int failures = 0;
+
+static struct input_event _event(int sec, int usec, int type, int code, int value)
+{
+    struct input_event ie;
+    memset(&ie, 0, sizeof(ie));
+    ie.input_event_sec = sec;
+    ie.input_event_usec = usec;
+    ie.type = (unsigned short)type;
+    ie.code = (unsigned short)code;
+    ie.value = value;
+    return ie;
+}
+
+static void _expect(InputRing *ring, uint64_t timestamp_ns, GameDirection direction, uint8_t buttons)
+{
+    InputEvent ev;
+    if (!PopInputEvent(ring, &ev))
+    {
+        printf("FAIL: expected an event at %llu, ring is empty\n", (unsigned long long)timestamp_ns);
+        failures++;
+        return;
+    }
+
+    if (ev.timestamp_ns != timestamp_ns || ev.direction != direction || ev.buttons != buttons)
+    {
+        printf("FAIL: got %llu dir %d buttons %d, expected %llu dir %d buttons %d\n",
+               (unsigned long long)ev.timestamp_ns, ev.direction, ev.buttons,
+               (unsigned long long)timestamp_ns, direction, buttons);
+        failures++;
+    }
+}
+
+int main()
+{
+    InitSocdTables();
+
+    static InputRing ring;
+    InitInputRing(&ring);
+
+    EvdevDecoder dec;
+    InitEvdevDecoder(&dec, CLOCK_OFFSET_NS, SOCD_NEUTRAL);
+
+    const struct input_event capture[] = {
+        // Keyboard right
+        _event(1, 100, EV_KEY, KEY_D, 1),
+        _event(1, 100, EV_SYN, SYN_REPORT, 0),
+        // Hat down on top of it
+        _event(1, 2000, EV_ABS, ABS_HAT0Y, 1),
+        _event(1, 2000, EV_SYN, SYN_REPORT, 0),
+        // Autorepeat changes nothing
+        _event(1, 3000, EV_KEY, KEY_D, 2),
+        _event(1, 3000, EV_SYN, SYN_REPORT, 0),
+        // Swapping to another key for the same direction in one report
+        _event(1, 4000, EV_KEY, KEY_D, 0),
+        _event(1, 4000, EV_KEY, KEY_RIGHT, 1),
+        _event(1, 4000, EV_SYN, SYN_REPORT, 0),
+        // Hat back to center, select down
+        _event(1, 5000, EV_ABS, ABS_HAT0Y, 0),
+        _event(1, 5000, EV_KEY, BTN_SOUTH, 1),
+        _event(1, 5000, EV_SYN, SYN_REPORT, 0),
+        // Left and right together resolve to neutral
+        _event(1, 6000, EV_KEY, KEY_A, 1),
+        _event(1, 6000, EV_SYN, SYN_REPORT, 0),
+        // Kernel overran, everything is let go
+        _event(2, 0, EV_SYN, SYN_DROPPED, 0),
+        _event(2, 10, EV_KEY, BTN_EAST, 1),
+        _event(2, 10, EV_SYN, SYN_REPORT, 0),
+    };
+
+    // A record cut short at the end must be ignored
+    unsigned char bytes[sizeof(capture) + sizeof(struct input_event) / 2];
+    memset(bytes, 0xAB, sizeof(bytes));
+    memcpy(bytes, capture, sizeof(capture));
+
+    int pushed = DecodeEvdevBytes(&dec, bytes, sizeof(bytes), &ring);
+    if (pushed != 5)
+    {
+        printf("FAIL: %d transitions pushed, expected 5\n", pushed);
+        failures++;
+    }
+
+    _expect(&ring, 1000100000ULL + CLOCK_OFFSET_NS, FORWARD, 0);
+    _expect(&ring, 1002000000ULL + CLOCK_OFFSET_NS, DOWN_FORWARD, 0);
+    _expect(&ring, 1005000000ULL + CLOCK_OFFSET_NS, FORWARD, INPUT_BUTTON_SELECT);
+    _expect(&ring, 1006000000ULL + CLOCK_OFFSET_NS, NEUTRAL, INPUT_BUTTON_SELECT);
+    _expect(&ring, 2000010000ULL + CLOCK_OFFSET_NS, NEUTRAL, INPUT_BUTTON_BACK);
+
+    InputEvent extra;
+    if (PopInputEvent(&ring, &extra))
+    {
+        printf("FAIL: unexpected event at %llu\n", (unsigned long long)extra.timestamp_ns);
+        failures++;
+    }
+
+    if (failures > 0)
+        return 1;
+
+    printf("evdev decoder OK\n");
+    return 0;
+}
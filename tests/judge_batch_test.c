@@ -0,0 +1,179 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "judge_batch.h"
+#include "modes.h"
+#include "replay.h"
+
+// Judges the same generated recordings with ReplayInput() and with
+// JudgeBatch on every kernel this CPU has, every count has to match
+
+// Not a multiple of JUDGE_BATCH_ALIGN, so some lanes are only padding
+#define RECORDINGS 21
+#define MAX_INPUTS 3000
+
+static const char MODES[] =
+    "[modes]\n"
+    "KBD = (b n b db):1-3\n"
+    "Electric = f n d df:1\n"
+    "Sidestep Cancel = (u|d) n (f|b)\n"
+    "Hold = b:2-4 n db:1-3 n\n"
+    "Dash = f n f{2,3}\n";
+
+static int failures = 0;
+static uint32_t seed = 1;
+
+static uint32_t _random(uint32_t range)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) % range;
+}
+
+typedef struct {
+    InputEvent events[MAX_INPUTS];
+    size_t count;
+    ReplaySummary expected;
+} Recording;
+
+// Mostly the input the pattern wants next, held for anything from under a
+// frame to past the 32 bit split, and judged with ReplayInput() as it goes
+static void _generate(Recording *rec, GameMode *mode, uint64_t start_ns)
+{
+    Replay replay;
+    InitReplay(&replay, mode, 0);
+
+    rec->count = _random(MAX_INPUTS);
+    uint64_t t = start_ns;
+
+    for (size_t i = 0; i < rec->count; i++)
+    {
+        uint32_t hold = _random(100);
+        if (hold < 5)
+            t += 2000000;
+        else if (hold < 85)
+            t += 10000000 + _random(60000000);
+        else if (hold < 98)
+            t += 400000000 + _random(800000000);
+        else
+            t += 5000000000ULL;
+
+        InputEvent *ev = &rec->events[i];
+        ev->timestamp_ns = t;
+        ev->direction = _random(10) < 8 ? mode->dfa->hint[replay.state.player_pos] : (uint8_t)_random(UNKNOWN);
+        ev->buttons = _random(1000) == 0 ? INPUT_BUTTON_BACK : 0;
+
+        ReplayInput(&replay, ev);
+    }
+
+    rec->expected = replay.summary;
+}
+
+static void _compare(const char *mode, JudgeKernel kernel, int lane, const ReplaySummary *got, const ReplaySummary *want)
+{
+    bool same = got->inputs == want->inputs && got->hits == want->hits && got->misses == want->misses
+        && got->paused == want->paused && got->resets == want->resets && got->cycles == want->cycles
+        && got->score == want->score && got->highscore == want->highscore && got->quit == want->quit;
+
+    for (int v = 0; v < TIMING_COUNT; v++)
+        same = same && got->timing[v] == want->timing[v];
+
+    if (!same)
+    {
+        printf("FAIL: %s lane %d on %s: %llu hits %llu misses %llu cycles score %llu, replay has %llu %llu %llu %llu\n",
+               mode, lane, JudgeKernelName(kernel),
+               (unsigned long long)got->hits, (unsigned long long)got->misses,
+               (unsigned long long)got->cycles, (unsigned long long)got->score,
+               (unsigned long long)want->hits, (unsigned long long)want->misses,
+               (unsigned long long)want->cycles, (unsigned long long)want->score);
+        failures++;
+    }
+}
+
+static void _judgeMode(GameMode *mode, Recording *recs, bool ran[JUDGE_KERNEL_COUNT])
+{
+    for (int r = 0; r < RECORDINGS; r++)
+    {
+        // Some start just under 2^32 ns so the high half carries mid game
+        uint64_t start = r % 3 == 0 ? 0xFFFFFFFFULL - _random(2000000000) : 1000000000ULL * r;
+        _generate(&recs[r], mode, start);
+    }
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        JudgeBatch batch;
+        if (!InitJudgeBatch(&batch, mode, RECORDINGS))
+        {
+            printf("FAIL: %s can't be judged in batches\n", mode->mode_name);
+            failures++;
+            return;
+        }
+
+        if (!SetJudgeKernel(&batch, (JudgeKernel)k))
+        {
+            DestroyJudgeBatch(&batch);
+            continue;
+        }
+        ran[k] = true;
+
+        uint8_t inputs[RECORDINGS + JUDGE_BATCH_ALIGN];
+        uint32_t lo[RECORDINGS + JUDGE_BATCH_ALIGN];
+        uint32_t hi[RECORDINGS + JUDGE_BATCH_ALIGN];
+
+        for (size_t s = 0; s < MAX_INPUTS; s++)
+        {
+            for (int l = 0; l < batch.lanes; l++)
+            {
+                const InputEvent *ev = l < RECORDINGS && s < recs[l].count ? &recs[l].events[s] : NULL;
+                inputs[l] = ev != NULL ? JudgeBatchInput(ev) : JUDGE_BATCH_IDLE;
+                lo[l] = ev != NULL ? (uint32_t)ev->timestamp_ns : 0;
+                hi[l] = ev != NULL ? (uint32_t)(ev->timestamp_ns >> 32) : 0;
+            }
+
+            JudgeBatchStep(&batch, inputs, lo, hi);
+        }
+
+        for (int l = 0; l < RECORDINGS; l++)
+        {
+            ReplaySummary summary;
+            JudgeBatchSummary(&batch, l, &summary);
+            _compare(mode->mode_name, (JudgeKernel)k, l, &summary, &recs[l].expected);
+        }
+
+        DestroyJudgeBatch(&batch);
+    }
+}
+
+int main()
+{
+    ModeRegistry modes;
+    if (!LoadModeRegistryFromMemory(&modes, MODES, sizeof(MODES) - 1, "judge_batch_test"))
+    {
+        printf("FAIL: test modes didn't load\n");
+        return 1;
+    }
+
+    Recording *recs = malloc(RECORDINGS * sizeof(Recording));
+    if (recs == NULL)
+    {
+        DestroyModeRegistry(&modes);
+        return 1;
+    }
+
+    bool ran[JUDGE_KERNEL_COUNT] = {0};
+    for (int m = 0; m < modes.count; m++)
+        _judgeMode(&modes.modes[m], recs, ran);
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+        printf("%s %s\n", JudgeKernelName((JudgeKernel)k), ran[k] ? "checked" : "not on this CPU, skipped");
+
+    free(recs);
+    DestroyModeRegistry(&modes);
+
+    if (failures > 0)
+        return 1;
+
+    printf("judge batch OK\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "judge_batch.h"
+#include "modes.h"
+#include "recording.h"
+#include "replay.h"
+
+// A recording with every direction byte a damaged file could hold goes
+// through the iterator and everything that judges what it hands out
+
+#define PATH "recording_test.kbdrec"
+
+static const char MODES[] =
+    "[modes]\n"
+    "KBD = (b n b db):1-3\n"
+    "[techniques]\n"
+    "Dash = f n f\n";
+
+static int failures = 0;
+
+static bool _writeRecording(const GameMode *mode)
+{
+    RecordingHeader header;
+    if (!InitRecordingHeader(&header, RECORDING_CLOCK_SIMULATED, 0, mode->mode_name,
+                             mode->pattern, mode->pattern_size, 1000000000ULL))
+        return false;
+
+    FILE *file = fopen(PATH, "wb");
+    if (file == NULL)
+        return false;
+
+    fwrite(&header, sizeof(header), 1, file);
+
+    // Every byte but RECORD_GAP, twice so the pattern gets a go either side
+    for (int round = 0; round < 2; round++)
+    {
+        for (int dir = 0; dir < RECORD_GAP; dir++)
+        {
+            RecordedInput rec = { 20000000, (uint8_t)dir, 0, 0 };
+            fwrite(&rec, sizeof(rec), 1, file);
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+static void _checkIterator(const RecordingReader *reader)
+{
+    RecordingIter it;
+    InputEvent ev;
+    int count = 0;
+
+    BeginRecordingIter(reader, &it);
+    while (NextRecordedInput(&it, &ev))
+    {
+        int written = count % RECORD_GAP;
+        int want = written < PATTERN_COLUMNS ? written : UNKNOWN;
+        if (ev.direction != want)
+        {
+            printf("FAIL: byte %d came out as direction %d, wanted %d\n", written, ev.direction, want);
+            failures++;
+        }
+        count++;
+    }
+
+    if (count != 2 * RECORD_GAP)
+    {
+        printf("FAIL: read %d inputs, wrote %d\n", count, 2 * RECORD_GAP);
+        failures++;
+    }
+}
+
+static void _checkJudges(GameMode *mode, Recognizer *practice, const RecordingReader *reader)
+{
+    Replay replay;
+    InitReplay(&replay, mode, 0);
+    ReplayRecording(&replay, reader, NULL);
+
+    if (replay.summary.inputs != 2 * RECORD_GAP)
+    {
+        printf("FAIL: replay judged %llu inputs\n", (unsigned long long)replay.summary.inputs);
+        failures++;
+    }
+
+    ResetRecognizer(practice);
+    ReplayPracticeRecording(practice, reader);
+
+    JudgeBatch batch;
+    if (!InitJudgeBatch(&batch, mode, 1))
+    {
+        printf("FAIL: %s can't be judged in batches\n", mode->mode_name);
+        failures++;
+        return;
+    }
+
+    for (int k = 0; k < JUDGE_KERNEL_COUNT; k++)
+    {
+        if (!SetJudgeKernel(&batch, (JudgeKernel)k))
+            continue;
+
+        ResetJudgeBatch(&batch);
+
+        RecordingIter it;
+        InputEvent ev;
+        BeginRecordingIter(reader, &it);
+        while (NextRecordedInput(&it, &ev))
+        {
+            uint8_t inputs[JUDGE_BATCH_ALIGN];
+            uint32_t lo[JUDGE_BATCH_ALIGN] = {0};
+            uint32_t hi[JUDGE_BATCH_ALIGN] = {0};
+
+            for (int l = 0; l < batch.lanes; l++)
+                inputs[l] = JUDGE_BATCH_IDLE;
+            inputs[0] = JudgeBatchInput(&ev);
+            lo[0] = (uint32_t)ev.timestamp_ns;
+            hi[0] = (uint32_t)(ev.timestamp_ns >> 32);
+
+            JudgeBatchStep(&batch, inputs, lo, hi);
+        }
+
+        ReplaySummary summary;
+        JudgeBatchSummary(&batch, 0, &summary);
+        if (summary.hits != replay.summary.hits || summary.misses != replay.summary.misses)
+        {
+            printf("FAIL: %s judged %llu hits %llu misses, replay has %llu %llu\n", JudgeKernelName((JudgeKernel)k),
+                   (unsigned long long)summary.hits, (unsigned long long)summary.misses,
+                   (unsigned long long)replay.summary.hits, (unsigned long long)replay.summary.misses);
+            failures++;
+        }
+    }
+
+    DestroyJudgeBatch(&batch);
+}
+
+int main()
+{
+    ModeRegistry modes;
+    if (!LoadModeRegistryFromMemory(&modes, MODES, sizeof(MODES) - 1, "recording_test"))
+    {
+        printf("FAIL: test modes didn't load\n");
+        return 1;
+    }
+
+    GameMode *mode = &modes.modes[0];
+    if (!_writeRecording(mode))
+    {
+        printf("FAIL: couldn't write %s\n", PATH);
+        DestroyModeRegistry(&modes);
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!OpenRecordingReader(&reader, PATH))
+    {
+        printf("FAIL: couldn't read %s back\n", PATH);
+        DestroyModeRegistry(&modes);
+        return 1;
+    }
+
+    _checkIterator(&reader);
+    _checkJudges(mode, modes.practice, &reader);
+
+    CloseRecordingReader(&reader);
+    DestroyModeRegistry(&modes);
+    remove(PATH);
+
+    if (failures > 0)
+        return 1;
+
+    printf("recording OK\n");
+    return 0;
+}
@@ -9,10 +9,13 @@ class GameEngine {
     // Constants
     static SCORE_PER_INPUT = 50;
     static MISS_PAUSE_SECONDS = 2;
-    static MISS_PAUSE_INTERVAL = 100;
-    static MISS_PAUSE_DECREMENT = 0.1;
 
-    constructor() {
+    // now() returns milliseconds on the same base as performance.now() and
+    // event.timeStamp. Tests can pass their own to step through a miss
+    // pause without waiting for it.
+    constructor(now = () => performance.now()) {
+        this.now = now;
+
         // Game modes - exact replica of original C code
         this.modes = {
             0: {
@@ -49,7 +52,7 @@ class GameEngine {
         this.missTime = 0;
         this.inMissPause = false;
         this.missCountdown = 0; // Countdown timer for miss pause
-        this._missPauseTimer = null;
+        this.missPauseEnd = 0; // now() the miss pause runs out at
         
         // Enhanced stats tracking
         this.totalInputs = 0;
@@ -100,23 +103,57 @@ class GameEngine {
     stopGame() {
         this.highscores[this.selectedMode] = this.highscore;
         this.runGame = false;
-        this.clearMissPauseTimer();
+        this.inMissPause = false;
+        this.missCountdown = 0;
     }
     
-    update(direction) {
+    // timestamp is when the input happened, an event's timeStamp or now()
+    update(direction, timestamp = this.now()) {
         if (this.runGame) {
             if (direction) {
-                this.updateGame(direction);
+                this.updateGame(direction, timestamp);
             }
         } else {
             this.updateMenu(direction);
         }
     }
     
-    // Simplified game state update (no longer needs continuous miss pause countdown)
-    updateGameState() {
-        // This method is now primarily for UI controller calls
-        // Miss pause is handled by setTimeout in updateGame()
+    // Called by the UI every update, refreshes the countdown and ends the
+    // miss pause once its deadline has passed
+    updateGameState(timestamp = this.now()) {
+        this.isInMissPause(timestamp);
+    }
+    
+    // Miss pause expires against the clock, nothing has to be scheduled
+    isInMissPause(timestamp = this.now()) {
+        if (!this.inMissPause) return false;
+        
+        const remaining = this.missPauseEnd - timestamp;
+        if (remaining > 0) {
+            this.missCountdown = remaining / 1000;
+            return true;
+        }
+        
+        this.endMissPause();
+        return false;
+    }
+    
+    endMissPause() {
+        this.playerPos = 0;
+        this.score = 0; // Reset score to 0 as per original C logic
+        this.lastInputAcc = 'none';
+        this.inMissPause = false;
+        this.missCountdown = 0;
+        this.prevDirection = 'neutral';
+        this.lastInput = 'neutral';
+        // Reset input handler state
+        if (this.inputHandler) {
+            this.inputHandler.resetInputState();
+        }
+        // Clear all UI state and force updates
+        if (this.uiController) {
+            this.uiController.updateUI();
+        }
     }
     
     updateMenu(direction) {
@@ -139,11 +176,12 @@ class GameEngine {
         }
     }
     
-    updateGame(direction) {
+    updateGame(direction, timestamp = this.now()) {
         this.currInput = direction;
         
-        // Don't process new input during miss pause
-        if (this.inMissPause) {
+        // Don't process new input during miss pause, one that arrives after
+        // it ran out ends it and is judged from a fresh start
+        if (this.isInMissPause(timestamp)) {
             return;
         }
         
@@ -155,36 +193,11 @@ class GameEngine {
         
         // Check if we just had a failed input and need to start miss pause
         if (this.lastInputAcc === 'fail') {
-            // Start miss pause timer
+            // Start miss pause, it runs out at a deadline on the clock
             this.inMissPause = true;
             this.missCountdown = GameEngine.MISS_PAUSE_SECONDS;
+            this.missPauseEnd = timestamp + GameEngine.MISS_PAUSE_SECONDS * 1000;
             this.lastInputAcc = 'none'; // Clear immediately to prevent UI failure state during pause
-            this.clearMissPauseTimer();
-            this._missPauseTimer = setInterval(() => {
-                if (this.inMissPause) {
-                    this.missCountdown -= GameEngine.MISS_PAUSE_DECREMENT;
-                    if (this.missCountdown <= 0) {
-                        this.clearMissPauseTimer();
-                        this.playerPos = 0;
-                        this.score = 0; // Reset score to 0 as per original C logic
-                        this.lastInputAcc = 'none';
-                        this.inMissPause = false;
-                        this.missCountdown = 0;
-                        this.prevDirection = 'neutral';
-                        this.lastInput = 'neutral';
-                        // Reset input handler state
-                        if (this.inputHandler) {
-                            this.inputHandler.resetInputState();
-                        }
-                        // Clear all UI state and force updates
-                        if (this.uiController) {
-                            this.uiController.updateUI();
-                        }
-                    }
-                } else {
-                    this.clearMissPauseTimer();
-                }
-            }, GameEngine.MISS_PAUSE_INTERVAL);
             return;
         }
         
@@ -299,12 +312,4 @@ class GameEngine {
         if (!this.runGame) return 'menu';
         return 'playing';
     }
-    
-    // Clear miss pause timer
-    clearMissPauseTimer() {
-        if (this._missPauseTimer) {
-            clearInterval(this._missPauseTimer);
-            this._missPauseTimer = null;
-        }
-    }
 }
@@ -41,13 +41,13 @@ class InputHandler {
             this.startGamepadPolling();
         }
         
-        // Continuously check game state for miss pause timeout
+        // Redraw the miss pause countdown, the pause itself ends on the
+        // engine's clock whether this runs or not
         setInterval(() => {
-            // During miss pause, keep calling update to check timeout
             if (this.gameEngine.inMissPause) {
-                this.gameEngine.update(this.gameEngine.currInput || 'neutral');
+                this.updateUI();
             }
-        }, 50); // Check every 50ms during miss pause
+        }, 100);
     }
     
     handleKeydown(event) {
@@ -55,7 +55,7 @@ class InputHandler {
         if (event.repeat) return;
         
         // Block all input during miss pause
-        if (this.gameEngine.inMissPause) {
+        if (this.gameEngine.isInMissPause(event.timeStamp)) {
             event.preventDefault();
             return;
         }
@@ -122,7 +122,7 @@ class InputHandler {
     
     handleKeyup(event) {
         // Block all input during miss pause
-        if (this.gameEngine.inMissPause) {
+        if (this.gameEngine.isInMissPause(event.timeStamp)) {
             event.preventDefault();
             return;
         }
@@ -236,7 +236,7 @@ class InputHandler {
     
     handleGamepad() {
         // Block gamepad input during miss pause
-        if (this.gameEngine.inMissPause) {
+        if (this.gameEngine.isInMissPause()) {
             return;
         }
         